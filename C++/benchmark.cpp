@@ -0,0 +1,363 @@
+#include "cpptensor/tensor.hpp"
+#include "cpptensor/utils.hpp"
+#include "cpptensor/functional.hpp"
+#include "cpptensor/expression.hpp"
+#include "cpptensor/parallel.hpp"
+#include "cpptensor/cpu_features.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Micro-benchmarks of the core ops, timed in-process without any binding overhead.
+//
+//   cpptensor_benchmark [--filter TEXT] [--repeat N] [--warmup N] [--sample-ms MS]
+//                       [--out FILE] [--compare BASELINE] [--threshold FRACTION]
+//
+// Each benchmark is warmed up, then timed. Ops of at least a microsecond are timed one call per
+// sample, over at least 100 samples or `repeat` * sample-ms, so p99 is a tail latency. Shorter
+// ops are timed in `repeat` samples of enough iterations to last about sample-ms, whose p99 would
+// only be a batch mean, so it is null. The per-iteration median, min, mean and slowest sample are
+// always reported. Results are written as JSON (to stdout or --out). --compare reads a previous
+// JSON output and exits with status 2 when a median got slower than the baseline by more than
+// the threshold.
+
+namespace {
+
+struct Options {
+    std::string filter;
+    int repeat = 30;
+    int warmup = 3;
+    double sample_ms = 2.0;
+    std::string out;
+    std::string compare;
+    double threshold = 0.10;
+};
+
+struct Benchmark {
+    std::string name;                 // op/dtype/shape/layout
+    std::function<void()> run;
+};
+
+struct Result {
+    std::string name;
+    size_t iterations;                // Per sample
+    size_t samples;
+    bool single_calls;                // One call per sample: p99 is a tail latency
+    double median_ns, p99_ns, min_ns, mean_ns, max_sample_ns;
+};
+
+// Ops at least this long are timed one call per sample, well above the clock resolution
+const double SINGLE_CALL_MIN_NS = 1000.0;
+// Samples of single calls taken at least, so that p99 is not just the slowest one
+const size_t MIN_TAIL_SAMPLES = 100;
+
+// Keeps the results of the timed calls alive so they cannot be optimized away
+const void* volatile sink;
+
+template<typename T>
+void consume(const Tensor<T>& t) {
+    sink = t.data.get();
+}
+
+template<typename T>
+Tensor<T> random_tensor(const Dims& shape) {
+    Tensor<T> t = Tensor<T>::empty(shape);
+    uint32_t state = 12345;
+    for (size_t i = 0; i < t.numel; i++) {
+        state = state * 1664525u + 1013904223u;
+        t.data[i] = static_cast<T>(static_cast<float32>(state >> 24) / 16.0f);   // Small values, exact in every dtype
+    }
+    return t;
+}
+
+template<typename T>
+std::string dtype_name() {
+    return dtype_to_str(get_dtype<T>());
+}
+
+std::string shape_name(const Dims& shape) {
+    std::string name;
+    for (size_t i = 0; i < shape.size(); i++) name += (i ? "x" : "") + std::to_string(shape[i]);
+    return name;
+}
+
+const std::vector<Dims> ELEMENTWISE_SHAPES = {{16}, {64, 64}, {512, 512}, {2048, 2048}};
+const std::vector<int> MATMUL_SIZES = {4, 16, 64, 256, 1024};
+
+template<typename T>
+void add_elementwise(std::vector<Benchmark>& benchmarks) {
+    const std::string dtype = dtype_name<T>();
+    for (const auto& shape : ELEMENTWISE_SHAPES) {
+        const std::string suffix = "/" + dtype + "/" + shape_name(shape);
+        Tensor<T> a = random_tensor<T>(shape), b = random_tensor<T>(shape);
+
+        benchmarks.push_back({"add" + suffix + "/contiguous", [=] { consume(a + b); }});
+        benchmarks.push_back({"mul" + suffix + "/contiguous", [=] { consume(a * b); }});
+        benchmarks.push_back({"add_scalar" + suffix + "/contiguous", [=] { consume(a + 2.0); }});
+        benchmarks.push_back({"mul_scalar" + suffix + "/contiguous", [=] { consume(a * 2.0); }});
+        // a * 2 + b fused in one pass into a preallocated result
+        Tensor<T> out = Tensor<T>::empty(shape);
+        benchmarks.push_back({"expr_fma" + suffix + "/contiguous", [=] {
+            expr::assign(out, expr::lazy(a) * 2.0 + b);
+            consume(out);
+        }});
+
+        if (shape.size() == 2) {
+            // Row vector broadcast over the rows, and a transposed (strided) operand
+            Tensor<T> row = random_tensor<T>({1, shape[1]});
+            Tensor<T> at = random_tensor<T>({shape[1], shape[0]}).transpose();
+            benchmarks.push_back({"add" + suffix + "/broadcast", [=] { consume(a + row); }});
+            benchmarks.push_back({"add" + suffix + "/strided", [=] { consume(at + b); }});
+            benchmarks.push_back({"add_scalar" + suffix + "/strided", [=] { consume(at + 2.0); }});
+        }
+    }
+}
+
+template<typename T, typename U>
+void add_conversion(std::vector<Benchmark>& benchmarks, const Dims& shape) {
+    Tensor<T> a = random_tensor<T>(shape);
+    const std::string name = "to/" + dtype_name<T>() + "->" + dtype_name<U>() + "/" + shape_name(shape);
+    benchmarks.push_back({name + "/contiguous", [=] { consume(a.template to<U>()); }});
+}
+
+template<typename T>
+void add_conversions(std::vector<Benchmark>& benchmarks) {
+    for (const auto& shape : {Dims{64, 64}, Dims{2048, 2048}}) {
+        if (!std::is_same_v<T, uint8>) add_conversion<T, uint8>(benchmarks, shape);
+        if (!std::is_same_v<T, int32>) add_conversion<T, int32>(benchmarks, shape);
+        if (!std::is_same_v<T, float32>) add_conversion<T, float32>(benchmarks, shape);
+        if (!std::is_same_v<T, float16>) add_conversion<T, float16>(benchmarks, shape);
+        if (!std::is_same_v<T, bfloat16>) add_conversion<T, bfloat16>(benchmarks, shape);
+    }
+}
+
+template<typename T>
+void add_matmul(std::vector<Benchmark>& benchmarks) {
+    const std::string dtype = dtype_name<T>();
+    for (int n : MATMUL_SIZES) {
+        // The largest size only for the main dtypes, to keep a full run short
+        if (n > 256 && !std::is_same_v<T, float32> && !std::is_same_v<T, int32>) continue;
+        Tensor<T> a = random_tensor<T>({n, n}), b = random_tensor<T>({n, n});
+        const std::string suffix = "/" + dtype + "/" + shape_name({n, n, n});
+        benchmarks.push_back({"matmul" + suffix + "/contiguous", [=] { consume(F::matmul(a, b)); }});
+        benchmarks.push_back({"matmul" + suffix + "/strided", [=] { consume(F::matmul(a.transpose(), b)); }});
+    }
+    // Batched, with the right operand broadcast over the batch
+    Tensor<T> batch = random_tensor<T>({32, 64, 64}), rhs = random_tensor<T>({64, 64});
+    benchmarks.push_back({"matmul/" + dtype + "/32x64x64x64/broadcast", [=] { consume(F::matmul(batch, rhs)); }});
+}
+
+template<typename T>
+void add_views(std::vector<Benchmark>& benchmarks) {
+    const std::string dtype = dtype_name<T>();
+    for (const auto& shape : {Dims{16}, Dims{2048, 2048}}) {
+        Tensor<T> a = random_tensor<T>(shape);
+        int numel = static_cast<int>(a.numel);
+        const std::string suffix = "/" + dtype + "/" + shape_name(shape);
+        benchmarks.push_back({"view" + suffix + "/contiguous", [=] { consume(a.view({numel})); }});
+        benchmarks.push_back({"expand" + suffix + "/contiguous", [=] {
+            Dims expanded = a.shape;
+            expanded.insert(expanded.begin(), 8);
+            consume(a.expand(expanded));
+        }});
+        if (shape.size() == 2) {
+            benchmarks.push_back({"contiguous" + suffix + "/strided", [=] { consume(a.transpose().contiguous()); }});
+        }
+    }
+}
+
+template<typename T>
+void add_dtype(std::vector<Benchmark>& benchmarks) {
+    add_elementwise<T>(benchmarks);
+    add_matmul<T>(benchmarks);
+    add_conversions<T>(benchmarks);
+    add_views<T>(benchmarks);
+}
+
+std::vector<Benchmark> all_benchmarks() {
+    std::vector<Benchmark> benchmarks;
+    add_dtype<uint8>(benchmarks);
+    add_dtype<int32>(benchmarks);
+    add_dtype<float32>(benchmarks);
+    add_dtype<float16>(benchmarks);
+    add_dtype<bfloat16>(benchmarks);
+    return benchmarks;
+}
+
+double elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+Result measure(const Benchmark& benchmark, const Options& options) {
+    for (int i = 0; i < options.warmup; i++) benchmark.run();
+
+    auto start = std::chrono::steady_clock::now();
+    benchmark.run();
+    double once_ns = std::max(elapsed_ns(start), 1.0);
+    size_t iterations = 1;
+    size_t count = static_cast<size_t>(options.repeat);
+    bool single_calls = once_ns >= SINGLE_CALL_MIN_NS;
+    if (single_calls) {
+        // As many single calls as fit in the time of the batched samples, and enough for p99
+        double budget_ns = options.repeat * options.sample_ms * 1e6;
+        count = std::max({count, MIN_TAIL_SAMPLES, static_cast<size_t>(budget_ns / once_ns)});
+    } else {
+        // Enough iterations per sample to measure short ops above the clock resolution
+        iterations = std::max<size_t>(1, static_cast<size_t>(options.sample_ms * 1e6 / once_ns));
+    }
+
+    std::vector<double> samples;
+    samples.reserve(count);
+    for (size_t r = 0; r < count; r++) {
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) benchmark.run();
+        samples.push_back(elapsed_ns(start) / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.samples = samples.size();
+    result.single_calls = single_calls;
+    result.median_ns = percentile(samples, 0.5);
+    result.p99_ns = percentile(samples, 0.99);
+    result.min_ns = samples.front();
+    result.max_sample_ns = samples.back();
+    double total = 0.0;
+    for (double s : samples) total += s;
+    result.mean_ns = total / samples.size();
+    return result;
+}
+
+// One benchmark per line, so that baselines can be read back without a JSON library
+void write_json(std::ostream& os, const std::vector<Result>& results, const Options& options) {
+    os << std::fixed << std::setprecision(1);
+    os << "{\n";
+    os << "  \"simd_level\": \"" << cpu::simd_level_to_str(cpu::simd_level()) << "\",\n";
+    os << "  \"num_threads\": " << parallel::get_num_threads() << ",\n";
+    os << "  \"repeat\": " << options.repeat << ",\n";
+    os << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        os << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations << ", \"samples\": " << r.samples
+           << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": ";
+        if (r.single_calls) os << r.p99_ns;
+        else os << "null";
+        os << ", \"min_ns\": " << r.min_ns << ", \"mean_ns\": " << r.mean_ns << ", \"max_sample_ns\": " << r.max_sample_ns << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+// Value of "key": in a line written by write_json
+std::string json_field(const std::string& line, const std::string& key) {
+    std::string pattern = "\"" + key + "\": ";
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) return "";
+    pos += pattern.size();
+    if (line[pos] == '"') {
+        size_t end = line.find('"', pos + 1);
+        return line.substr(pos + 1, end - pos - 1);
+    }
+    size_t end = line.find_first_of(",}", pos);
+    return line.substr(pos, end - pos);
+}
+
+std::map<std::string, double> read_baseline(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Cannot open baseline " + path);
+    std::map<std::string, double> medians;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string name = json_field(line, "name");
+        std::string median = json_field(line, "median_ns");
+        if (!name.empty() && !median.empty()) medians[name] = std::stod(median);
+    }
+    return medians;
+}
+
+// Prints the change of every benchmark found in the baseline, returns the number of regressions
+int compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline, double threshold) {
+    int regressions = 0;
+    std::cerr << std::fixed << std::setprecision(1);
+    for (const Result& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end()) continue;
+        double change = r.median_ns / it->second - 1.0;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        std::cerr << (regressed ? "REGRESSION " : "           ") << std::setw(60) << std::left << r.name
+                  << std::right << std::setw(14) << it->second << " ns -> " << std::setw(14) << r.median_ns
+                  << " ns (" << std::showpos << change * 100.0 << std::noshowpos << "%)\n";
+    }
+    std::cerr << regressions << " regression(s) above " << threshold * 100.0 << "%\n";
+    return regressions;
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--filter") options.filter = value();
+        else if (arg == "--repeat") options.repeat = std::max(1, std::stoi(value()));
+        else if (arg == "--warmup") options.warmup = std::max(0, std::stoi(value()));
+        else if (arg == "--sample-ms") options.sample_ms = std::stod(value());
+        else if (arg == "--out") options.out = value();
+        else if (arg == "--compare") options.compare = value();
+        else if (arg == "--threshold") options.threshold = std::stod(value());
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parse_options(argc, argv);
+        std::map<std::string, double> baseline;
+        if (!options.compare.empty()) baseline = read_baseline(options.compare);
+
+        std::vector<Result> results;
+        for (const Benchmark& benchmark : all_benchmarks()) {
+            if (benchmark.name.find(options.filter) == std::string::npos) continue;
+            results.push_back(measure(benchmark, options));
+            std::cerr << std::fixed << std::setprecision(1) << std::setw(60) << std::left << benchmark.name
+                      << std::right << std::setw(14) << results.back().median_ns << " ns\n";
+        }
+
+        if (options.out.empty()) {
+            write_json(std::cout, results, options);
+        } else {
+            std::ofstream file(options.out);
+            write_json(file, results, options);
+        }
+
+        if (!options.compare.empty() && compare(results, baseline, options.threshold) > 0) return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "[!] Exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -2,8 +2,9 @@
 pybind11 plugin for Tensor class
 """
 from __future__ import annotations
+import numpy
 import typing
-__all__ = ['DataType', 'TensorFloat32', 'TensorInt32', 'TensorUInt8', 'full', 'ones', 'zeros']
+__all__ = ['DataType', 'FileTensor', 'GraphBFloat16', 'GraphFloat16', 'GraphFloat32', 'GraphInt32', 'GraphUInt8', 'QuantParams', 'TensorBFloat16', 'TensorFloat16', 'TensorFloat32', 'TensorInt32', 'TensorUInt8', 'add', 'clear_profiler', 'empty_cache', 'export_chrome_trace', 'from_numpy', 'full', 'get_num_threads', 'is_profiler_enabled', 'load', 'matmul', 'memory_stats', 'mul', 'ones', 'profiler_events', 'profiler_summary', 'quantized_matmul', 'save', 'set_num_threads', 'set_profiler_enabled', 'simd_level', 'zeros']
 class DataType:
     """
     Members:
@@ -13,11 +14,17 @@ class DataType:
       INT32
     
       FLOAT32
+    
+      FLOAT16
+    
+      BFLOAT16
     """
+    BFLOAT16: typing.ClassVar[DataType]  # value = <DataType.BFLOAT16: 4>
+    FLOAT16: typing.ClassVar[DataType]  # value = <DataType.FLOAT16: 3>
     FLOAT32: typing.ClassVar[DataType]  # value = <DataType.FLOAT32: 2>
     INT32: typing.ClassVar[DataType]  # value = <DataType.INT32: 1>
     UINT8: typing.ClassVar[DataType]  # value = <DataType.UINT8: 0>
-    __members__: typing.ClassVar[dict[str, DataType]]  # value = {'UINT8': <DataType.UINT8: 0>, 'INT32': <DataType.INT32: 1>, 'FLOAT32': <DataType.FLOAT32: 2>}
+    __members__: typing.ClassVar[dict[str, DataType]]  # value = {'UINT8': <DataType.UINT8: 0>, 'INT32': <DataType.INT32: 1>, 'FLOAT32': <DataType.FLOAT32: 2>, 'FLOAT16': <DataType.FLOAT16: 3>, 'BFLOAT16': <DataType.BFLOAT16: 4>}
     @staticmethod
     def _pybind11_conduit_v1_(*args, **kwargs):
         ...
@@ -47,6 +54,436 @@ class DataType:
     @property
     def value(self) -> int:
         ...
+class FileTensor:
+    @staticmethod
+    def create(path: str, name: str, shape: list[int], dtype: DataType) -> FileTensor:
+        """
+        Create a file holding one zero-filled tensor, e.g. the output of a streamed op
+        """
+    @staticmethod
+    def open(path: str, name: str) -> FileTensor:
+        """
+        Open a tensor of a tensor file for streamed ops
+        """
+    def add(self, other: FileTensor, out: FileTensor, chunk_bytes: int = 67108864) -> None:
+        """
+        Write self + other to out, streaming blocks of rows
+        """
+    def matmul(self, other: typing.Any, out: FileTensor, chunk_bytes: int = 67108864) -> None:
+        """
+        Write self @ other to out for an in-memory other, streaming blocks of rows
+        """
+    def max(self, chunk_bytes: int = 67108864) -> typing.Any:
+        """
+        Largest element, streaming blocks of rows
+        """
+    def mean(self, chunk_bytes: int = 67108864) -> typing.Any:
+        """
+        Mean of all the elements, streaming blocks of rows
+        """
+    def min(self, chunk_bytes: int = 67108864) -> typing.Any:
+        """
+        Smallest element, streaming blocks of rows
+        """
+    def mul(self, other: FileTensor, out: FileTensor, chunk_bytes: int = 67108864) -> None:
+        """
+        Write self * other to out, streaming blocks of rows
+        """
+    def sum(self, chunk_bytes: int = 67108864) -> typing.Any:
+        """
+        Sum of all the elements, streaming blocks of rows
+        """
+    @property
+    def dtype(self) -> DataType:
+        ...
+    @property
+    def shape(self) -> list[int]:
+        ...
+class GraphBFloat16:
+    @staticmethod
+    def capture(fn: typing.Callable[..., typing.Any], inputs: list[TensorBFloat16]) -> GraphBFloat16:
+        """
+        Call fn(*inputs) once, recording its add, mul and matmul ops into a graph
+        """
+    def run(self, inputs: list[TensorBFloat16]) -> list[TensorBFloat16]:
+        """
+        Replay the graph on new inputs of the captured shapes, returning its outputs. Outputs held in the graph's arena are overwritten by the next run: copy them, e.g. with numpy.array(), to keep them. Concurrent runs of one graph wait for each other
+        """
+    @property
+    def arena_bytes(self) -> int:
+        ...
+    @property
+    def num_ops(self) -> int:
+        ...
+class GraphFloat16:
+    @staticmethod
+    def capture(fn: typing.Callable[..., typing.Any], inputs: list[TensorFloat16]) -> GraphFloat16:
+        """
+        Call fn(*inputs) once, recording its add, mul and matmul ops into a graph
+        """
+    def run(self, inputs: list[TensorFloat16]) -> list[TensorFloat16]:
+        """
+        Replay the graph on new inputs of the captured shapes, returning its outputs. Outputs held in the graph's arena are overwritten by the next run: copy them, e.g. with numpy.array(), to keep them. Concurrent runs of one graph wait for each other
+        """
+    @property
+    def arena_bytes(self) -> int:
+        ...
+    @property
+    def num_ops(self) -> int:
+        ...
+class GraphFloat32:
+    @staticmethod
+    def capture(fn: typing.Callable[..., typing.Any], inputs: list[TensorFloat32]) -> GraphFloat32:
+        """
+        Call fn(*inputs) once, recording its add, mul and matmul ops into a graph
+        """
+    def run(self, inputs: list[TensorFloat32]) -> list[TensorFloat32]:
+        """
+        Replay the graph on new inputs of the captured shapes, returning its outputs. Outputs held in the graph's arena are overwritten by the next run: copy them, e.g. with numpy.array(), to keep them. Concurrent runs of one graph wait for each other
+        """
+    @property
+    def arena_bytes(self) -> int:
+        ...
+    @property
+    def num_ops(self) -> int:
+        ...
+class GraphInt32:
+    @staticmethod
+    def capture(fn: typing.Callable[..., typing.Any], inputs: list[TensorInt32]) -> GraphInt32:
+        """
+        Call fn(*inputs) once, recording its add, mul and matmul ops into a graph
+        """
+    def run(self, inputs: list[TensorInt32]) -> list[TensorInt32]:
+        """
+        Replay the graph on new inputs of the captured shapes, returning its outputs. Outputs held in the graph's arena are overwritten by the next run: copy them, e.g. with numpy.array(), to keep them. Concurrent runs of one graph wait for each other
+        """
+    @property
+    def arena_bytes(self) -> int:
+        ...
+    @property
+    def num_ops(self) -> int:
+        ...
+class GraphUInt8:
+    @staticmethod
+    def capture(fn: typing.Callable[..., typing.Any], inputs: list[TensorUInt8]) -> GraphUInt8:
+        """
+        Call fn(*inputs) once, recording its add, mul and matmul ops into a graph
+        """
+    def run(self, inputs: list[TensorUInt8]) -> list[TensorUInt8]:
+        """
+        Replay the graph on new inputs of the captured shapes, returning its outputs. Outputs held in the graph's arena are overwritten by the next run: copy them, e.g. with numpy.array(), to keep them. Concurrent runs of one graph wait for each other
+        """
+    @property
+    def arena_bytes(self) -> int:
+        ...
+    @property
+    def num_ops(self) -> int:
+        ...
+class QuantParams:
+    scale: float
+    zero_point: int
+    def __init__(self, scale: float = 1.0, zero_point: int = 0) -> None:
+        ...
+    def __repr__(self) -> str:
+        ...
+class TensorBFloat16:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @staticmethod
+    def empty(arg0: list[int]) -> TensorBFloat16:
+        ...
+    @staticmethod
+    def from_numpy(array: numpy.ndarray) -> TensorBFloat16:
+        """
+        Tensor sharing the memory of a NumPy array
+        """
+    @staticmethod
+    def full(arg0: list[int], arg1: float) -> TensorBFloat16:
+        ...
+    @staticmethod
+    def matmul(arg0: TensorBFloat16, arg1: TensorBFloat16) -> TensorBFloat16:
+        ...
+    @staticmethod
+    def ones(arg0: list[int]) -> TensorBFloat16:
+        ...
+    @staticmethod
+    def zeros(arg0: list[int]) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __add__(self, arg0: TensorBFloat16) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __add__(self, arg0: float) -> TensorBFloat16:
+        ...
+    def __array__(self, dtype: typing.Any = None, copy: typing.Any = None) -> numpy.ndarray:
+        ...
+    def __getitem__(self, arg0: typing.Any) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __iadd__(self, arg0: TensorBFloat16) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __iadd__(self, arg0: float) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __imul__(self, arg0: TensorBFloat16) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __imul__(self, arg0: float) -> TensorBFloat16:
+        ...
+    def __init__(self) -> None:
+        ...
+    def __matmul__(self, arg0: TensorBFloat16) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __mul__(self, arg0: TensorBFloat16) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def __mul__(self, arg0: float) -> TensorBFloat16:
+        ...
+    def __repr__(self) -> str:
+        ...
+    @typing.overload
+    def argmax(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def argmax(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    def broadcast_to(self, arg0: list[int]) -> TensorBFloat16:
+        ...
+    def contiguous(self) -> TensorBFloat16:
+        ...
+    def expand(self, arg0: list[int]) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def max(self, dims: list[int] = [], keepdim: bool = False) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def max(self, dim: int, keepdim: bool = False) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def mean(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def mean(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def min(self, dims: list[int] = [], keepdim: bool = False) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def min(self, dim: int, keepdim: bool = False) -> TensorBFloat16:
+        ...
+    def narrow(self, dim: int, start: int, length: int) -> TensorBFloat16:
+        ...
+    def numpy(self) -> numpy.ndarray:
+        """
+        NumPy array sharing the tensor data (a float32 copy for bfloat16)
+        """
+    def permute(self, dims: list[int]) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def prod(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def prod(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    def select(self, dim: int, index: int) -> TensorBFloat16:
+        ...
+    def squeeze(self, arg0: list[int]) -> TensorBFloat16:
+        ...
+    @typing.overload
+    def sum(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def sum(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    def to(self, dtype: DataType, scale: float = 1.0, shift: float = 0.0) -> typing.Any:
+        """
+        Copy of the tensor converted to dtype as dtype(x * scale + shift), truncating floats toward zero and saturating for integer dtypes (int32 to uint8 without scale or shift wraps)
+        """
+    def transpose(self, dim0: int, dim1: int) -> TensorBFloat16:
+        ...
+    def unsqueeze(self, arg0: list[int]) -> TensorBFloat16:
+        ...
+    def view(self, arg0: list[int]) -> TensorBFloat16:
+        ...
+    @property
+    def T(self) -> TensorBFloat16:
+        ...
+    @property
+    def dtype(self) -> DataType:
+        ...
+    @property
+    def has_broadcast(self) -> bool:
+        ...
+    @property
+    def is_contiguous(self) -> bool:
+        ...
+    @property
+    def is_dense(self) -> bool:
+        ...
+    @property
+    def ndim(self) -> int:
+        ...
+    @property
+    def numel(self) -> int:
+        ...
+    @property
+    def shape(self) -> list[int]:
+        ...
+    @property
+    def strides(self) -> list[int]:
+        ...
+class TensorFloat16:
+    @staticmethod
+    def _pybind11_conduit_v1_(*args, **kwargs):
+        ...
+    @staticmethod
+    def empty(arg0: list[int]) -> TensorFloat16:
+        ...
+    @staticmethod
+    def from_numpy(array: numpy.ndarray) -> TensorFloat16:
+        """
+        Tensor sharing the memory of a NumPy array
+        """
+    @staticmethod
+    def full(arg0: list[int], arg1: float) -> TensorFloat16:
+        ...
+    @staticmethod
+    def matmul(arg0: TensorFloat16, arg1: TensorFloat16) -> TensorFloat16:
+        ...
+    @staticmethod
+    def ones(arg0: list[int]) -> TensorFloat16:
+        ...
+    @staticmethod
+    def zeros(arg0: list[int]) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __add__(self, arg0: TensorFloat16) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __add__(self, arg0: float) -> TensorFloat16:
+        ...
+    def __array__(self, dtype: typing.Any = None, copy: typing.Any = None) -> numpy.ndarray:
+        ...
+    def __getitem__(self, arg0: typing.Any) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __iadd__(self, arg0: TensorFloat16) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __iadd__(self, arg0: float) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __imul__(self, arg0: TensorFloat16) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __imul__(self, arg0: float) -> TensorFloat16:
+        ...
+    def __init__(self) -> None:
+        ...
+    def __matmul__(self, arg0: TensorFloat16) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __mul__(self, arg0: TensorFloat16) -> TensorFloat16:
+        ...
+    @typing.overload
+    def __mul__(self, arg0: float) -> TensorFloat16:
+        ...
+    def __repr__(self) -> str:
+        ...
+    @typing.overload
+    def argmax(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def argmax(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    def broadcast_to(self, arg0: list[int]) -> TensorFloat16:
+        ...
+    def contiguous(self) -> TensorFloat16:
+        ...
+    def expand(self, arg0: list[int]) -> TensorFloat16:
+        ...
+    @typing.overload
+    def max(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat16:
+        ...
+    @typing.overload
+    def max(self, dim: int, keepdim: bool = False) -> TensorFloat16:
+        ...
+    @typing.overload
+    def mean(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def mean(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def min(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat16:
+        ...
+    @typing.overload
+    def min(self, dim: int, keepdim: bool = False) -> TensorFloat16:
+        ...
+    def narrow(self, dim: int, start: int, length: int) -> TensorFloat16:
+        ...
+    def numpy(self) -> numpy.ndarray:
+        """
+        NumPy array sharing the tensor data (a float32 copy for bfloat16)
+        """
+    def permute(self, dims: list[int]) -> TensorFloat16:
+        ...
+    @typing.overload
+    def prod(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def prod(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    def select(self, dim: int, index: int) -> TensorFloat16:
+        ...
+    def squeeze(self, arg0: list[int]) -> TensorFloat16:
+        ...
+    @typing.overload
+    def sum(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def sum(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    def to(self, dtype: DataType, scale: float = 1.0, shift: float = 0.0) -> typing.Any:
+        """
+        Copy of the tensor converted to dtype as dtype(x * scale + shift), truncating floats toward zero and saturating for integer dtypes (int32 to uint8 without scale or shift wraps)
+        """
+    def transpose(self, dim0: int, dim1: int) -> TensorFloat16:
+        ...
+    def unsqueeze(self, arg0: list[int]) -> TensorFloat16:
+        ...
+    def view(self, arg0: list[int]) -> TensorFloat16:
+        ...
+    @property
+    def T(self) -> TensorFloat16:
+        ...
+    @property
+    def dtype(self) -> DataType:
+        ...
+    @property
+    def has_broadcast(self) -> bool:
+        ...
+    @property
+    def is_contiguous(self) -> bool:
+        ...
+    @property
+    def is_dense(self) -> bool:
+        ...
+    @property
+    def ndim(self) -> int:
+        ...
+    @property
+    def numel(self) -> int:
+        ...
+    @property
+    def shape(self) -> list[int]:
+        ...
+    @property
+    def strides(self) -> list[int]:
+        ...
 class TensorFloat32:
     @staticmethod
     def _pybind11_conduit_v1_(*args, **kwargs):
@@ -55,6 +492,11 @@ class TensorFloat32:
     def empty(arg0: list[int]) -> TensorFloat32:
         ...
     @staticmethod
+    def from_numpy(array: numpy.ndarray) -> TensorFloat32:
+        """
+        Tensor sharing the memory of a NumPy array
+        """
+    @staticmethod
     def full(arg0: list[int], arg1: float) -> TensorFloat32:
         ...
     @staticmethod
@@ -72,6 +514,10 @@ class TensorFloat32:
     @typing.overload
     def __add__(self, arg0: float) -> TensorFloat32:
         ...
+    def __array__(self, dtype: typing.Any = None, copy: typing.Any = None) -> numpy.ndarray:
+        ...
+    def __getitem__(self, arg0: typing.Any) -> TensorFloat32:
+        ...
     @typing.overload
     def __iadd__(self, arg0: TensorFloat32) -> TensorFloat32:
         ...
@@ -96,20 +542,86 @@ class TensorFloat32:
         ...
     def __repr__(self) -> str:
         ...
+    @typing.overload
+    def argmax(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def argmax(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
     def broadcast_to(self, arg0: list[int]) -> TensorFloat32:
         ...
+    def contiguous(self) -> TensorFloat32:
+        ...
     def expand(self, arg0: list[int]) -> TensorFloat32:
         ...
+    @typing.overload
+    def max(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def max(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def mean(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def mean(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def min(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def min(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    def narrow(self, dim: int, start: int, length: int) -> TensorFloat32:
+        ...
+    def numpy(self) -> numpy.ndarray:
+        """
+        NumPy array sharing the tensor data (a float32 copy for bfloat16)
+        """
+    def permute(self, dims: list[int]) -> TensorFloat32:
+        ...
+    @typing.overload
+    def prod(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def prod(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    def select(self, dim: int, index: int) -> TensorFloat32:
+        ...
     def squeeze(self, arg0: list[int]) -> TensorFloat32:
         ...
+    @typing.overload
+    def sum(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def sum(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    def to(self, dtype: DataType, scale: float = 1.0, shift: float = 0.0) -> typing.Any:
+        """
+        Copy of the tensor converted to dtype as dtype(x * scale + shift), truncating floats toward zero and saturating for integer dtypes (int32 to uint8 without scale or shift wraps)
+        """
+    def transpose(self, dim0: int, dim1: int) -> TensorFloat32:
+        ...
     def unsqueeze(self, arg0: list[int]) -> TensorFloat32:
         ...
     def view(self, arg0: list[int]) -> TensorFloat32:
         ...
     @property
+    def T(self) -> TensorFloat32:
+        ...
+    @property
     def dtype(self) -> DataType:
         ...
     @property
+    def has_broadcast(self) -> bool:
+        ...
+    @property
+    def is_contiguous(self) -> bool:
+        ...
+    @property
+    def is_dense(self) -> bool:
+        ...
+    @property
     def ndim(self) -> int:
         ...
     @property
@@ -129,6 +641,11 @@ class TensorInt32:
     def empty(arg0: list[int]) -> TensorInt32:
         ...
     @staticmethod
+    def from_numpy(array: numpy.ndarray) -> TensorInt32:
+        """
+        Tensor sharing the memory of a NumPy array
+        """
+    @staticmethod
     def full(arg0: list[int], arg1: float) -> TensorInt32:
         ...
     @staticmethod
@@ -146,6 +663,10 @@ class TensorInt32:
     @typing.overload
     def __add__(self, arg0: float) -> TensorInt32:
         ...
+    def __array__(self, dtype: typing.Any = None, copy: typing.Any = None) -> numpy.ndarray:
+        ...
+    def __getitem__(self, arg0: typing.Any) -> TensorInt32:
+        ...
     @typing.overload
     def __iadd__(self, arg0: TensorInt32) -> TensorInt32:
         ...
@@ -170,20 +691,86 @@ class TensorInt32:
         ...
     def __repr__(self) -> str:
         ...
+    @typing.overload
+    def argmax(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def argmax(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
     def broadcast_to(self, arg0: list[int]) -> TensorInt32:
         ...
+    def contiguous(self) -> TensorInt32:
+        ...
     def expand(self, arg0: list[int]) -> TensorInt32:
         ...
+    @typing.overload
+    def max(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def max(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def mean(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def mean(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def min(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def min(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    def narrow(self, dim: int, start: int, length: int) -> TensorInt32:
+        ...
+    def numpy(self) -> numpy.ndarray:
+        """
+        NumPy array sharing the tensor data (a float32 copy for bfloat16)
+        """
+    def permute(self, dims: list[int]) -> TensorInt32:
+        ...
+    @typing.overload
+    def prod(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def prod(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    def select(self, dim: int, index: int) -> TensorInt32:
+        ...
     def squeeze(self, arg0: list[int]) -> TensorInt32:
         ...
+    @typing.overload
+    def sum(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def sum(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    def to(self, dtype: DataType, scale: float = 1.0, shift: float = 0.0) -> typing.Any:
+        """
+        Copy of the tensor converted to dtype as dtype(x * scale + shift), truncating floats toward zero and saturating for integer dtypes (int32 to uint8 without scale or shift wraps)
+        """
+    def transpose(self, dim0: int, dim1: int) -> TensorInt32:
+        ...
     def unsqueeze(self, arg0: list[int]) -> TensorInt32:
         ...
     def view(self, arg0: list[int]) -> TensorInt32:
         ...
     @property
+    def T(self) -> TensorInt32:
+        ...
+    @property
     def dtype(self) -> DataType:
         ...
     @property
+    def has_broadcast(self) -> bool:
+        ...
+    @property
+    def is_contiguous(self) -> bool:
+        ...
+    @property
+    def is_dense(self) -> bool:
+        ...
+    @property
     def ndim(self) -> int:
         ...
     @property
@@ -203,6 +790,11 @@ class TensorUInt8:
     def empty(arg0: list[int]) -> TensorUInt8:
         ...
     @staticmethod
+    def from_numpy(array: numpy.ndarray) -> TensorUInt8:
+        """
+        Tensor sharing the memory of a NumPy array
+        """
+    @staticmethod
     def full(arg0: list[int], arg1: float) -> TensorUInt8:
         ...
     @staticmethod
@@ -220,6 +812,10 @@ class TensorUInt8:
     @typing.overload
     def __add__(self, arg0: float) -> TensorUInt8:
         ...
+    def __array__(self, dtype: typing.Any = None, copy: typing.Any = None) -> numpy.ndarray:
+        ...
+    def __getitem__(self, arg0: typing.Any) -> TensorUInt8:
+        ...
     @typing.overload
     def __iadd__(self, arg0: TensorUInt8) -> TensorUInt8:
         ...
@@ -244,20 +840,86 @@ class TensorUInt8:
         ...
     def __repr__(self) -> str:
         ...
+    @typing.overload
+    def argmax(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def argmax(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
     def broadcast_to(self, arg0: list[int]) -> TensorUInt8:
         ...
+    def contiguous(self) -> TensorUInt8:
+        ...
     def expand(self, arg0: list[int]) -> TensorUInt8:
         ...
+    @typing.overload
+    def max(self, dims: list[int] = [], keepdim: bool = False) -> TensorUInt8:
+        ...
+    @typing.overload
+    def max(self, dim: int, keepdim: bool = False) -> TensorUInt8:
+        ...
+    @typing.overload
+    def mean(self, dims: list[int] = [], keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def mean(self, dim: int, keepdim: bool = False) -> TensorFloat32:
+        ...
+    @typing.overload
+    def min(self, dims: list[int] = [], keepdim: bool = False) -> TensorUInt8:
+        ...
+    @typing.overload
+    def min(self, dim: int, keepdim: bool = False) -> TensorUInt8:
+        ...
+    def narrow(self, dim: int, start: int, length: int) -> TensorUInt8:
+        ...
+    def numpy(self) -> numpy.ndarray:
+        """
+        NumPy array sharing the tensor data (a float32 copy for bfloat16)
+        """
+    def permute(self, dims: list[int]) -> TensorUInt8:
+        ...
+    @typing.overload
+    def prod(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def prod(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    def select(self, dim: int, index: int) -> TensorUInt8:
+        ...
     def squeeze(self, arg0: list[int]) -> TensorUInt8:
         ...
+    @typing.overload
+    def sum(self, dims: list[int] = [], keepdim: bool = False) -> TensorInt32:
+        ...
+    @typing.overload
+    def sum(self, dim: int, keepdim: bool = False) -> TensorInt32:
+        ...
+    def to(self, dtype: DataType, scale: float = 1.0, shift: float = 0.0) -> typing.Any:
+        """
+        Copy of the tensor converted to dtype as dtype(x * scale + shift), truncating floats toward zero and saturating for integer dtypes (int32 to uint8 without scale or shift wraps)
+        """
+    def transpose(self, dim0: int, dim1: int) -> TensorUInt8:
+        ...
     def unsqueeze(self, arg0: list[int]) -> TensorUInt8:
         ...
     def view(self, arg0: list[int]) -> TensorUInt8:
         ...
     @property
+    def T(self) -> TensorUInt8:
+        ...
+    @property
     def dtype(self) -> DataType:
         ...
     @property
+    def has_broadcast(self) -> bool:
+        ...
+    @property
+    def is_contiguous(self) -> bool:
+        ...
+    @property
+    def is_dense(self) -> bool:
+        ...
+    @property
     def ndim(self) -> int:
         ...
     @property
@@ -269,14 +931,305 @@ class TensorUInt8:
     @property
     def strides(self) -> list[int]:
         ...
+@typing.overload
+def add(a: TensorUInt8, b: TensorUInt8, out: typing.Any = None) -> typing.Any:
+    """
+    a + b with broadcasting, written into out if given
+    """
+@typing.overload
+def add(a: TensorUInt8, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a + b for a scalar b, written into out if given
+    """
+@typing.overload
+def add(a: TensorInt32, b: TensorInt32, out: typing.Any = None) -> typing.Any:
+    """
+    a + b with broadcasting, written into out if given
+    """
+@typing.overload
+def add(a: TensorInt32, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a + b for a scalar b, written into out if given
+    """
+@typing.overload
+def add(a: TensorFloat32, b: TensorFloat32, out: typing.Any = None) -> typing.Any:
+    """
+    a + b with broadcasting, written into out if given
+    """
+@typing.overload
+def add(a: TensorFloat32, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a + b for a scalar b, written into out if given
+    """
+@typing.overload
+def add(a: TensorFloat16, b: TensorFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a + b with broadcasting, written into out if given
+    """
+@typing.overload
+def add(a: TensorFloat16, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a + b for a scalar b, written into out if given
+    """
+@typing.overload
+def add(a: TensorBFloat16, b: TensorBFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a + b with broadcasting, written into out if given
+    """
+@typing.overload
+def add(a: TensorBFloat16, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a + b for a scalar b, written into out if given
+    """
+def clear_profiler() -> None:
+    """
+    Discard the recorded op events
+    """
+def empty_cache() -> None:
+    """
+    Release the memory cached by the allocator
+    """
+def export_chrome_trace(path: str) -> None:
+    """
+    Write the recorded events as a Chrome trace JSON file
+    """
+@typing.overload
+def fma(a: TensorUInt8, b: TensorUInt8, c: TensorUInt8, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorUInt8, b: TensorUInt8, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorUInt8, b: float, c: TensorUInt8, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorUInt8, b: float, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorInt32, b: TensorInt32, c: TensorInt32, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorInt32, b: TensorInt32, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorInt32, b: float, c: TensorInt32, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorInt32, b: float, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat32, b: TensorFloat32, c: TensorFloat32, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat32, b: TensorFloat32, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat32, b: float, c: TensorFloat32, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat32, b: float, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat16, b: TensorFloat16, c: TensorFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat16, b: TensorFloat16, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat16, b: float, c: TensorFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorFloat16, b: float, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorBFloat16, b: TensorBFloat16, c: TensorBFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorBFloat16, b: TensorBFloat16, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorBFloat16, b: float, c: TensorBFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+@typing.overload
+def fma(a: TensorBFloat16, b: float, c: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b + c with broadcasting, fused in a single pass, written into out if given
+    """
+def from_numpy(array: numpy.ndarray) -> typing.Any:
+    """
+    Create a Tensor sharing the memory of a NumPy array
+    """
 def full(shape: list[int], value: DataType, dtype: float) -> typing.Any:
     """
     Create a Tensor filled with a value
     """
+def get_num_threads() -> int:
+    """
+    Get the number of threads used by parallel ops
+    """
+def is_profiler_enabled() -> bool:
+    """
+    Whether op events are being recorded
+    """
+def load(path: str) -> dict:
+    """
+    Load the tensors of a file by name, memory-mapped without copying
+    """
+@typing.overload
+def matmul(a: TensorUInt8, b: TensorUInt8, out: typing.Any = None) -> typing.Any:
+    """
+    a @ b, written into out (not overlapping a or b) if given
+    """
+@typing.overload
+def matmul(a: TensorInt32, b: TensorInt32, out: typing.Any = None) -> typing.Any:
+    """
+    a @ b, written into out (not overlapping a or b) if given
+    """
+@typing.overload
+def matmul(a: TensorFloat32, b: TensorFloat32, out: typing.Any = None) -> typing.Any:
+    """
+    a @ b, written into out (not overlapping a or b) if given
+    """
+@typing.overload
+def matmul(a: TensorFloat16, b: TensorFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a @ b, written into out (not overlapping a or b) if given
+    """
+@typing.overload
+def matmul(a: TensorBFloat16, b: TensorBFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a @ b, written into out (not overlapping a or b) if given
+    """
+def memory_stats() -> dict:
+    """
+    Get the allocator counters: cache hits/misses, bytes in use and bytes cached
+    """
+@typing.overload
+def mul(a: TensorUInt8, b: TensorUInt8, out: typing.Any = None) -> typing.Any:
+    """
+    a * b with broadcasting, written into out if given
+    """
+@typing.overload
+def mul(a: TensorUInt8, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b for a scalar b, written into out if given
+    """
+@typing.overload
+def mul(a: TensorInt32, b: TensorInt32, out: typing.Any = None) -> typing.Any:
+    """
+    a * b with broadcasting, written into out if given
+    """
+@typing.overload
+def mul(a: TensorInt32, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b for a scalar b, written into out if given
+    """
+@typing.overload
+def mul(a: TensorFloat32, b: TensorFloat32, out: typing.Any = None) -> typing.Any:
+    """
+    a * b with broadcasting, written into out if given
+    """
+@typing.overload
+def mul(a: TensorFloat32, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b for a scalar b, written into out if given
+    """
+@typing.overload
+def mul(a: TensorFloat16, b: TensorFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a * b with broadcasting, written into out if given
+    """
+@typing.overload
+def mul(a: TensorFloat16, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b for a scalar b, written into out if given
+    """
+@typing.overload
+def mul(a: TensorBFloat16, b: TensorBFloat16, out: typing.Any = None) -> typing.Any:
+    """
+    a * b with broadcasting, written into out if given
+    """
+@typing.overload
+def mul(a: TensorBFloat16, b: float, out: typing.Any = None) -> typing.Any:
+    """
+    a * b for a scalar b, written into out if given
+    """
 def ones(shape: list[int], dtype: DataType) -> typing.Any:
     """
     Create a Tensor of ones
     """
+def profiler_events() -> list:
+    """
+    Get the recorded op events: name, shapes, dtype, start/duration, thread, bytes and FLOPs
+    """
+def profiler_summary() -> str:
+    """
+    Table of the recorded events aggregated by op and dtype
+    """
+@typing.overload
+def quantized_matmul(a: TensorUInt8, a_params: QuantParams, b: TensorUInt8, b_params: QuantParams) -> TensorInt32:
+    """
+    Matmul of quantized uint8 tensors with exact int32 accumulation
+    """
+@typing.overload
+def quantized_matmul(a: TensorUInt8, a_params: QuantParams, b: TensorUInt8, b_params: QuantParams, out_params: QuantParams) -> TensorUInt8:
+    """
+    Matmul of quantized uint8 tensors requantized to out_params
+    """
+def save(path: str, tensors: dict) -> None:
+    """
+    Save a dict of named tensors to a file
+    """
+def set_num_threads(num_threads: int) -> None:
+    """
+    Set the number of threads used by parallel ops
+    """
+def set_profiler_enabled(enabled: bool) -> None:
+    """
+    Start or stop recording op events
+    """
+def simd_level() -> str:
+    """
+    Get the SIMD instruction set used by the kernels
+    """
 def zeros(shape: list[int], dtype: DataType) -> typing.Any:
     """
     Create a Tensor of zeros
@@ -0,0 +1,339 @@
+#include "allocator.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+
+namespace {
+
+// Blocks up to this size go through the per-thread caches, which hold a few blocks per class
+const size_t THREAD_CACHE_MAX_SIZE = 1 << 20;
+const size_t THREAD_CACHE_BLOCKS = 4;
+
+const size_t DEFAULT_CACHE_LIMIT = size_t(1) << 30;
+
+void* system_allocate(size_t nbytes) {
+#if defined(_WIN32)
+    return _aligned_malloc(nbytes, memory::ALIGNMENT);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, memory::ALIGNMENT, nbytes) != 0) return nullptr;
+    return ptr;
+#endif
+}
+
+void system_free(void* ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+// Requests are rounded up to size classes so slightly different sizes share blocks:
+// multiples of the alignment for small blocks, then four classes per power of two
+// (at most 25% waste) for larger ones
+size_t size_class(size_t nbytes) {
+    if (nbytes == 0) nbytes = 1;
+    if (nbytes <= 4096) {
+        return (nbytes + memory::ALIGNMENT - 1) / memory::ALIGNMENT * memory::ALIGNMENT;
+    }
+    size_t power = 4096;
+    while (power * 2 <= nbytes) power *= 2;
+    size_t step = power / 4;
+    return (nbytes + step - 1) / step * step;
+}
+
+using FreeLists = std::unordered_map<size_t, std::vector<void*>>;
+
+size_t cache_limit_from_env() {
+    if (const char* env = std::getenv("CPPTENSOR_CACHE_LIMIT_MB")) {
+        return static_cast<size_t>(std::strtoull(env, nullptr, 10)) << 20;
+    }
+    return DEFAULT_CACHE_LIMIT;
+}
+
+} // namespace
+
+
+// ---------------------------------------------------------------- SystemAllocator
+
+void* memory::SystemAllocator::allocate(size_t nbytes) {
+    void* ptr = system_allocate(nbytes == 0 ? 1 : nbytes);
+    if (!ptr) throw std::bad_alloc();
+    allocations++;
+    bytes_in_use += nbytes;
+    return ptr;
+}
+
+void memory::SystemAllocator::deallocate(void* ptr, size_t nbytes) {
+    system_free(ptr);
+    bytes_in_use -= nbytes;
+}
+
+memory::AllocatorStats memory::SystemAllocator::stats() const {
+    AllocatorStats stats;
+    stats.misses = allocations.load();
+    stats.bytes_in_use = bytes_in_use.load();
+    return stats;
+}
+
+// ---------------------------------------------------------------- CachingAllocator
+
+namespace {
+struct ThreadCache;
+}
+
+struct memory::CachingAllocator::State {
+    std::mutex mutex;
+    FreeLists free_lists;
+
+    // Thread caches bound to this allocator, so empty_cache can reach all of them
+    std::mutex caches_mutex;
+    std::vector<ThreadCache*> caches;
+
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+    std::atomic<size_t> bytes_in_use{0};
+    std::atomic<size_t> bytes_cached{0};
+    std::atomic<size_t> cache_limit{DEFAULT_CACHE_LIMIT};
+    std::atomic<bool> thread_cache_enabled{true};
+};
+
+namespace {
+
+// Blocks cached by one thread for one allocator. Returned to the shared lists on thread exit.
+// Its mutex is only contended while another thread empties the caches.
+struct ThreadCache {
+    std::shared_ptr<memory::CachingAllocator> owner;
+    memory::CachingAllocator::State* state = nullptr;
+    std::mutex mutex;
+    FreeLists blocks;
+
+    // Binds the cache to the allocator of state, handing back the blocks of a previous one
+    void bind(std::shared_ptr<memory::CachingAllocator> allocator, memory::CachingAllocator::State* new_state) {
+        unbind();
+        {
+            std::lock_guard<std::mutex> lock(new_state->caches_mutex);
+            new_state->caches.push_back(this);
+        }
+        owner = std::move(allocator);
+        state = new_state;
+    }
+
+    void unbind() {
+        if (!state) return;
+        {
+            std::lock_guard<std::mutex> lock(state->caches_mutex);
+            state->caches.erase(std::find(state->caches.begin(), state->caches.end(), this));
+        }
+        flush_to_shared();
+        state = nullptr;
+        owner.reset();
+    }
+
+    void flush_to_shared() {
+        std::lock_guard<std::mutex> cache_lock(mutex);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        for (auto& [size, list] : blocks) {
+            std::vector<void*>& shared = state->free_lists[size];
+            shared.insert(shared.end(), list.begin(), list.end());
+        }
+        blocks.clear();
+    }
+
+    ~ThreadCache() { unbind(); }
+};
+
+thread_local ThreadCache thread_cache;
+
+} // namespace
+
+memory::CachingAllocator::CachingAllocator() : state(std::make_unique<State>()) {
+    state->cache_limit = cache_limit_from_env();
+    if (const char* env = std::getenv("CPPTENSOR_THREAD_CACHE")) {
+        state->thread_cache_enabled = std::strcmp(env, "0") != 0;
+    }
+}
+
+memory::CachingAllocator::~CachingAllocator() {
+    for (auto& [size, list] : state->free_lists) {
+        for (void* ptr : list) system_free(ptr);
+    }
+}
+
+void* memory::CachingAllocator::allocate(size_t nbytes) {
+    size_t size = size_class(nbytes);
+    state->bytes_in_use += size;
+
+    if (size <= THREAD_CACHE_MAX_SIZE && state->thread_cache_enabled && thread_cache.state == state.get()) {
+        std::lock_guard<std::mutex> lock(thread_cache.mutex);
+        auto it = thread_cache.blocks.find(size);
+        if (it != thread_cache.blocks.end() && !it->second.empty()) {
+            void* ptr = it->second.back();
+            it->second.pop_back();
+            state->hits++;
+            state->bytes_cached -= size;
+            return ptr;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto it = state->free_lists.find(size);
+        if (it != state->free_lists.end() && !it->second.empty()) {
+            void* ptr = it->second.back();
+            it->second.pop_back();
+            state->hits++;
+            state->bytes_cached -= size;
+            return ptr;
+        }
+    }
+
+    state->misses++;
+    void* ptr = system_allocate(size);
+    if (!ptr) {
+        // Out of memory: drop everything cached and retry once
+        empty_cache();
+        ptr = system_allocate(size);
+        if (!ptr) {
+            state->bytes_in_use -= size;
+            throw std::bad_alloc();
+        }
+    }
+    return ptr;
+}
+
+void memory::CachingAllocator::deallocate(void* ptr, size_t nbytes) {
+    size_t size = size_class(nbytes);
+    state->bytes_in_use -= size;
+
+    if (state->bytes_cached + size > state->cache_limit) {
+        system_free(ptr);
+        return;
+    }
+
+    if (size <= THREAD_CACHE_MAX_SIZE && state->thread_cache_enabled) {
+        // Bind the calling thread's cache to this allocator, handing back any blocks
+        // of a previous one
+        if (thread_cache.state != state.get()) {
+            std::shared_ptr<CachingAllocator> self = weak_from_this().lock();
+            if (self) thread_cache.bind(std::move(self), state.get());
+        }
+        if (thread_cache.state == state.get()) {
+            std::lock_guard<std::mutex> lock(thread_cache.mutex);
+            std::vector<void*>& list = thread_cache.blocks[size];
+            if (list.size() < THREAD_CACHE_BLOCKS) {
+                list.push_back(ptr);
+                state->bytes_cached += size;
+                return;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->free_lists[size].push_back(ptr);
+    state->bytes_cached += size;
+}
+
+memory::AllocatorStats memory::CachingAllocator::stats() const {
+    AllocatorStats stats;
+    stats.hits = state->hits.load();
+    stats.misses = state->misses.load();
+    stats.bytes_in_use = state->bytes_in_use.load();
+    stats.bytes_cached = state->bytes_cached.load();
+    return stats;
+}
+
+void memory::CachingAllocator::empty_cache() {
+    // The blocks of every thread cache, including those of idle pool workers, then the shared lists
+    std::vector<FreeLists> taken;
+    {
+        std::lock_guard<std::mutex> caches_lock(state->caches_mutex);
+        for (ThreadCache* cache : state->caches) {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            taken.emplace_back().swap(cache->blocks);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        taken.emplace_back().swap(state->free_lists);
+    }
+    for (const FreeLists& free_lists : taken) {
+        for (const auto& [size, list] : free_lists) {
+            for (void* ptr : list) system_free(ptr);
+            state->bytes_cached -= size * list.size();
+        }
+    }
+}
+
+void memory::CachingAllocator::set_cache_limit(size_t nbytes) {
+    state->cache_limit = nbytes;
+    if (state->bytes_cached > nbytes) empty_cache();
+}
+
+void memory::CachingAllocator::set_thread_cache_enabled(bool enabled) {
+    state->thread_cache_enabled = enabled;
+}
+
+// ---------------------------------------------------------------- Global allocator
+
+namespace {
+
+// The current allocator is only read under the mutex when it changed: each thread keeps a copy
+// tagged with the generation it was read at, and set_allocator bumps the generation.
+std::mutex allocator_mutex;
+std::shared_ptr<memory::Allocator> current_allocator;
+std::atomic<uint64_t> allocator_generation{1};
+
+struct LocalAllocator {
+    uint64_t generation = 0;
+    std::shared_ptr<memory::Allocator> allocator;
+};
+
+thread_local LocalAllocator local_allocator;
+
+std::shared_ptr<memory::Allocator> default_allocator() {
+    const char* env = std::getenv("CPPTENSOR_ALLOCATOR");
+    if (env && std::strcmp(env, "system") == 0) {
+        return std::make_shared<memory::SystemAllocator>();
+    }
+    return std::make_shared<memory::CachingAllocator>();
+}
+
+} // namespace
+
+std::shared_ptr<memory::Allocator> memory::get_allocator() {
+    if (local_allocator.generation != allocator_generation.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(allocator_mutex);
+        if (!current_allocator) current_allocator = default_allocator();
+        local_allocator.allocator = current_allocator;
+        local_allocator.generation = allocator_generation.load(std::memory_order_relaxed);
+    }
+    return local_allocator.allocator;
+}
+
+void memory::set_allocator(const std::shared_ptr<Allocator>& allocator) {
+    if (!allocator) throw std::invalid_argument("Allocator cannot be null");
+    std::lock_guard<std::mutex> lock(allocator_mutex);
+    current_allocator = allocator;
+    allocator_generation.fetch_add(1, std::memory_order_release);
+}
+
+memory::AllocatorStats memory::stats() {
+    return get_allocator()->stats();
+}
+
+void memory::empty_cache() {
+    get_allocator()->empty_cache();
+}
@@ -0,0 +1,95 @@
+#ifndef ALLOCATOR_HPP
+#define ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "profiler.hpp"
+
+namespace memory {
+
+// Alignment of every tensor buffer: a cache line, and enough for aligned AVX-512 loads
+const size_t ALIGNMENT = 64;
+
+struct AllocatorStats {
+    size_t hits = 0;          // Requests served from cached blocks
+    size_t misses = 0;        // Requests that reached the system allocator
+    size_t bytes_in_use = 0;  // Bytes handed out and not released yet
+    size_t bytes_cached = 0;  // Bytes kept in the free lists for reuse
+};
+
+// Interface behind Tensor::empty. Implementations must be thread-safe and return
+// ALIGNMENT-aligned blocks; deallocate receives the size that was requested.
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+    virtual void* allocate(size_t nbytes) = 0;
+    virtual void deallocate(void* ptr, size_t nbytes) = 0;
+
+    virtual AllocatorStats stats() const { return {}; }
+    // Give cached memory back to the system
+    virtual void empty_cache() {}
+};
+
+// Plain aligned allocation from the system, no caching
+class SystemAllocator : public Allocator {
+public:
+    void* allocate(size_t nbytes) override;
+    void deallocate(void* ptr, size_t nbytes) override;
+    AllocatorStats stats() const override;
+
+private:
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> bytes_in_use{0};
+};
+
+// Keeps freed blocks in per size-class free lists so repeated same-shape ops reuse them.
+// Small blocks also go through a per-thread cache that needs no locking. Must be owned by
+// a std::shared_ptr (the thread caches keep a reference to it).
+class CachingAllocator : public Allocator, public std::enable_shared_from_this<CachingAllocator> {
+public:
+    CachingAllocator();
+    ~CachingAllocator() override;
+
+    void* allocate(size_t nbytes) override;
+    void deallocate(void* ptr, size_t nbytes) override;
+    AllocatorStats stats() const override;
+    // Releases the shared free lists and the caches of all threads
+    void empty_cache() override;
+
+    // Upper bound of cached bytes; blocks freed beyond it go back to the system
+    void set_cache_limit(size_t nbytes);
+    void set_thread_cache_enabled(bool enabled);
+
+    struct State;
+
+private:
+    std::unique_ptr<State> state;
+};
+
+// Allocator used by Tensor::empty. Defaults to a CachingAllocator unless the environment
+// variable CPPTENSOR_ALLOCATOR is "system". Buffers keep their allocator alive, so it can
+// be replaced at any time. Threads read it without locking while it is not replaced.
+std::shared_ptr<Allocator> get_allocator();
+void set_allocator(const std::shared_ptr<Allocator>& allocator);
+
+AllocatorStats stats();
+void empty_cache();
+
+// Aligned storage for numel elements of T owned by the current allocator
+template<typename T>
+std::shared_ptr<T[]> allocate_shared(size_t numel) {
+    profiler::Scope scope("allocate");
+    std::shared_ptr<Allocator> allocator = get_allocator();
+    size_t nbytes = numel * sizeof(T);
+    if (scope.active()) scope.describe({}, "", nbytes, 0);
+    T* ptr = static_cast<T*>(allocator->allocate(nbytes));
+    return std::shared_ptr<T[]>(ptr, [allocator, nbytes](T* p) {
+        allocator->deallocate(p, nbytes);
+    });
+}
+
+} // namespace memory
+
+#endif
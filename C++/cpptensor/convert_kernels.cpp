@@ -0,0 +1,316 @@
+#include "convert_kernels.hpp"
+#include "simd_kernels.hpp"
+#include "cpu_features.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(CPPTENSOR_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Scalar fallbacks, also used for the tails of the vector loops
+template<typename T>
+void widen_scalar(const T* a, float32* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = static_cast<float32>(a[i]);
+}
+
+// Truncate toward zero (as a C++ cast does) and saturate to the range of I, NaN becomes 0
+template<typename I>
+I saturate_cast(float32 x) {
+    if (x != x) return 0;
+    // Bounds as floats: the upper one is exclusive since I's max may not be representable
+    const float32 lower = static_cast<float32>(std::numeric_limits<I>::lowest());
+    const float32 upper = static_cast<float32>(std::numeric_limits<I>::max()) + 1.0f;
+    if (x <= lower) return std::numeric_limits<I>::lowest();
+    if (x >= upper) return std::numeric_limits<I>::max();
+    return static_cast<I>(std::trunc(x));
+}
+
+template<typename I>
+void narrow_scalar(const float32* a, I* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = saturate_cast<I>(a[i]);
+}
+
+void copy_f32(const float32* a, float32* out, size_t n) {
+    if (a != out) std::memcpy(out, a, n * sizeof(float32));
+}
+
+void affine_scalar(const float32* a, float32* out, size_t n, float32 scale, float32 shift) {
+    for (size_t i = 0; i < n; i++) out[i] = a[i] * scale + shift;
+}
+
+#if defined(CPPTENSOR_X86)
+
+// Float to int32 lanes: cvttps truncates toward zero but returns INT_MIN for every out of range
+// lane, so overflow is patched to INT_MAX and NaN to 0. uint8 lanes are clamped beforehand.
+
+// ---------------------------------------------------------------- SSE4.2
+
+CPPTENSOR_TARGET("sse4.2")
+void u8_to_f32_sse42(const uint8* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32 packed;
+        std::memcpy(&packed, a + i, sizeof(packed));
+        _mm_storeu_ps(out + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed))));
+    }
+    widen_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void i32_to_f32_sse42(const int32* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))));
+    }
+    widen_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+__m128i clamp_u8_sse42(__m128 v) {
+    v = _mm_and_ps(v, _mm_cmpord_ps(v, v));
+    v = _mm_max_ps(_mm_min_ps(v, _mm_set1_ps(255.0f)), _mm_setzero_ps());
+    return _mm_cvttps_epi32(v);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void f32_to_u8_sse42(const float32* a, uint8* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v0 = clamp_u8_sse42(_mm_loadu_ps(a + i));
+        __m128i v1 = clamp_u8_sse42(_mm_loadu_ps(a + i + 4));
+        __m128i v2 = clamp_u8_sse42(_mm_loadu_ps(a + i + 8));
+        __m128i v3 = clamp_u8_sse42(_mm_loadu_ps(a + i + 12));
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    narrow_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void f32_to_i32_sse42(const float32* a, int32* out, size_t n) {
+    const __m128 upper = _mm_set1_ps(2147483648.0f);
+    const __m128i max = _mm_set1_epi32(std::numeric_limits<int32>::max());
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(a + i);
+        __m128i r = _mm_cvttps_epi32(v);
+        r = _mm_blendv_epi8(r, max, _mm_castps_si128(_mm_cmpge_ps(v, upper)));
+        r = _mm_and_si128(r, _mm_castps_si128(_mm_cmpord_ps(v, v)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+    }
+    narrow_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void affine_f32_sse42(const float32* a, float32* out, size_t n, float32 scale, float32 shift) {
+    const __m128 vs = _mm_set1_ps(scale), vt = _mm_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), vs), vt));
+    }
+    affine_scalar(a + i, out + i, n - i, scale, shift);
+}
+
+// ---------------------------------------------------------------- AVX2
+
+CPPTENSOR_TARGET("avx2")
+void u8_to_f32_avx2(const uint8* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i)));
+        _mm256_storeu_ps(out + i, _mm256_cvtepi32_ps(v));
+    }
+    widen_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void i32_to_f32_avx2(const int32* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i))));
+    }
+    widen_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+__m256i clamp_u8_avx2(__m256 v) {
+    v = _mm256_and_ps(v, _mm256_cmp_ps(v, v, _CMP_ORD_Q));
+    v = _mm256_max_ps(_mm256_min_ps(v, _mm256_set1_ps(255.0f)), _mm256_setzero_ps());
+    return _mm256_cvttps_epi32(v);
+}
+
+CPPTENSOR_TARGET("avx2")
+void f32_to_u8_avx2(const float32* a, uint8* out, size_t n) {
+    // The packs work per 128-bit lane, the permute restores the element order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v0 = clamp_u8_avx2(_mm256_loadu_ps(a + i));
+        __m256i v1 = clamp_u8_avx2(_mm256_loadu_ps(a + i + 8));
+        __m256i v2 = clamp_u8_avx2(_mm256_loadu_ps(a + i + 16));
+        __m256i v3 = clamp_u8_avx2(_mm256_loadu_ps(a + i + 24));
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(v0, v1), _mm256_packs_epi32(v2, v3));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    narrow_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void f32_to_i32_avx2(const float32* a, int32* out, size_t n) {
+    const __m256 upper = _mm256_set1_ps(2147483648.0f);
+    const __m256i max = _mm256_set1_epi32(std::numeric_limits<int32>::max());
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(a + i);
+        __m256i r = _mm256_cvttps_epi32(v);
+        r = _mm256_blendv_epi8(r, max, _mm256_castps_si256(_mm256_cmp_ps(v, upper, _CMP_GE_OQ)));
+        r = _mm256_and_si256(r, _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_ORD_Q)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+    }
+    narrow_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void affine_f32_avx2(const float32* a, float32* out, size_t n, float32 scale, float32 shift) {
+    const __m256 vs = _mm256_set1_ps(scale), vt = _mm256_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(a + i), vs), vt));
+    }
+    affine_scalar(a + i, out + i, n - i, scale, shift);
+}
+
+// ---------------------------------------------------------------- AVX-512
+
+CPPTENSOR_TARGET("avx512f")
+void u8_to_f32_avx512(const uint8* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        _mm512_storeu_ps(out + i, _mm512_cvtepi32_ps(v));
+    }
+    widen_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void i32_to_f32_avx512(const int32* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_cvtepi32_ps(_mm512_loadu_si512(a + i)));
+    }
+    widen_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void f32_to_u8_avx512(const float32* a, uint8* out, size_t n) {
+    const __m512 max = _mm512_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(a + i);
+        v = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(v, v, _CMP_ORD_Q), v);
+        v = _mm512_max_ps(_mm512_min_ps(v, max), _mm512_setzero_ps());
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(v)));
+    }
+    narrow_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void f32_to_i32_avx512(const float32* a, int32* out, size_t n) {
+    const __m512 upper = _mm512_set1_ps(2147483648.0f);
+    const __m512i max = _mm512_set1_epi32(std::numeric_limits<int32>::max());
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(a + i);
+        __m512i r = _mm512_cvttps_epi32(v);
+        r = _mm512_mask_mov_epi32(r, _mm512_cmp_ps_mask(v, upper, _CMP_GE_OQ), max);
+        r = _mm512_maskz_mov_epi32(_mm512_cmp_ps_mask(v, v, _CMP_ORD_Q), r);
+        _mm512_storeu_si512(out + i, r);
+    }
+    narrow_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void affine_f32_avx512(const float32* a, float32* out, size_t n, float32 scale, float32 shift) {
+    const __m512 vs = _mm512_set1_ps(scale), vt = _mm512_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(a + i), vs), vt));
+    }
+    affine_scalar(a + i, out + i, n - i, scale, shift);
+}
+
+#endif // CPPTENSOR_X86
+
+} // namespace
+
+
+template<>
+const cpu::ConvertKernels<uint8>& cpu::convert_kernels<uint8>() {
+    static const ConvertKernels<uint8> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ConvertKernels<uint8>{u8_to_f32_avx512, f32_to_u8_avx512};
+            case SimdLevel::AVX2:   return ConvertKernels<uint8>{u8_to_f32_avx2, f32_to_u8_avx2};
+            case SimdLevel::SSE42:  return ConvertKernels<uint8>{u8_to_f32_sse42, f32_to_u8_sse42};
+            default: break;
+        }
+#endif
+        return ConvertKernels<uint8>{widen_scalar<uint8>, narrow_scalar<uint8>};
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ConvertKernels<int32>& cpu::convert_kernels<int32>() {
+    static const ConvertKernels<int32> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ConvertKernels<int32>{i32_to_f32_avx512, f32_to_i32_avx512};
+            case SimdLevel::AVX2:   return ConvertKernels<int32>{i32_to_f32_avx2, f32_to_i32_avx2};
+            case SimdLevel::SSE42:  return ConvertKernels<int32>{i32_to_f32_sse42, f32_to_i32_sse42};
+            default: break;
+        }
+#endif
+        return ConvertKernels<int32>{widen_scalar<int32>, narrow_scalar<int32>};
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ConvertKernels<float32>& cpu::convert_kernels<float32>() {
+    static const ConvertKernels<float32> kernels{copy_f32, copy_f32};
+    return kernels;
+}
+
+template<>
+const cpu::ConvertKernels<float16>& cpu::convert_kernels<float16>() {
+    static const ConvertKernels<float16> kernels{half_kernels().float16_to_float32, half_kernels().float32_to_float16};
+    return kernels;
+}
+
+template<>
+const cpu::ConvertKernels<bfloat16>& cpu::convert_kernels<bfloat16>() {
+    static const ConvertKernels<bfloat16> kernels{half_kernels().bfloat16_to_float32, half_kernels().float32_to_bfloat16};
+    return kernels;
+}
+
+cpu::affine_kernel cpu::affine_kernel_f32() {
+    static const affine_kernel kernel = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return affine_f32_avx512;
+            case SimdLevel::AVX2:   return affine_f32_avx2;
+            case SimdLevel::SSE42:  return affine_f32_sse42;
+            default: break;
+        }
+#endif
+        return affine_scalar;
+    }();
+    return kernel;
+}
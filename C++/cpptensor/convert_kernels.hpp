@@ -0,0 +1,29 @@
+#ifndef CONVERT_KERNELS_HPP
+#define CONVERT_KERNELS_HPP
+
+#include "dtype.hpp"
+
+#include <cstddef>
+
+namespace cpu {
+
+// Conversions of n contiguous elements between a storage type and float32, the pivot of every
+// dtype pair. Narrowing to an integer type truncates toward zero and saturates to its range
+// (NaN becomes 0); narrowing to a half type rounds to nearest-even.
+template<typename T>
+struct ConvertKernels {
+    void (*to_float32)(const T* a, float32* out, size_t n);
+    void (*from_float32)(const float32* a, T* out, size_t n);
+};
+
+// Kernels for the best instruction set of the host, selected on first use from CPUID
+template<typename T>
+const ConvertKernels<T>& convert_kernels();
+
+// out[i] = a[i] * scale + shift over n contiguous elements. out may alias a.
+using affine_kernel = void (*)(const float32* a, float32* out, size_t n, float32 scale, float32 shift);
+affine_kernel affine_kernel_f32();
+
+} // namespace cpu
+
+#endif
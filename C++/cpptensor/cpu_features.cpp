@@ -0,0 +1,112 @@
+#include "cpu_features.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(CPPTENSOR_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+namespace {
+
+#if defined(CPPTENSOR_X86)
+void cpuid(int leaf, int subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<uint32_t>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switches (XCR0)
+uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+cpu::CpuFeatures detect_features() {
+    cpu::CpuFeatures features;
+#if defined(CPPTENSOR_X86)
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    uint32_t ecx1 = regs[2];
+    features.sse42 = (ecx1 >> 20) & 1;
+
+    bool osxsave = (ecx1 >> 27) & 1;
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    bool ymm_enabled = (xcr0 & 0x6) == 0x6;
+    bool zmm_enabled = (xcr0 & 0xE6) == 0xE6;
+
+    features.avx = ymm_enabled && ((ecx1 >> 28) & 1);
+    features.fma = features.avx && ((ecx1 >> 12) & 1);
+    features.f16c = features.avx && ((ecx1 >> 29) & 1);
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        uint32_t ebx7 = regs[1];
+        features.avx2 = features.avx && ((ebx7 >> 5) & 1);
+        features.avx512f = zmm_enabled && ((ebx7 >> 16) & 1);
+        features.avx512bw = features.avx512f && ((ebx7 >> 30) & 1);
+    }
+#endif
+    return features;
+}
+
+cpu::SimdLevel detect_level() {
+    const cpu::CpuFeatures& f = cpu::cpu_features();
+    cpu::SimdLevel level = cpu::SimdLevel::SCALAR;
+    if (f.sse42) level = cpu::SimdLevel::SSE42;
+    if (f.avx2 && f.fma) level = cpu::SimdLevel::AVX2;
+    if (f.avx512f && f.avx512bw) level = cpu::SimdLevel::AVX512;
+
+    if (const char* env = std::getenv("CPPTENSOR_SIMD")) {
+        cpu::SimdLevel requested = level;
+        if (std::strcmp(env, "scalar") == 0) requested = cpu::SimdLevel::SCALAR;
+        else if (std::strcmp(env, "sse4.2") == 0) requested = cpu::SimdLevel::SSE42;
+        else if (std::strcmp(env, "avx2") == 0) requested = cpu::SimdLevel::AVX2;
+        else if (std::strcmp(env, "avx512") == 0) requested = cpu::SimdLevel::AVX512;
+        // Never go above what the host supports
+        if (requested < level) level = requested;
+    }
+    return level;
+}
+
+} // namespace
+
+
+const cpu::CpuFeatures& cpu::cpu_features() {
+    static const CpuFeatures features = detect_features();
+    return features;
+}
+
+cpu::SimdLevel cpu::simd_level() {
+    static const SimdLevel level = detect_level();
+    return level;
+}
+
+std::string cpu::simd_level_to_str(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::SSE42:  return "sse4.2";
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default:                return "unknown";
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef CPU_FEATURES_HPP
+#define CPU_FEATURES_HPP
+
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPPTENSOR_X86 1
+#endif
+
+// Compile a single function for a given instruction set without raising the baseline
+// of the whole binary. MSVC accepts the intrinsics without any attribute.
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPTENSOR_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CPPTENSOR_TARGET(isa)
+#endif
+
+namespace cpu {
+
+struct CpuFeatures {
+    bool sse42 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+};
+
+// Instruction set tiers the kernels are specialized for, in increasing order
+enum class SimdLevel {
+    SCALAR,
+    SSE42,
+    AVX2,
+    AVX512,
+};
+
+// Features reported by CPUID (and enabled by the OS), detected once per process
+const CpuFeatures& cpu_features();
+
+// Best tier supported by the host. The CPPTENSOR_SIMD environment variable
+// ("scalar", "sse4.2", "avx2", "avx512") can lower it, e.g. to compare kernels.
+SimdLevel simd_level();
+
+std::string simd_level_to_str(SimdLevel level);
+
+} // namespace cpu
+
+#endif
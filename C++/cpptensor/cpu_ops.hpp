@@ -2,44 +2,426 @@
 #define CPU_OPS_HPP
 
 #include "tensor.hpp"
+#include "gemm.hpp"
+#include "qgemm.hpp"
+#include "parallel.hpp"
+#include "simd_kernels.hpp"
+#include "convert_kernels.hpp"
+#include "transpose_kernels.hpp"
+#include "small_matmul.hpp"
+#include "iterator.hpp"
+#include "allocator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 namespace cpu {
 
+// Minimum number of elements given to each thread by the parallel elementwise ops
+const size_t ELEMENTWISE_GRAIN = 1 << 16;
+
+// out = op(t1, t2) for operands already broadcast to out's shape. Dense inner runs go to
+// the vectorized kernel, runs where one operand is broadcast to the scalar kernel (op must be
+// commutative) and the rest to a strided loop.
+template<typename T, typename Op>
+void binary_forward(const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out,
+                    binary_kernel<T> kernel, scalar_kernel<T> scalar, Op op) {
+    if (t1.is_contiguous && t2.is_contiguous && out.is_contiguous) {
+        const T* a = t1.data.get();
+        const T* b = t2.data.get();
+        T* o = out.data.get();
+        parallel::parallel_for(0, out.numel, ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+            kernel(a + begin, b + begin, o + begin, end - begin);
+        });
+        return;
+    }
+
+    StridedIterator<3> iter(out.shape, {&out.strides, &t1.strides, &t2.strides});
+    T* out_data = out.data.get();
+    const T* t1_data = t1.data.get();
+    const T* t2_data = t2.data.get();
+
+    parallel_for_each(iter, ELEMENTWISE_GRAIN, [&](const auto& offsets, size_t n, const auto& strides) {
+        T* o = out_data + offsets[0];
+        const T* a = t1_data + offsets[1];
+        const T* b = t2_data + offsets[2];
+        if (strides[0] == 1 && strides[1] == 1 && strides[2] == 1) {
+            kernel(a, b, o, n);
+        } else if (strides[0] == 1 && strides[1] == 1 && strides[2] == 0) {
+            scalar(a, *b, o, n);
+        } else if (strides[0] == 1 && strides[1] == 0 && strides[2] == 1) {
+            scalar(b, *a, o, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                o[i * strides[0]] = op(a[i * strides[1]], b[i * strides[2]]);
+            }
+        }
+    });
+}
+
+template<typename T>
+void add_forward(const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out) {
+    const ElementwiseKernels<T>& kernels = elementwise_kernels<T>();
+    binary_forward(t1, t2, out, kernels.add, kernels.add_scalar, [](T a, T b) { return static_cast<T>(a + b); });
+}
+
 template<typename T>
-void add_forward(const Tensor<T>& t1, const Tensor<T>& t2, T* out) {
-    for (int i=0; i < t1.numel; i++) {
-        out[i] = t1.get(i) + t2.get(i);
+void mul_forward(const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out) {
+    const ElementwiseKernels<T>& kernels = elementwise_kernels<T>();
+    binary_forward(t1, t2, out, kernels.mul, kernels.mul_scalar, [](T a, T b) { return static_cast<T>(a * b); });
+}
+
+// out = op(t, value) for out with t's shape, without materializing the scalar as a tensor
+template<typename T, typename Op>
+void scalar_forward(const Tensor<T>& t, T value, const Tensor<T>& out, scalar_kernel<T> kernel, Op op) {
+    if (t.is_contiguous && out.is_contiguous) {
+        const T* a = t.data.get();
+        T* o = out.data.get();
+        parallel::parallel_for(0, out.numel, ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+            kernel(a + begin, value, o + begin, end - begin);
+        });
+        return;
     }
+
+    StridedIterator<2> iter(out.shape, {&out.strides, &t.strides});
+    T* out_data = out.data.get();
+    const T* t_data = t.data.get();
+
+    parallel_for_each(iter, ELEMENTWISE_GRAIN, [&](const auto& offsets, size_t n, const auto& strides) {
+        T* o = out_data + offsets[0];
+        const T* a = t_data + offsets[1];
+        if (strides[0] == 1 && strides[1] == 1) {
+            kernel(a, value, o, n);
+        } else {
+            for (size_t i = 0; i < n; i++) o[i * strides[0]] = op(a[i * strides[1]], value);
+        }
+    });
 }
 
 template<typename T>
-void mul_forward(const Tensor<T>& t1, const Tensor<T>& t2, T* out) {
-    for (int i=0; i < t1.numel; i++) {
-        out[i] = t1.get(i) * t2.get(i);
+void add_scalar_forward(const Tensor<T>& t, T value, const Tensor<T>& out) {
+    scalar_forward(t, value, out, elementwise_kernels<T>().add_scalar, [](T a, T b) { return static_cast<T>(a + b); });
+}
+
+template<typename T>
+void mul_scalar_forward(const Tensor<T>& t, T value, const Tensor<T>& out) {
+    scalar_forward(t, value, out, elementwise_kernels<T>().mul_scalar, [](T a, T b) { return static_cast<T>(a * b); });
+}
+
+// Rows of the transposed inner matrix given to each parallel task of copy_forward
+const size_t TRANSPOSE_ROWS = 64;
+
+// Copies src to out of the same shape. When out is contiguous and src has its unit stride in the
+// second to last dim (a transposed matrix, or e.g. NCHW permuted to NHWC), every inner matrix is
+// a blocked transpose; otherwise elements go through a strided loop.
+template<typename T>
+void copy_forward(const Tensor<T>& src, const Tensor<T>& out) {
+    int n = out.ndim;
+    if (n >= 2 && out.is_contiguous && src.strides[n - 2] == 1 && src.strides[n - 1] > 1 && src.shape[n - 2] > 1) {
+        const transpose_kernel transpose = transpose_kernel_for(sizeof(T));
+        size_t rows = src.shape[n - 2], cols = src.shape[n - 1];
+        size_t ld_src = src.strides[n - 1];
+        size_t matrices = out.numel / (rows * cols);
+        size_t blocks = (rows + TRANSPOSE_ROWS - 1) / TRANSPOSE_ROWS;
+        size_t grain = std::max<size_t>(1, ELEMENTWISE_GRAIN / (TRANSPOSE_ROWS * cols));
+        parallel::parallel_for(0, matrices * blocks, grain, [&](size_t begin, size_t end) {
+            for (size_t task = begin; task < end; task++) {
+                size_t matrix = task / blocks, row = task % blocks * TRANSPOSE_ROWS;
+                // Offset of the matrix in src from its index over the outer dims
+                size_t offset = 0;
+                for (int d = n - 3, rest = static_cast<int>(matrix); d >= 0; d--) {
+                    offset += static_cast<size_t>(rest % src.shape[d]) * src.strides[d];
+                    rest /= src.shape[d];
+                }
+                transpose(src.data.get() + offset + row, ld_src, out.data.get() + (matrix * rows + row) * cols, cols,
+                          std::min(TRANSPOSE_ROWS, rows - row), cols);
+            }
+        });
+        return;
     }
+
+    StridedIterator<2> iter(out.shape, {&out.strides, &src.strides});
+    T* out_data = out.data.get();
+    const T* src_data = src.data.get();
+
+    parallel_for_each(iter, ELEMENTWISE_GRAIN, [&](const auto& offsets, size_t n, const auto& strides) {
+        T* o = out_data + offsets[0];
+        const T* s = src_data + offsets[1];
+        if (strides[0] == 1 && strides[1] == 1) {
+            std::memcpy(o, s, n * sizeof(T));
+        } else if (strides[0] == 1 && strides[1] == 0) {
+            std::fill_n(o, n, *s);
+        } else {
+            for (size_t i = 0; i < n; i++) o[i * strides[0]] = s[i * strides[1]];
+        }
+    });
 }
 
+// Elements converted per step through the float32 pivot buffer, small enough to stay in L1
+const size_t CONVERT_BLOCK = 1024;
+
+// out = U(src * scale + shift) for out of src's shape, going through float32 in L1-sized blocks.
+// A float32 side is read or written in place instead of through the buffer. Without scale and
+// shift a same-dtype conversion is a plain copy and integer ones are cast directly, so int32
+// values past 2^24 stay exact.
+template<typename T, typename U>
+void convert_forward(const Tensor<T>& src, const Tensor<U>& out, float32 scale = 1.0f, float32 shift = 0.0f) {
+    const affine_kernel affine = (scale != 1.0f || shift != 0.0f) ? affine_kernel_f32() : nullptr;
+    if constexpr (std::is_same_v<T, U>) {
+        if (!affine) {
+            copy_forward(src, out);
+            return;
+        }
+    }
+    const ConvertKernels<T>& from = convert_kernels<T>();
+    const ConvertKernels<U>& to = convert_kernels<U>();
+
+    // Converts n contiguous elements
+    auto convert = [&](const T* s, U* o, size_t n) {
+        if constexpr (std::is_integral_v<T> && std::is_integral_v<U>) {
+            // Between integer types the values are cast directly, exact and wrapping like a C++ cast
+            if (!affine) {
+                for (size_t i = 0; i < n; i++) o[i] = static_cast<U>(s[i]);
+                return;
+            }
+        }
+        float32 buffer[CONVERT_BLOCK];
+        for (size_t i = 0; i < n; i += CONVERT_BLOCK) {
+            size_t len = std::min(CONVERT_BLOCK, n - i);
+            const float32* f;
+            if constexpr (std::is_same_v<T, float32>) {
+                f = s + i;
+            } else if constexpr (std::is_same_v<U, float32>) {
+                from.to_float32(s + i, o + i, len);
+                f = o + i;
+            } else {
+                from.to_float32(s + i, buffer, len);
+                f = buffer;
+            }
+            if (affine) {
+                float32* w;
+                if constexpr (std::is_same_v<U, float32>) w = o + i; else w = buffer;
+                affine(f, w, len, scale, shift);
+                f = w;
+            }
+            to.from_float32(f, o + i, len);   // A no-op when f already is the float32 output
+        }
+    };
+
+    if (src.is_contiguous && out.is_contiguous) {
+        const T* s = src.data.get();
+        U* o = out.data.get();
+        parallel::parallel_for(0, out.numel, ELEMENTWISE_GRAIN, [&](size_t begin, size_t end) {
+            convert(s + begin, o + begin, end - begin);
+        });
+        return;
+    }
+
+    StridedIterator<2> iter(out.shape, {&out.strides, &src.strides});
+    U* out_data = out.data.get();
+    const T* src_data = src.data.get();
+
+    parallel_for_each(iter, ELEMENTWISE_GRAIN, [&](const auto& offsets, size_t n, const auto& strides) {
+        U* o = out_data + offsets[0];
+        const T* s = src_data + offsets[1];
+        if (strides[0] == 1 && strides[1] == 1) {
+            convert(s, o, n);
+            return;
+        }
+        // Gather strided runs into dense blocks and scatter the result
+        T gathered[CONVERT_BLOCK];
+        U converted[CONVERT_BLOCK];
+        for (size_t i = 0; i < n; i += CONVERT_BLOCK) {
+            size_t len = std::min(CONVERT_BLOCK, n - i);
+            for (size_t j = 0; j < len; j++) gathered[j] = s[(i + j) * strides[1]];
+            convert(gathered, converted, len);
+            for (size_t j = 0; j < len; j++) o[(i + j) * strides[0]] = converted[j];
+        }
+    });
+}
+
+// Minimum number of multiply-adds given to each thread by the parallel matmul
+const size_t MATMUL_GRAIN = 1 << 16;
+
+// Single stride that steps through the batch dims (all but the last two) of a layout in row-major
+// order, if there is one: 0 for a batch broadcast from a single matrix. Dims of size 1 are ignored.
+inline bool uniform_batch_stride(const Dims& shape, const Dims& strides, std::ptrdiff_t& stride) {
+    stride = 0;
+    std::ptrdiff_t expected = -1;  // Stride the next outer dim needs, once an inner one is seen
+    for (int d = static_cast<int>(shape.size()) - 3; d >= 0; d--) {
+        if (shape[d] == 1) continue;
+        if (expected < 0) {
+            stride = strides[d];
+        } else if (strides[d] != expected) {
+            return false;
+        }
+        expected = static_cast<std::ptrdiff_t>(strides[d]) * shape[d];
+    }
+    return true;
+}
+
+// Batched matrix product of operands already broadcast to matmul form, written to out with the
+// given strides (in matmul form too, e.g. a dense buffer or a strided view).
+// gemm_fn(batch, m, n, k, a, a_bs, b, b_bs, c, c_bs) computes one output tile of a strided batch
+// of matrices (see gemm_batched); Blocking gives its micro-kernel tile.
+template<typename Blocking, typename T, typename U, typename Gemm>
+void batched_gemm_forward(const Tensor<T>& t1, const Tensor<T>& t2, U* out, const Dims& out_strides,
+                          Gemm gemm_fn) {
+    int dim_count = t1.ndim;
+    int rows = t1.shape[dim_count - 2];
+    int cols = t2.shape[dim_count - 1];
+    int common_dim = t1.shape[dim_count - 1];
+
+    std::ptrdiff_t t1_rs = t1.strides[dim_count - 2], t1_cs = t1.strides[dim_count - 1];
+    std::ptrdiff_t t2_rs = t2.strides[dim_count - 2], t2_cs = t2.strides[dim_count - 1];
+    std::ptrdiff_t out_rs = out_strides[dim_count - 2], out_cs = out_strides[dim_count - 1];
+
+    int batch_size = 1;
+    for (int d = 0; d < dim_count - 2; d++) batch_size *= t1.shape[d];
+    if (batch_size == 0 || rows == 0 || cols == 0) return;
+
+    // When the operands and out step through the batch with a single stride, consecutive entries
+    // go to gemm_fn together, so a shared right operand (stride 0) is packed once for all of them.
+    // If the rows of the left operand and out are also evenly spaced across entries, as for
+    // weights applied to [batch, seq, features], the batch folds into the rows of one large product.
+    std::ptrdiff_t t1_bs = 0, t2_bs = 0, out_bs = 0;
+    bool strided = uniform_batch_stride(t1.shape, t1.strides, t1_bs) && uniform_batch_stride(t2.shape, t2.strides, t2_bs)
+                   && uniform_batch_stride(t1.shape, out_strides, out_bs);
+    if (strided && batch_size > 1 && t2_bs == 0 && t1_bs == rows * t1_rs && out_bs == rows * out_rs
+        && static_cast<int64_t>(rows) * batch_size <= std::numeric_limits<int>::max()) {
+        rows *= batch_size;
+        batch_size = 1;
+    }
+
+    // With fewer matrices than threads, each output matrix is also split into a grid
+    // of row/column tiles (multiples of the micro-kernel tile) computed independently
+    int num_threads = parallel::in_parallel_region() ? 1 : parallel::get_num_threads();
+    int m_tiles = 1, n_tiles = 1;
+    if (batch_size < num_threads) {
+        int wanted = (num_threads + batch_size - 1) / batch_size;
+        m_tiles = std::min(wanted, (rows + Blocking::MR - 1) / Blocking::MR);
+        n_tiles = std::min((wanted + m_tiles - 1) / m_tiles, (cols + Blocking::NR - 1) / Blocking::NR);
+    }
+    int m_step = ((rows + m_tiles - 1) / m_tiles + Blocking::MR - 1) / Blocking::MR * Blocking::MR;
+    int n_step = ((cols + n_tiles - 1) / n_tiles + Blocking::NR - 1) / Blocking::NR * Blocking::NR;
+    m_tiles = (rows + m_step - 1) / m_step;
+    n_tiles = (cols + n_step - 1) / n_step;
+
+    size_t tiles_per_batch = static_cast<size_t>(m_tiles) * n_tiles;
+    size_t tile_work = static_cast<size_t>(m_step) * n_step * std::max(common_dim, 1);
+    size_t grain = std::max<size_t>(1, MATMUL_GRAIN / tile_work);
+
+    // Items are ordered by tile and then batch entry, so a thread's range covers runs of
+    // entries of the same tile
+    parallel::parallel_for(0, tiles_per_batch * batch_size, grain, [&](size_t begin, size_t end) {
+        for (size_t item = begin; item < end;) {
+            int tile = static_cast<int>(item / batch_size);
+            int batch = static_cast<int>(item % batch_size);
+            int count = strided ? static_cast<int>(std::min(end, (tile + 1) * static_cast<size_t>(batch_size)) - item) : 1;
+            int row0 = (tile / n_tiles) * m_step;
+            int col0 = (tile % n_tiles) * n_step;
+
+            // Locate the matrices of the first entry through the (possibly broadcast) batch strides
+            std::ptrdiff_t t1_offset = 0, t2_offset = 0, out_offset = 0;
+            int rem = batch;
+            for (int d = dim_count - 3; d >= 0 && batch_size > 1; d--) {
+                int idx = rem % t1.shape[d];
+                rem /= t1.shape[d];
+                t1_offset += static_cast<std::ptrdiff_t>(idx) * t1.strides[d];
+                t2_offset += static_cast<std::ptrdiff_t>(idx) * t2.strides[d];
+                out_offset += static_cast<std::ptrdiff_t>(idx) * out_strides[d];
+            }
+
+            MatrixRef<const T> a{t1.data.get() + t1_offset + row0 * t1_rs, t1_rs, t1_cs};
+            MatrixRef<const T> b{t2.data.get() + t2_offset + col0 * t2_cs, t2_rs, t2_cs};
+            MatrixRef<U> c{out + out_offset + row0 * out_rs + col0 * out_cs, out_rs, out_cs};
+            gemm_fn(count, std::min(m_step, rows - row0), std::min(n_step, cols - col0), common_dim,
+                    a, t1_bs, b, t2_bs, c, out_bs);
+            item += count;
+        }
+    });
+}
+
+// Whether a rows x cols matrix with the given strides is dense and row-major. The stride of a
+// dim of size 1 is never used, so it can be anything.
+inline bool row_major(int rows, int cols, std::ptrdiff_t row_stride, std::ptrdiff_t col_stride) {
+    return (rows == 1 || row_stride == cols) && (cols == 1 || col_stride == 1);
+}
+
+// Products with at most SMALL_MATMUL_MAX rows and columns of row-major matrices run through the
+// unrolled small matmul kernels, skipping the packing and tiling of gemm. Returns false when the
+// shapes or layouts don't qualify.
 template<typename T>
-void matmul_forward(const Tensor<T>& t1, const Tensor<T>& t2, T* out) {
+bool small_matmul_forward(const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out) {
     int dim_count = t1.ndim;
     int rows = t1.shape[dim_count - 2];
     int cols = t2.shape[dim_count - 1];
     int common_dim = t1.shape[dim_count - 1];
 
-    size_t batch_size = t1.numel / (rows * common_dim);
-    for (int batch = 0; batch < batch_size; batch++) {
-        for (int i = 0; i < rows; i++) {
-            for (int k = 0; k < common_dim; k++) {
-                for (int j = 0; j < cols; j++) {
-                    int out_idx = batch * rows * cols + i * cols + j;
-                    int t1_idx = batch * rows * common_dim + i * common_dim + k;
-                    int t2_idx = batch * common_dim * cols + k * cols + j;
-                    
-                    out[out_idx] += t1.get(t1_idx) * t2.get(t2_idx); // TODO: .get(idx) is very slow;
-                }
-            }   
+    small_matmul_kernel<T> kernel = small_matmul_kernel_for<T>(rows, cols);
+    if (!kernel) return false;
+    if (!row_major(rows, common_dim, t1.strides[dim_count - 2], t1.strides[dim_count - 1])
+        || !row_major(common_dim, cols, t2.strides[dim_count - 2], t2.strides[dim_count - 1])
+        || !row_major(rows, cols, out.strides[dim_count - 2], out.strides[dim_count - 1])) {
+        return false;
+    }
+    std::ptrdiff_t t1_bs, t2_bs, out_bs;
+    if (!uniform_batch_stride(t1.shape, t1.strides, t1_bs) || !uniform_batch_stride(t2.shape, t2.strides, t2_bs)
+        || !uniform_batch_stride(out.shape, out.strides, out_bs)) {
+        return false;
+    }
+
+    size_t batch_size = 1;
+    for (int d = 0; d < dim_count - 2; d++) batch_size *= t1.shape[d];
+    size_t work = static_cast<size_t>(rows) * cols * std::max(common_dim, 1);
+    const T* a = t1.data.get();
+    const T* b = t2.data.get();
+    T* c = out.data.get();
+    auto run = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            std::ptrdiff_t batch = static_cast<std::ptrdiff_t>(i);
+            kernel(common_dim, a + batch * t1_bs, b + batch * t2_bs, c + batch * out_bs);
         }
+    };
+    // Most of these products are a few hundred multiply-adds, cheaper than handing them to the pool
+    if (batch_size * work < MATMUL_GRAIN) {
+        run(0, batch_size);
+    } else {
+        parallel::parallel_for(0, batch_size, MATMUL_GRAIN / work, run);
     }
+    return true;
+}
+
+// out = t1 @ t2 for operands in matmul form and out of the matmul shape, possibly strided
+template<typename T>
+void matmul_forward(const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out) {
+    if (small_matmul_forward(t1, t2, out)) return;
+
+    using P = gemm_compute_t<T>;
+    auto gemm_fn = [](int batch, int m, int n, int k, MatrixRef<const T> a, std::ptrdiff_t a_bs,
+                      MatrixRef<const T> b, std::ptrdiff_t b_bs, MatrixRef<P> c, std::ptrdiff_t c_bs) {
+        gemm_batched(batch, m, n, k, a, a_bs, b, b_bs, c, c_bs);
+    };
+
+    if constexpr (std::is_same_v<T, P>) {
+        batched_gemm_forward<gemm_blocking<T>>(t1, t2, out.data.get(), out.strides, gemm_fn);
+    } else {
+        // Half-precision products are accumulated in float32 and rounded once at the end
+        Tensor<P> acc(memory::allocate_shared<P>(out.numel), out.shape);
+        batched_gemm_forward<gemm_blocking<T>>(t1, t2, acc.data.get(), acc.strides, gemm_fn);
+        convert_forward(acc, out);
+    }
+}
+
+// int32 products of uint8 operands with their zero points subtracted
+inline void quantized_matmul_forward(const Tensor<uint8>& t1, int32 t1_zero, const Tensor<uint8>& t2, int32 t2_zero,
+                                     const Tensor<int32>& out) {
+    batched_gemm_forward<qgemm_blocking>(t1, t2, out.data.get(), out.strides,
+        [&](int batch, int m, int n, int k, MatrixRef<const uint8> a, std::ptrdiff_t a_bs,
+            MatrixRef<const uint8> b, std::ptrdiff_t b_bs, MatrixRef<int32> c, std::ptrdiff_t c_bs) {
+            qgemm_batched(batch, m, n, k, a, a_bs, t1_zero, b, b_bs, t2_zero, c, c_bs);
+        });
 }
 
 } // namespace cpu
@@ -0,0 +1,159 @@
+#ifndef DIMS_HPP
+#define DIMS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Tensors with up to this many dims keep their shape and strides inline
+const size_t INLINE_DIMS = 8;
+
+// Vector with storage for N values inside the object, so it only allocates once it grows past
+// N (then it moves to the heap like std::vector). Holds simple values such as ints or arrays
+// of them: removed elements are not destroyed.
+template<typename T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_destructible_v<T>, "SmallVector only holds trivially destructible values");
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+    explicit SmallVector(size_t count, const T& value = T()) { assign(count, value); }
+    SmallVector(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+    template<typename It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+    SmallVector(It first, It last) { assign(first, last); }
+    SmallVector(const std::vector<T>& values) { assign(values.begin(), values.end()); }
+
+    SmallVector(const SmallVector& other) { assign(other.begin(), other.end()); }
+    SmallVector(SmallVector&& other) noexcept { take(other); }
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) take(other);
+        return *this;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return heap ? heap_capacity : N; }
+
+    T* data() { return heap ? heap.get() : local; }
+    const T* data() const { return heap ? heap.get() : local; }
+    iterator begin() { return data(); }
+    iterator end() { return data() + count; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + count; }
+
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    T& front() { return data()[0]; }
+    const T& front() const { return data()[0]; }
+    T& back() { return data()[count - 1]; }
+    const T& back() const { return data()[count - 1]; }
+
+    void reserve(size_t n) {
+        if (n > capacity()) grow(n);
+    }
+
+    void resize(size_t n, const T& value = T()) {
+        reserve(n);
+        if (n > count) std::fill(data() + count, data() + n, value);
+        count = n;
+    }
+
+    void clear() { count = 0; }
+
+    void push_back(const T& value) {
+        T copy = value;  // value may live in this vector
+        if (count == capacity()) grow(count + 1);
+        data()[count++] = copy;
+    }
+
+    void pop_back() { count--; }
+
+    iterator insert(const_iterator pos, const T& value) {
+        return insert(pos, &value, &value + 1);
+    }
+
+    template<typename It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+    iterator insert(const_iterator pos, It first, It last) {
+        size_t index = pos - begin();
+        size_t n = std::distance(first, last);
+        SmallVector values(first, last);  // The range may live in this vector
+        reserve(count + n);
+        std::copy_backward(begin() + index, end(), end() + n);
+        std::copy(values.begin(), values.end(), begin() + index);
+        count += n;
+        return begin() + index;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        size_t index = first - begin();
+        std::copy(begin() + (last - begin()), end(), begin() + index);
+        count -= last - first;
+        return begin() + index;
+    }
+
+    void assign(size_t n, const T& value) {
+        count = 0;
+        resize(n, value);
+    }
+
+    template<typename It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+    void assign(It first, It last) {
+        count = 0;
+        reserve(std::distance(first, last));
+        for (; first != last; ++first) data()[count++] = *first;
+    }
+
+    friend bool operator==(const SmallVector& a, const SmallVector& b) {
+        return a.count == b.count && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const SmallVector& a, const SmallVector& b) { return !(a == b); }
+
+private:
+    void grow(size_t n) {
+        size_t new_capacity = std::max(n, 2 * capacity());
+        std::unique_ptr<T[]> bigger(new T[new_capacity]);
+        std::copy(begin(), end(), bigger.get());
+        heap = std::move(bigger);
+        heap_capacity = new_capacity;
+    }
+
+    void take(SmallVector& other) {
+        count = other.count;
+        if (other.heap) {
+            heap = std::move(other.heap);
+            heap_capacity = other.heap_capacity;
+        } else {
+            heap.reset();
+            std::copy(other.local, other.local + count, local);
+        }
+        other.count = 0;
+    }
+
+    size_t count = 0;
+    size_t heap_capacity = 0;
+    std::unique_ptr<T[]> heap;  // Storage once past N values, empty while they fit in local
+    T local[N];
+};
+
+// Shape, strides or a list of dims of a tensor
+using Dims = SmallVector<int, INLINE_DIMS>;
+// One flag per dim of a tensor
+using DimMask = SmallVector<bool, INLINE_DIMS>;
+
+#endif
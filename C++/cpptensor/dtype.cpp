@@ -8,6 +8,8 @@ size_t get_dtype_size(const DataType dtype) {
         case DataType::UINT8:   return sizeof(uint8);
         case DataType::INT32:   return sizeof(int32);
         case DataType::FLOAT32: return sizeof(float32);
+        case DataType::FLOAT16: return sizeof(float16);
+        case DataType::BFLOAT16: return sizeof(bfloat16);
         default:                return 0;
     }
 }
@@ -18,6 +20,8 @@ std::string dtype_to_str(const DataType dtype) {
         case DataType::UINT8:   return "uint8";
         case DataType::INT32:   return "int32";
         case DataType::FLOAT32: return "float32";
+        case DataType::FLOAT16: return "float16";
+        case DataType::BFLOAT16: return "bfloat16";
         default:                return "unknown";
     }
 }
\ No newline at end of file
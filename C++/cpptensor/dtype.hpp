@@ -4,17 +4,42 @@
 #include <cstdint>
 #include <iostream>
 
+#include "half.hpp"
+
 
 // Define aliases for types
 using uint8 = uint8_t;
 using int32 = int32_t;
 using float32 = float;
+// float16 and bfloat16 are defined in half.hpp
 
 // Enum class for data types
 enum class DataType {
     UINT8,
     INT32,
     FLOAT32,
+    FLOAT16,
+    BFLOAT16,
+};
+
+// Result type of sums and products: uint8 is promoted to int32 so they do not wrap at 255,
+// half-precision types to float32 (their accumulation type)
+template<typename T>
+struct sum_result_type { using type = T; };
+template<>
+struct sum_result_type<uint8> { using type = int32; };
+template<>
+struct sum_result_type<float16> { using type = float32; };
+template<>
+struct sum_result_type<bfloat16> { using type = float32; };
+
+template<typename T>
+using sum_result_t = typename sum_result_type<T>::type;
+
+// Affine quantization of uint8 data: real = (q - zero_point) * scale
+struct QuantParams {
+    float scale = 1.0f;
+    int32 zero_point = 0;
 };
 
 
@@ -30,6 +55,10 @@ DataType get_dtype() {
         return DataType::INT32;
     } else if (std::is_same<T, float32>::value) {
         return DataType::FLOAT32;
+    } else if (std::is_same<T, float16>::value) {
+        return DataType::FLOAT16;
+    } else if (std::is_same<T, bfloat16>::value) {
+        return DataType::BFLOAT16;
     } 
     throw std::runtime_error("Unsupported type for Tensor");
 }
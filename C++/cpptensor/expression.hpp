@@ -0,0 +1,257 @@
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+#include "tensor.hpp"
+#include "utils.hpp"
+#include "iterator.hpp"
+#include "cpu_ops.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <type_traits>
+
+// Lazy elementwise expressions. Chains such as
+//     Tensor<float32> r = expr::lazy(t1) * 1.5 + expr::lazy(t2) * t3;
+// build a tree of nodes instead of one temporary per operator, and are evaluated in a
+// single broadcast-aware pass when converted to a Tensor (or written with expr::assign).
+namespace expr {
+
+// Pointers and inner-run strides of every tensor leaf while evaluating
+template<typename T, int N>
+struct EvalContext {
+    std::array<const T*, N> ptrs;
+    std::array<std::ptrdiff_t, N> strides;
+};
+
+template<typename E>
+struct Expr {
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    // Materialize the expression into a new tensor
+    template<typename Self = E>
+    Tensor<typename Self::value_type> eval() const;
+
+    template<typename T, typename Self = E, typename = std::enable_if_t<std::is_same_v<T, typename Self::value_type>>>
+    operator Tensor<T>() const { return eval(); }
+};
+
+template<typename T>
+struct TensorLeaf : Expr<TensorLeaf<T>> {
+    using value_type = T;
+    static constexpr int leaves = 1;
+
+    Tensor<T> tensor;
+
+    explicit TensorLeaf(const Tensor<T>& tensor) : tensor(tensor) {}
+
+    template<int I>
+    void collect(const Tensor<T>** out) const { out[I] = &tensor; }
+
+    template<int I, int N>
+    T at(const EvalContext<T, N>& ctx, size_t i) const { return ctx.ptrs[I][i * ctx.strides[I]]; }
+
+    template<int I, int N>
+    T at_dense(const EvalContext<T, N>& ctx, size_t i) const { return ctx.ptrs[I][i]; }
+};
+
+template<typename T>
+struct ScalarLeaf : Expr<ScalarLeaf<T>> {
+    using value_type = T;
+    static constexpr int leaves = 0;
+
+    T value;
+
+    explicit ScalarLeaf(double value) : value(utils::cast_value<T>(value)) {}
+
+    template<int I>
+    void collect(const Tensor<T>**) const {}
+
+    template<int I, int N>
+    T at(const EvalContext<T, N>&, size_t) const { return value; }
+
+    template<int I, int N>
+    T at_dense(const EvalContext<T, N>&, size_t) const { return value; }
+};
+
+struct AddOp {
+    template<typename T>
+    static T apply(T a, T b) { return static_cast<T>(a + b); }
+};
+
+struct MulOp {
+    template<typename T>
+    static T apply(T a, T b) { return static_cast<T>(a * b); }
+};
+
+template<typename Op, typename L, typename R>
+struct BinaryNode : Expr<BinaryNode<Op, L, R>> {
+    static_assert(std::is_same_v<typename L::value_type, typename R::value_type>, "Datatypes must match.");
+    using value_type = typename L::value_type;
+    static constexpr int leaves = L::leaves + R::leaves;
+
+    L lhs;
+    R rhs;
+
+    BinaryNode(const L& lhs, const R& rhs) : lhs(lhs), rhs(rhs) {}
+
+    // Leaves are numbered left to right, so the right subtree starts after the left one
+    template<int I>
+    void collect(const Tensor<value_type>** out) const {
+        lhs.template collect<I>(out);
+        rhs.template collect<I + L::leaves>(out);
+    }
+
+    template<int I, int N>
+    value_type at(const EvalContext<value_type, N>& ctx, size_t i) const {
+        return Op::apply(lhs.template at<I>(ctx, i), rhs.template at<I + L::leaves>(ctx, i));
+    }
+
+    template<int I, int N>
+    value_type at_dense(const EvalContext<value_type, N>& ctx, size_t i) const {
+        return Op::apply(lhs.template at_dense<I>(ctx, i), rhs.template at_dense<I + L::leaves>(ctx, i));
+    }
+};
+
+template<typename T>
+TensorLeaf<T> lazy(const Tensor<T>& tensor) {
+    return TensorLeaf<T>(tensor);
+}
+
+// Broadcast shape of all the tensors in the expression
+template<typename E>
+Dims result_shape(const Expr<E>& e) {
+    using T = typename E::value_type;
+    std::array<const Tensor<T>*, E::leaves> leaves;
+    e.self().template collect<0>(leaves.data());
+
+    Dims shape = leaves[0]->shape;
+    for (int i = 1; i < E::leaves; i++) shape = utils::broadcast_shapes(shape, leaves[i]->shape);
+    return shape;
+}
+
+// Evaluate the expression into out in a single pass. out must have the broadcast shape
+// of the expression and may be a strided view. A leaf may alias out: when it reads the
+// elements of out in the same places (e.g. x = x * 2 + y) it is evaluated in place,
+// otherwise (a shifted or transposed view of out) through a temporary.
+template<typename E>
+void assign(const Tensor<typename E::value_type>& out, const Expr<E>& e) {
+    using T = typename E::value_type;
+    constexpr int N = E::leaves;
+    const E& root = e.self();
+
+    Dims shape = result_shape(e);
+    if (!utils::shapes_equal(out.shape, shape)) {
+        throw std::runtime_error("Output with shape " + utils::vector_to_string(out.shape) +
+                                 " doesn't match the broadcast shape " + utils::vector_to_string(shape));
+    }
+    if (out.has_broadcast) {
+        throw std::invalid_argument("Output must not be a broadcast view, its elements overlap");
+    }
+
+    std::array<const Tensor<T>*, N> leaves;
+    root.template collect<0>(leaves.data());
+
+    std::array<Dims, N> leaf_strides;
+    std::array<const Dims*, N + 1> operand_strides;
+    operand_strides[0] = &out.strides;
+    bool overlaps = false;
+    for (int i = 0; i < N; i++) {
+        leaf_strides[i] = leaves[i]->broadcast_to(shape).strides;
+        operand_strides[i + 1] = &leaf_strides[i];
+        if (utils::shares_storage(leaves[i]->data, out.data)) {
+            overlaps = overlaps || leaves[i]->data.get() != out.data.get() || leaf_strides[i] != out.strides;
+        }
+    }
+
+    // A write could reach an element that a later step still reads
+    if (overlaps) {
+        Tensor<T> tmp = Tensor<T>::empty(shape);
+        assign(tmp, e);
+        cpu::copy_forward(tmp, out);
+        return;
+    }
+
+    StridedIterator<N + 1> iter(shape, operand_strides);
+    T* out_data = out.data.get();
+
+    parallel_for_each(iter, cpu::ELEMENTWISE_GRAIN, [&](const auto& offsets, size_t n, const auto& strides) {
+        EvalContext<T, N> ctx;
+        bool dense = strides[0] == 1;
+        for (int i = 0; i < N; i++) {
+            ctx.ptrs[i] = leaves[i]->data.get() + offsets[i + 1];
+            ctx.strides[i] = strides[i + 1];
+            dense = dense && strides[i + 1] == 1;
+        }
+
+        T* o = out_data + offsets[0];
+        if (dense) {
+            for (size_t i = 0; i < n; i++) o[i] = root.template at_dense<0>(ctx, i);
+        } else {
+            for (size_t i = 0; i < n; i++) o[i * strides[0]] = root.template at<0>(ctx, i);
+        }
+    });
+}
+
+template<typename E>
+template<typename Self>
+Tensor<typename Self::value_type> Expr<E>::eval() const {
+    Tensor<typename Self::value_type> out = Tensor<typename Self::value_type>::empty(result_shape(*this));
+    assign(out, *this);
+    return out;
+}
+
+// Operators between expressions, tensors and scalars
+
+template<typename L, typename R>
+BinaryNode<AddOp, L, R> operator+(const Expr<L>& lhs, const Expr<R>& rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template<typename L, typename T>
+BinaryNode<AddOp, L, TensorLeaf<T>> operator+(const Expr<L>& lhs, const Tensor<T>& rhs) {
+    return {lhs.self(), TensorLeaf<T>(rhs)};
+}
+
+template<typename T, typename R>
+BinaryNode<AddOp, TensorLeaf<T>, R> operator+(const Tensor<T>& lhs, const Expr<R>& rhs) {
+    return {TensorLeaf<T>(lhs), rhs.self()};
+}
+
+template<typename L>
+BinaryNode<AddOp, L, ScalarLeaf<typename L::value_type>> operator+(const Expr<L>& lhs, double rhs) {
+    return {lhs.self(), ScalarLeaf<typename L::value_type>(rhs)};
+}
+
+template<typename R>
+BinaryNode<AddOp, ScalarLeaf<typename R::value_type>, R> operator+(double lhs, const Expr<R>& rhs) {
+    return {ScalarLeaf<typename R::value_type>(lhs), rhs.self()};
+}
+
+template<typename L, typename R>
+BinaryNode<MulOp, L, R> operator*(const Expr<L>& lhs, const Expr<R>& rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template<typename L, typename T>
+BinaryNode<MulOp, L, TensorLeaf<T>> operator*(const Expr<L>& lhs, const Tensor<T>& rhs) {
+    return {lhs.self(), TensorLeaf<T>(rhs)};
+}
+
+template<typename T, typename R>
+BinaryNode<MulOp, TensorLeaf<T>, R> operator*(const Tensor<T>& lhs, const Expr<R>& rhs) {
+    return {TensorLeaf<T>(lhs), rhs.self()};
+}
+
+template<typename L>
+BinaryNode<MulOp, L, ScalarLeaf<typename L::value_type>> operator*(const Expr<L>& lhs, double rhs) {
+    return {lhs.self(), ScalarLeaf<typename L::value_type>(rhs)};
+}
+
+template<typename R>
+BinaryNode<MulOp, ScalarLeaf<typename R::value_type>, R> operator*(double lhs, const Expr<R>& rhs) {
+    return {ScalarLeaf<typename R::value_type>(lhs), rhs.self()};
+}
+
+} // namespace expr
+
+#endif
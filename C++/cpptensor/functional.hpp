@@ -4,106 +4,319 @@
 
 #include "tensor.hpp"
 #include "cpu_ops.hpp"
+#include "reduce_ops.hpp"
+#include "profiler.hpp"
+#include "graph.hpp"
+
+#include <initializer_list>
 
 namespace F {
 
+// Profiler details of elementwise ops: operands read once, out written once, one op per element
 template<typename T>
-Tensor<T> add(const Tensor<T>& t1_, const Tensor<T>& t2_, bool inplace=false) {
-    Tensor<T> t1 = t1_;  // Create a copy of t1
-    Tensor<T> t2 = t2_;  // Create a copy of t2
+void profile_binary(profiler::Scope& scope, const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out) {
+    scope.describe({&t1.shape, &t2.shape}, dtype_to_str(out.dtype), (t1.numel + t2.numel + out.numel) * sizeof(T), out.numel);
+}
+
+template<typename T>
+void profile_scalar(profiler::Scope& scope, const Tensor<T>& t, const Tensor<T>& out) {
+    scope.describe({&t.shape}, dtype_to_str(out.dtype), (t.numel + out.numel) * sizeof(T), out.numel);
+}
 
-    if (t1.dtype != t2.dtype) {
-        throw std::invalid_argument("Datatypes must match.");
+// Checks that out can receive a result of the given shape. Broadcast (stride 0) dims are
+// rejected since several results would land on the same element.
+template<typename T>
+void check_out(const Tensor<T>& out, const Dims& shape) {
+    if (!utils::shapes_equal(out.shape, shape)) {
+        throw std::runtime_error("Output with shape " + utils::vector_to_string(out.shape) +
+                                 " doesn't match the broadcast shape " + utils::vector_to_string(shape));
+    }
+    if (out.has_broadcast) {
+        throw std::invalid_argument("Output must not be a broadcast view, its elements overlap");
     }
+}
 
-    std::vector<int> out_shape = utils::broadcast_shapes(t1.shape, t2.shape);
+// Whether out shares memory with the operand t (brought to the shape of out) but reads it in
+// other places, e.g. a transposed or shifted view of out
+template<typename T>
+bool overlaps_differently(const Tensor<T>& out, const Tensor<T>& t) {
+    return utils::shares_storage(out.data, t.data) &&
+           (out.data.get() != t.data.get() || !utils::shapes_equal(out.strides, t.strides));
+}
 
-    t2 = t2.broadcast_to(out_shape);
-    Tensor<T> out;
-    if (inplace) {
-        out = t1;
-    } else {
-        t1 = t1.broadcast_to(out_shape);
-        out = Tensor<T>::empty(out_shape);
+// Runs write(dst) for dst = out. When out overlaps an operand differently, a write could reach
+// an element that is still to be read, so the result goes through a temporary (as in
+// expr::assign) and is copied into out.
+template<typename T, typename Write>
+void write_out(const Tensor<T>& out, std::initializer_list<const Tensor<T>*> operands, Write write) {
+    bool overlaps = false;
+    for (const Tensor<T>* t : operands) overlaps = overlaps || overlaps_differently(out, *t);
+    if (!overlaps) {
+        write(out);
+        return;
     }
+    Tensor<T> tmp = Tensor<T>::empty(out.shape);
+    write(tmp);
+    cpu::copy_forward(tmp, out);
+    graph::record_op(graph::OpKind::COPY, tmp, Tensor<T>(), out);
+}
 
-    if (!utils::shapes_equal(out.shape, t2.shape)) {
-        std::string out_shape_str = utils::vector_to_string(out.shape);
-        std::string t2_shape_str = utils::vector_to_string(t2.shape);
-        std::string err_msg = "Output with shape " + out_shape_str + 
-                                " doesn't match the broadcast shape " + t2_shape_str;
-        throw std::runtime_error(err_msg);
-    }
+// out = forward(t1, t2) with broadcasting, into a caller-provided tensor
+template<typename T, typename Forward>
+Tensor<T> binary_out(const char* name, graph::OpKind kind, const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out,
+                     Forward forward) {
+    profiler::Scope scope(name);
 
-    cpu::add_forward(t1, t2, out.data.get());
+    auto run = [&](const Tensor<T>& a, const Tensor<T>& b) {
+        write_out(out, {&a, &b}, [&](const Tensor<T>& dst) {
+            forward(a, b, dst);
+            graph::record_op(kind, a, b, dst);
+        });
+    };
+    // Operands of the same shape skip the broadcasting machinery
+    if (utils::shapes_equal(t1.shape, t2.shape)) {
+        check_out(out, t1.shape);
+        run(t1, t2);
+    } else {
+        Dims out_shape = utils::broadcast_shapes(t1.shape, t2.shape);
+        check_out(out, out_shape);
+        run(t1.broadcast_to(out_shape), t2.broadcast_to(out_shape));
+    }
+    if (scope.active()) profile_binary(scope, t1, t2, out);
     return out;
 }
 
+// Shape of the broadcast result of t1 and t2
 template<typename T>
-Tensor<T> mul(const Tensor<T>& t1_, const Tensor<T>& t2_, bool inplace=false) {
-    Tensor<T> t1 = t1_;  // Create a copy of t1
-    Tensor<T> t2 = t2_;  // Create a copy of t2
+Dims binary_shape(const Tensor<T>& t1, const Tensor<T>& t2) {
+    return utils::shapes_equal(t1.shape, t2.shape) ? t1.shape : utils::broadcast_shapes(t1.shape, t2.shape);
+}
 
-    if (t1.dtype != t2.dtype) {
-        throw std::invalid_argument("Datatypes must match.");
-    }
+// The out= variants write the result into out, which must have the result shape and may be
+// a strided view, and return it. Nothing is allocated for the result when out is one of the
+// operands or doesn't share memory with them; other views of an operand (e.g. a += a.transpose())
+// are written through a temporary.
+template<typename T>
+Tensor<T> add(const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out) {
+    return binary_out("add", graph::OpKind::ADD, t1, t2, out, [](const Tensor<T>& a, const Tensor<T>& b, const Tensor<T>& o) {
+        cpu::add_forward(a, b, o);
+    });
+}
+
+// inplace writes the result into t1, which must have the broadcast shape
+template<typename T>
+Tensor<T> add(const Tensor<T>& t1, const Tensor<T>& t2, bool inplace=false) {
+    return add(t1, t2, inplace ? t1 : Tensor<T>::empty(binary_shape(t1, t2)));
+}
 
-    std::vector<int> out_shape = utils::broadcast_shapes(t1.shape, t2.shape);
+template<typename T>
+Tensor<T> add(const Tensor<T>& t, double value, const Tensor<T>& out) {
+    profiler::Scope scope("add_scalar");
+    check_out(out, t.shape);
 
-    t2 = t2.broadcast_to(out_shape);
-    Tensor<T> out;
-    if (inplace) {
-        out = t1;
-    } else {
-        t1 = t1.broadcast_to(out_shape);
-        out = Tensor<T>::empty(out_shape);
-    }
+    // The scalar is cast once and applied directly, no tensor is allocated for it
+    T scalar = utils::cast_value<T>(value);
+    write_out(out, {&t}, [&](const Tensor<T>& dst) {
+        cpu::add_scalar_forward(t, scalar, dst);
+        graph::record_op(graph::OpKind::ADD_SCALAR, t, scalar, dst);
+    });
+    if (scope.active()) profile_scalar(scope, t, out);
+    return out;
+}
 
-    if (!utils::shapes_equal(out.shape, t2.shape)) {
-        std::string out_shape_str = utils::vector_to_string(out.shape);
-        std::string t2_shape_str = utils::vector_to_string(t2.shape);
-        std::string err_msg = "Output with shape " + out_shape_str + 
-                                " doesn't match the broadcast shape " + t2_shape_str;
-        throw std::runtime_error(err_msg);
-    }
+template<typename T>
+Tensor<T> add(const Tensor<T>& t, double value, bool inplace=false) {
+    return add(t, value, inplace ? t : Tensor<T>::empty(t.shape));
+}
+
+template<typename T>
+Tensor<T> mul(const Tensor<T>& t1, const Tensor<T>& t2, const Tensor<T>& out) {
+    return binary_out("mul", graph::OpKind::MUL, t1, t2, out, [](const Tensor<T>& a, const Tensor<T>& b, const Tensor<T>& o) {
+        cpu::mul_forward(a, b, o);
+    });
+}
+
+template<typename T>
+Tensor<T> mul(const Tensor<T>& t1, const Tensor<T>& t2, bool inplace=false) {
+    return mul(t1, t2, inplace ? t1 : Tensor<T>::empty(binary_shape(t1, t2)));
+}
+
+template<typename T>
+Tensor<T> mul(const Tensor<T>& t, double value, const Tensor<T>& out) {
+    profiler::Scope scope("mul_scalar");
+    check_out(out, t.shape);
 
-    cpu::mul_forward(t1, t2, out.data.get());
+    // The scalar is cast once and applied directly, no tensor is allocated for it
+    T scalar = utils::cast_value<T>(value);
+    write_out(out, {&t}, [&](const Tensor<T>& dst) {
+        cpu::mul_scalar_forward(t, scalar, dst);
+        graph::record_op(graph::OpKind::MUL_SCALAR, t, scalar, dst);
+    });
+    if (scope.active()) profile_scalar(scope, t, out);
     return out;
 }
 
 template<typename T>
-Tensor<T> matmul(const Tensor<T>& t1_, const Tensor<T>& t2_) {
+Tensor<T> mul(const Tensor<T>& t, double value, bool inplace=false) {
+    return mul(t, value, inplace ? t : Tensor<T>::empty(t.shape));
+}
+
+// Bring both operands to matmul form: the same batch dims, (..., M, K) and (..., K, N)
+template<typename T>
+std::pair<Tensor<T>, Tensor<T>> broadcast_for_matmul(const Tensor<T>& t1_, const Tensor<T>& t2_) {
     Tensor<T> t1 = t1_;  // Create a copy of t1
     Tensor<T> t2 = t2_;  // Create a copy of t2
 
-    if (t1.dtype != t2.dtype) {
-        throw std::invalid_argument("Datatypes must match.");
-    }
-
     auto [t1_shape, t2_shape] = utils::broadcast_shapes_for_matmul(t1.shape, t2.shape);
 
-    int t1_numel = std::accumulate(t1_shape.begin(), t1_shape.end(), 1, std::multiplies<int>());
-    if (t1.numel == t1_numel) {
-        t1 = t1.view(t1_shape);
-    } else {
-        t1 = t1.broadcast_to(t1_shape);
-    }
+    // Vectors become a row (t1) or column (t2) matrix
+    if (t1.ndim == 1) t1 = t1.unsqueeze({0});
+    if (t2.ndim == 1) t2 = t2.unsqueeze({1});
+
+    // Only batch dims are added or broadcast from here: a zero-copy expand that keeps any layout,
+    // so transposed operands reach the GEMM as strides
+    t1 = t1.broadcast_to(t1_shape);
+    t2 = t2.broadcast_to(t2_shape);
+
+    return {t1, t2};
+}
+
+template<typename T>
+Dims matmul_shape(const Tensor<T>& t1, const Tensor<T>& t2) {
+    Dims out_shape(t1.shape.begin(), t1.shape.end() - 1);
+    out_shape.push_back(t2.shape.back());
+    return out_shape;
+}
+
+// Whether the operands are already in matmul form, as for most calls in a model, so they are
+// used as they are instead of going through broadcast_for_matmul
+template<typename T>
+bool in_matmul_form(const Tensor<T>& t1, const Tensor<T>& t2) {
+    if (t1.ndim < 2 || t1.ndim != t2.ndim || t1.shape[t1.ndim - 1] != t2.shape[t2.ndim - 2]) return false;
+    return std::equal(t1.shape.begin(), t1.shape.end() - 2, t2.shape.begin());
+}
+
+// out has the shape of the result and may be strided, but must not share memory with the
+// operands, which are still read while it is written
+template<typename T>
+Tensor<T> matmul(const Tensor<T>& t1_, const Tensor<T>& t2_, const Tensor<T>& out) {
+    profiler::Scope scope("matmul");
 
-    int t2_numel = std::accumulate(t2_shape.begin(), t2_shape.end(), 1, std::multiplies<int>());
-    if (t2.numel == t2_numel) {
-        t2 = t2.view(t2_shape);
+    auto forward = [&](const Tensor<T>& t1, const Tensor<T>& t2) {
+        check_out(out, matmul_shape(t1, t2));
+        if (utils::shares_storage(out.data, t1_.data) || utils::shares_storage(out.data, t2_.data)) {
+            throw std::invalid_argument("Output of matmul must not share memory with its operands");
+        }
+        cpu::matmul_forward(t1, t2, out);
+        graph::record_op(graph::OpKind::MATMUL, t1, t2, out);
+    };
+    if (in_matmul_form(t1_, t2_)) {
+        forward(t1_, t2_);
     } else {
-        t2 = t2.broadcast_to(t2_shape);
+        auto [t1, t2] = broadcast_for_matmul(t1_, t2_);
+        forward(t1, t2);
     }
+    if (scope.active()) {
+        uint64_t k = t1_.ndim > 0 ? t1_.shape.back() : 0;
+        scope.describe({&t1_.shape, &t2_.shape}, dtype_to_str(out.dtype),
+                       (t1_.numel + t2_.numel + out.numel) * sizeof(T), 2 * k * out.numel);
+    }
+    return out;
+}
 
-    std::vector<int> out_shape(t1_shape.begin(), t1_shape.end() - 1);
+template<typename T>
+Tensor<T> matmul(const Tensor<T>& t1, const Tensor<T>& t2) {
+    if (in_matmul_form(t1, t2)) return matmul(t1, t2, Tensor<T>::empty(matmul_shape(t1, t2)));
+
+    auto [t1_shape, t2_shape] = utils::broadcast_shapes_for_matmul(t1.shape, t2.shape);
+    Dims out_shape(t1_shape.begin(), t1_shape.end() - 1);
     out_shape.push_back(t2_shape.back());
+    return matmul(t1, t2, Tensor<T>::empty(out_shape));
+}
+
+// Affine-quantized matmul: the operands represent real values (q - zero_point) * scale.
+// Returns the exact int32 products sum((a - a_zero) * (b - b_zero)), whose real scale is
+// a.scale * b.scale. Shapes broadcast like matmul, and K is limited to cpu::QGEMM_MAX_K.
+inline Tensor<int32> quantized_matmul(const Tensor<uint8>& t1_, const QuantParams& q1,
+                                      const Tensor<uint8>& t2_, const QuantParams& q2) {
+    utils::check_quant_params(q1);
+    utils::check_quant_params(q2);
+
+    auto [t1, t2] = broadcast_for_matmul(t1_, t2_);
+    int K = t1.shape.back();
+    if (K > cpu::QGEMM_MAX_K) {
+        throw std::invalid_argument("Quantized matmul inner dimension " + std::to_string(K) + " exceeds " +
+                                    std::to_string(cpu::QGEMM_MAX_K) + ", the int32 accumulators could overflow");
+    }
+    Tensor<int32> out = Tensor<int32>::empty(matmul_shape(t1, t2));
+    cpu::quantized_matmul_forward(t1, q1.zero_point, t2, q2.zero_point, out);
+    return out;
+}
 
-    Tensor<T> out = Tensor<T>::zeros(out_shape);
-    cpu::matmul_forward(t1, t2, out.data.get());
+// Same, requantized to uint8 with the output parameters (rounded, saturated to [0, 255])
+inline Tensor<uint8> quantized_matmul(const Tensor<uint8>& t1, const QuantParams& q1,
+                                      const Tensor<uint8>& t2, const QuantParams& q2, const QuantParams& q_out) {
+    utils::check_quant_params(q_out);
+
+    Tensor<int32> acc = quantized_matmul(t1, q1, t2, q2);
+    Tensor<uint8> out = Tensor<uint8>::empty(acc.shape);
+    float multiplier = static_cast<float>(static_cast<double>(q1.scale) * q2.scale / q_out.scale);
+    cpu::requantize(acc.data.get(), acc.numel, multiplier, q_out.zero_point, out.data.get());
+    return out;
+}
+
+// Reduce t over dims (negative dims count from the end, none means all) with a cpu reducer
+template<typename T, typename Reducer>
+Tensor<typename Reducer::Out> reduce(const Tensor<T>& t, const Dims& dims, bool keepdim,
+                                     const Reducer& reducer, const char* name = nullptr) {
+    DimMask mask = utils::reduction_mask(dims, t.ndim);
+    // Reductions without an identity (max, min, argmax) need at least one element
+    if (name) {
+        for (int d = 0; d < t.ndim; d++) {
+            if (mask[d] && t.shape[d] == 0) {
+                throw std::invalid_argument(std::string(name) + " of an empty dimension is not defined");
+            }
+        }
+    }
+    Tensor<typename Reducer::Out> out = Tensor<typename Reducer::Out>::empty(utils::reduced_shape(t.shape, mask, keepdim));
+    cpu::reduce_forward(t, mask, out.data.get(), reducer);
     return out;
 }
 
+template<typename T>
+Tensor<sum_result_t<T>> sum(const Tensor<T>& t, const Dims& dims = {}, bool keepdim=false) {
+    return reduce(t, dims, keepdim, cpu::SumReducer<T>());
+}
+
+template<typename T>
+Tensor<float32> mean(const Tensor<T>& t, const Dims& dims = {}, bool keepdim=false) {
+    return reduce(t, dims, keepdim, cpu::MeanReducer<T>());
+}
+
+template<typename T>
+Tensor<sum_result_t<T>> prod(const Tensor<T>& t, const Dims& dims = {}, bool keepdim=false) {
+    return reduce(t, dims, keepdim, cpu::ProdReducer<T>());
+}
+
+template<typename T>
+Tensor<T> max(const Tensor<T>& t, const Dims& dims = {}, bool keepdim=false) {
+    return reduce(t, dims, keepdim, cpu::MinMaxReducer<T, true>(), "max");
+}
+
+template<typename T>
+Tensor<T> min(const Tensor<T>& t, const Dims& dims = {}, bool keepdim=false) {
+    return reduce(t, dims, keepdim, cpu::MinMaxReducer<T, false>(), "min");
+}
+
+// Index along dim of the first largest element. Without a dim, index into the flattened tensor.
+template<typename T>
+Tensor<int32> argmax(const Tensor<T>& t, const Dims& dims = {}, bool keepdim=false) {
+    if (dims.size() > 1) {
+        throw std::invalid_argument("argmax reduces a single dimension or the whole tensor");
+    }
+    return reduce(t, dims, keepdim, cpu::ArgmaxReducer<T>(), "argmax");
+}
+
 } // namespace F
 
 #endif
\ No newline at end of file
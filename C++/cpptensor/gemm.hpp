@@ -0,0 +1,224 @@
+#ifndef GEMM_HPP
+#define GEMM_HPP
+
+#include "dtype.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+namespace cpu {
+
+// Blocking parameters for the packed GEMM. MR x NR is the register tile of the
+// micro-kernel, KC x NR panels of B stay in L1, MC x KC blocks of A in L2 and
+// KC x NC blocks of B in L3.
+template<typename T>
+struct gemm_blocking;
+
+// The float32 tile is that of the SIMD micro-kernels (gemm_kernels.cpp): 6 rows of two AVX-512
+// vectors, or two 6 x 16 halves of AVX2 vectors
+template<> struct gemm_blocking<float32> {
+    static constexpr int MR = 6, NR = 32, KC = 256, MC = 96, NC = 2048;
+};
+
+template<> struct gemm_blocking<int32> {
+    static constexpr int MR = 4, NR = 8, KC = 256, MC = 96, NC = 2048;
+};
+
+template<> struct gemm_blocking<uint8> {
+    static constexpr int MR = 4, NR = 32, KC = 512, MC = 128, NC = 4096;
+};
+
+template<> struct gemm_blocking<float16> : gemm_blocking<float32> {};
+template<> struct gemm_blocking<bfloat16> : gemm_blocking<float32> {};
+
+// Type the operands are packed and multiplied in: half-precision storage is widened to float32
+template<typename T>
+struct gemm_compute_type { using type = T; };
+template<> struct gemm_compute_type<float16> { using type = float32; };
+template<> struct gemm_compute_type<bfloat16> { using type = float32; };
+
+template<typename T>
+using gemm_compute_t = typename gemm_compute_type<T>::type;
+
+// Matrix operand described by a base pointer and its row/column strides (in elements)
+template<typename T>
+struct MatrixRef {
+    T* ptr;
+    std::ptrdiff_t rs;
+    std::ptrdiff_t cs;
+};
+
+namespace gemm_detail {
+
+// Copy an mc x kc block of A into row panels of MR, each stored column by column (converted
+// to the compute type P). Rows past mc are zero-padded so the micro-kernel never needs bounds checks.
+template<typename T, int MR, typename P>
+void pack_a(int mc, int kc, const T* a, std::ptrdiff_t rs, std::ptrdiff_t cs, P* packed) {
+    for (int ir = 0; ir < mc; ir += MR) {
+        int mr = std::min(MR, mc - ir);
+        const T* a_panel = a + ir * rs;
+        for (int p = 0; p < kc; p++) {
+            const T* a_col = a_panel + p * cs;
+            int i = 0;
+            for (; i < mr; i++) packed[i] = a_col[i * rs];
+            for (; i < MR; i++) packed[i] = P(0);
+            packed += MR;
+        }
+    }
+}
+
+// Copy a kc x nc block of B into column panels of NR, each stored row by row
+template<typename T, int NR, typename P>
+void pack_b(int kc, int nc, const T* b, std::ptrdiff_t rs, std::ptrdiff_t cs, P* packed) {
+    for (int jr = 0; jr < nc; jr += NR) {
+        int nr = std::min(NR, nc - jr);
+        const T* b_panel = b + jr * cs;
+        if (rs == 1 && cs != 1) {
+            // Column-major B (e.g. a transposed view): read each column contiguously
+            for (int j = 0; j < nr; j++) {
+                const T* b_col = b_panel + j * cs;
+                for (int p = 0; p < kc; p++) packed[p * NR + j] = b_col[p];
+            }
+            for (int j = nr; j < NR; j++) {
+                for (int p = 0; p < kc; p++) packed[p * NR + j] = P(0);
+            }
+            packed += kc * NR;
+            continue;
+        }
+        for (int p = 0; p < kc; p++) {
+            const T* b_row = b_panel + p * rs;
+            int j = 0;
+            if (cs == 1) {
+                for (; j < nr; j++) packed[j] = b_row[j];
+            } else {
+                for (; j < nr; j++) packed[j] = b_row[j * cs];
+            }
+            for (; j < NR; j++) packed[j] = P(0);
+            packed += NR;
+        }
+    }
+}
+
+// Register-tiled micro-kernel: C[mr x nr] (+)= Apanel[MR x kc] * Bpanel[kc x NR].
+// The accumulator tile has a compile-time size so it can live in vector registers.
+template<typename T, int MR, int NR>
+void micro_kernel(int kc, const T* a, const T* b, T* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                  int mr, int nr, bool accumulate) {
+    T acc[MR][NR] = {};
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < MR; i++) {
+            const T av = a[i];
+            for (int j = 0; j < NR; j++) {
+                acc[i][j] += av * b[j];
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (int i = 0; i < mr; i++) {
+        T* c_row = c + i * rs_c;
+        if (accumulate) {
+            for (int j = 0; j < nr; j++) c_row[j * cs_c] += acc[i][j];
+        } else {
+            for (int j = 0; j < nr; j++) c_row[j * cs_c] = acc[i][j];
+        }
+    }
+}
+
+template<typename T>
+using micro_kernel_fn = void (*)(int kc, const T* a, const T* b, T* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                                 int mr, int nr, bool accumulate);
+
+template<typename T>
+T* packing_buffer(std::vector<T>& buffer, size_t size) {
+    if (buffer.size() < size) buffer.resize(size);
+    return buffer.data();
+}
+
+} // namespace gemm_detail
+
+// micro_kernel of the float32 tile for the best instruction set of the host (FMA on AVX2 and
+// AVX-512), selected on first use from CPUID
+gemm_detail::micro_kernel_fn<float32> gemm_micro_kernel_f32();
+
+// Strided batch of products C_i[M x N] = A_i[M x K] * B_i[K x N] for i < batch, where A_i
+// starts at a.ptr + i * a_bs (likewise B_i and C_i) and the matrices are arbitrarily strided.
+// A batch stride of 0 shares an operand across the batch: a shared B (e.g. weights applied to
+// every sequence of a batch) is packed once per cache block and reused by all the entries.
+// C is overwritten (beta = 0) in the compute type, so half-precision products are only
+// rounded by the caller.
+template<typename T>
+void gemm_batched(int batch, int M, int N, int K, MatrixRef<const T> a, std::ptrdiff_t a_bs,
+                  MatrixRef<const T> b, std::ptrdiff_t b_bs, MatrixRef<gemm_compute_t<T>> c, std::ptrdiff_t c_bs) {
+    using B = gemm_blocking<T>;
+    using P = gemm_compute_t<T>;
+    constexpr int MR = B::MR, NR = B::NR, KC = B::KC, MC = B::MC, NC = B::NC;
+
+    if (batch <= 0 || M <= 0 || N <= 0) return;
+    if (K <= 0) {
+        for (int e = 0; e < batch; e++) {
+            P* c_e = c.ptr + e * c_bs;
+            for (int i = 0; i < M; i++) {
+                for (int j = 0; j < N; j++) c_e[i * c.rs + j * c.cs] = P(0);
+            }
+        }
+        return;
+    }
+
+    gemm_detail::micro_kernel_fn<P> kernel = gemm_detail::micro_kernel<P, MR, NR>;
+    if constexpr (std::is_same_v<P, float32>) kernel = gemm_micro_kernel_f32();
+
+    // Each thread owns its packing buffers, so concurrent calls never share them
+    thread_local std::vector<P> a_buffer;
+    thread_local std::vector<P> b_buffer;
+
+    for (int jc = 0; jc < N; jc += NC) {
+        int nc = std::min(NC, N - jc);
+        int nc_padded = (nc + NR - 1) / NR * NR;
+
+        for (int pc = 0; pc < K; pc += KC) {
+            int kc = std::min(KC, K - pc);
+            bool accumulate = pc > 0;
+
+            P* b_packed = gemm_detail::packing_buffer(b_buffer, static_cast<size_t>(kc) * nc_padded);
+            for (int e = 0; e < batch; e++) {
+                if (e == 0 || b_bs != 0) {
+                    gemm_detail::pack_b<T, NR>(kc, nc, b.ptr + e * b_bs + pc * b.rs + jc * b.cs, b.rs, b.cs, b_packed);
+                }
+                const T* a_e = a.ptr + e * a_bs;
+                P* c_e = c.ptr + e * c_bs;
+
+                for (int ic = 0; ic < M; ic += MC) {
+                    int mc = std::min(MC, M - ic);
+                    int mc_padded = (mc + MR - 1) / MR * MR;
+
+                    P* a_packed = gemm_detail::packing_buffer(a_buffer, static_cast<size_t>(mc_padded) * kc);
+                    gemm_detail::pack_a<T, MR>(mc, kc, a_e + ic * a.rs + pc * a.cs, a.rs, a.cs, a_packed);
+
+                    for (int jr = 0; jr < nc; jr += NR) {
+                        int nr = std::min(NR, nc - jr);
+                        for (int ir = 0; ir < mc; ir += MR) {
+                            int mr = std::min(MR, mc - ir);
+                            P* c_tile = c_e + (ic + ir) * c.rs + (jc + jr) * c.cs;
+                            kernel(kc, a_packed + ir * kc, b_packed + jr * kc, c_tile, c.rs, c.cs, mr, nr, accumulate);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// C[M x N] = A[M x K] * B[K x N] for arbitrarily strided operands.
+// C is overwritten (beta = 0); the operands may be transposed or broadcast views.
+template<typename T>
+void gemm(int M, int N, int K, MatrixRef<const T> a, MatrixRef<const T> b, MatrixRef<gemm_compute_t<T>> c) {
+    gemm_batched(1, M, N, K, a, 0, b, 0, c, 0);
+}
+
+} // namespace cpu
+
+#endif
@@ -0,0 +1,142 @@
+#include "gemm.hpp"
+#include "cpu_features.hpp"
+
+#if defined(CPPTENSOR_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+constexpr int MR = cpu::gemm_blocking<float32>::MR, NR = cpu::gemm_blocking<float32>::NR;
+static_assert(MR == 6 && NR == 32, "The SIMD micro-kernels are written for a 6 x 32 tile");
+
+// Writes (or adds) the mr x nr corner of a tile computed in full
+void store_tile(const float32 (&tile)[MR][NR], float32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c, int mr, int nr,
+                bool accumulate) {
+    for (int i = 0; i < mr; i++) {
+        float32* c_row = c + i * rs_c;
+        if (accumulate) {
+            for (int j = 0; j < nr; j++) c_row[j * cs_c] += tile[i][j];
+        } else {
+            for (int j = 0; j < nr; j++) c_row[j * cs_c] = tile[i][j];
+        }
+    }
+}
+
+#if defined(CPPTENSOR_X86)
+
+// Each step of k broadcasts the MR values of the A panel and multiply-adds them with a row of the
+// B panel held in vectors, so the MR x NR accumulators stay in registers for the whole panel.
+// Full tiles of a row-major C are stored straight from the registers.
+
+// One 6 x 16 half of the tile: 12 accumulators, the 2 B vectors and a broadcast fill the 16 ymm
+// registers, so the accumulators are named rather than an array GCC may keep in memory
+CPPTENSOR_TARGET("avx2,fma")
+void half_kernel_avx2(int kc, const float32* a, const float32* b, float32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                      int mr, int nr, bool accumulate) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(), c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps(), c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps(), c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    for (int p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_loadu_ps(b);
+        __m256 b1 = _mm256_loadu_ps(b + 8);
+        __m256 av;
+        av = _mm256_broadcast_ss(a + 0); c00 = _mm256_fmadd_ps(av, b0, c00); c01 = _mm256_fmadd_ps(av, b1, c01);
+        av = _mm256_broadcast_ss(a + 1); c10 = _mm256_fmadd_ps(av, b0, c10); c11 = _mm256_fmadd_ps(av, b1, c11);
+        av = _mm256_broadcast_ss(a + 2); c20 = _mm256_fmadd_ps(av, b0, c20); c21 = _mm256_fmadd_ps(av, b1, c21);
+        av = _mm256_broadcast_ss(a + 3); c30 = _mm256_fmadd_ps(av, b0, c30); c31 = _mm256_fmadd_ps(av, b1, c31);
+        av = _mm256_broadcast_ss(a + 4); c40 = _mm256_fmadd_ps(av, b0, c40); c41 = _mm256_fmadd_ps(av, b1, c41);
+        av = _mm256_broadcast_ss(a + 5); c50 = _mm256_fmadd_ps(av, b0, c50); c51 = _mm256_fmadd_ps(av, b1, c51);
+        a += MR;
+        b += NR;
+    }
+
+    const __m256 acc[MR][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}};
+    if (mr == MR && nr == 16 && cs_c == 1) {
+        for (int i = 0; i < MR; i++) {
+            float32* c_row = c + i * rs_c;
+            __m256 r0 = acc[i][0], r1 = acc[i][1];
+            if (accumulate) {
+                r0 = _mm256_add_ps(r0, _mm256_loadu_ps(c_row));
+                r1 = _mm256_add_ps(r1, _mm256_loadu_ps(c_row + 8));
+            }
+            _mm256_storeu_ps(c_row, r0);
+            _mm256_storeu_ps(c_row + 8, r1);
+        }
+        return;
+    }
+    float32 tile[MR][NR];
+    for (int i = 0; i < MR; i++) {
+        _mm256_storeu_ps(tile[i], acc[i][0]);
+        _mm256_storeu_ps(tile[i] + 8, acc[i][1]);
+    }
+    store_tile(tile, c, rs_c, cs_c, mr, nr, accumulate);
+}
+
+CPPTENSOR_TARGET("avx2,fma")
+void micro_kernel_avx2(int kc, const float32* a, const float32* b, float32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                       int mr, int nr, bool accumulate) {
+    half_kernel_avx2(kc, a, b, c, rs_c, cs_c, mr, std::min(nr, 16), accumulate);
+    if (nr > 16) half_kernel_avx2(kc, a, b + 16, c + 16 * cs_c, rs_c, cs_c, mr, nr - 16, accumulate);
+}
+
+// 12 zmm accumulators: two FMAs per broadcast, enough independent chains to cover the latency
+CPPTENSOR_TARGET("avx512f")
+void micro_kernel_avx512(int kc, const float32* a, const float32* b, float32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                         int mr, int nr, bool accumulate) {
+    __m512 acc[MR][2];
+    for (int i = 0; i < MR; i++) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+    for (int p = 0; p < kc; p++) {
+        __m512 b0 = _mm512_loadu_ps(b);
+        __m512 b1 = _mm512_loadu_ps(b + 16);
+        for (int i = 0; i < MR; i++) {
+            __m512 av = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(av, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(av, b1, acc[i][1]);
+        }
+        a += MR;
+        b += NR;
+    }
+
+    if (mr == MR && nr == NR && cs_c == 1) {
+        for (int i = 0; i < MR; i++) {
+            float32* c_row = c + i * rs_c;
+            if (accumulate) {
+                acc[i][0] = _mm512_add_ps(acc[i][0], _mm512_loadu_ps(c_row));
+                acc[i][1] = _mm512_add_ps(acc[i][1], _mm512_loadu_ps(c_row + 16));
+            }
+            _mm512_storeu_ps(c_row, acc[i][0]);
+            _mm512_storeu_ps(c_row + 16, acc[i][1]);
+        }
+        return;
+    }
+    float32 tile[MR][NR];
+    for (int i = 0; i < MR; i++) {
+        _mm512_storeu_ps(tile[i], acc[i][0]);
+        _mm512_storeu_ps(tile[i] + 16, acc[i][1]);
+    }
+    store_tile(tile, c, rs_c, cs_c, mr, nr, accumulate);
+}
+
+#endif // CPPTENSOR_X86
+
+} // namespace
+
+
+cpu::gemm_detail::micro_kernel_fn<float32> cpu::gemm_micro_kernel_f32() {
+    static const gemm_detail::micro_kernel_fn<float32> kernel = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return micro_kernel_avx512;
+            case SimdLevel::AVX2:   return micro_kernel_avx2;
+            default: break;
+        }
+#endif
+        return gemm_detail::micro_kernel<float32, MR, NR>;
+    }();
+    return kernel;
+}
@@ -0,0 +1,40 @@
+#include "graph.hpp"
+
+#include <numeric>
+
+
+size_t graph::plan_arena(const std::vector<BufferLifetime>& buffers, std::vector<size_t>& offsets) {
+    auto aligned = [](size_t bytes) { return (bytes + memory::ALIGNMENT - 1) / memory::ALIGNMENT * memory::ALIGNMENT; };
+
+    // Largest buffers first, each at the lowest offset that is free during its whole lifetime
+    std::vector<size_t> order(buffers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return buffers[a].bytes > buffers[b].bytes; });
+
+    offsets.assign(buffers.size(), 0);
+    std::vector<size_t> placed;
+    size_t arena_bytes = 0;
+    for (size_t i : order) {
+        const BufferLifetime& buffer = buffers[i];
+        size_t bytes = aligned(buffer.bytes);
+
+        // Ranges of the arena taken by placed buffers alive at the same time
+        std::vector<std::pair<size_t, size_t>> taken;
+        for (size_t j : placed) {
+            if (buffers[j].first_op <= buffer.last_op && buffer.first_op <= buffers[j].last_op) {
+                taken.push_back({offsets[j], offsets[j] + aligned(buffers[j].bytes)});
+            }
+        }
+        std::sort(taken.begin(), taken.end());
+
+        size_t offset = 0;
+        for (const auto& [begin, end] : taken) {
+            if (offset + bytes <= begin) break;
+            offset = std::max(offset, end);
+        }
+        offsets[i] = offset;
+        placed.push_back(i);
+        arena_bytes = std::max(arena_bytes, offset + bytes);
+    }
+    return arena_bytes;
+}
@@ -0,0 +1,323 @@
+#ifndef GRAPH_HPP
+#define GRAPH_HPP
+
+#include "tensor.hpp"
+#include "utils.hpp"
+#include "cpu_ops.hpp"
+#include "allocator.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Capture and replay of a fixed sequence of ops. While a Capture is active on a thread, the
+// F:: add, mul (tensor and scalar forms) and matmul calls on Tensor<T> run as usual and are
+// also recorded. The resulting Graph replays them on new inputs of the same shapes, calling
+// the kernels directly: shapes were validated and broadcast once at capture, and the
+// intermediates live at offsets of one arena planned ahead of time.
+namespace graph {
+
+// COPY copies a into out, for the out= ops that go through a temporary
+enum class OpKind { ADD, MUL, ADD_SCALAR, MUL_SCALAR, MATMUL, COPY };
+
+// Size of a buffer and the ops that define it and last use it (indices into the sequence)
+struct BufferLifetime {
+    size_t bytes;
+    int first_op;
+    int last_op;
+};
+
+// Places the buffers in one arena, buffers alive at the same time never overlapping. Fills
+// offsets (in bytes, memory::ALIGNMENT aligned) and returns the arena size in bytes.
+size_t plan_arena(const std::vector<BufferLifetime>& buffers, std::vector<size_t>& offsets);
+
+// One recorded op, with operands and out as the kernel received them (already broadcast)
+template<typename T>
+struct RecordedOp {
+    OpKind kind;
+    Tensor<T> a, b;  // b is empty for the scalar ops
+    Tensor<T> out;
+    T scalar = T();
+};
+
+// Tensor memory allocated while a capture is active
+template<typename T>
+struct Allocation {
+    std::weak_ptr<T[]> owner;  // Doesn't keep temporaries alive, and identifies their views
+    const T* begin;
+    size_t numel;
+};
+
+template<typename T>
+class Graph {
+public:
+    // Every tensor an op reads or writes is a view of one of:
+    // - an input: views of the inputs given to finish()/capture() are rebound to the inputs of run()
+    // - a buffer: memory allocated during the capture and first written by an op (its result),
+    //   placed whole in the arena
+    // - a constant: memory that existed before the capture (e.g. weights), referenced rather than
+    //   copied: every run reads its current values, or writes it in place when it is the out of an op
+    // Memory allocated during the capture but filled by something that isn't recorded (e.g.
+    // contiguous(), to(), a reduction or a factory), or first written by an op only in part (e.g.
+    // zeros() written through a slice), can't be replayed: using it throws.
+    Graph(const std::vector<RecordedOp<T>>& ops, const std::vector<Allocation<T>>& allocations,
+          const std::vector<Tensor<T>>& inputs, const std::vector<Tensor<T>>& outputs);
+
+    // Runs fn(inputs) under a Capture and builds the graph of the ops it called
+    static Graph capture(const std::function<std::vector<Tensor<T>>(const std::vector<Tensor<T>>&)>& fn,
+                         const std::vector<Tensor<T>>& inputs);
+
+    // Replays the ops on inputs with the shapes and strides of the captured ones. Outputs in the
+    // arena are overwritten by the next run. Runs of a graph (and of its copies, which share the
+    // arena) are serialized.
+    std::vector<Tensor<T>> run(const std::vector<Tensor<T>>& inputs);
+
+    size_t num_ops() const { return steps.size(); }
+    size_t arena_bytes() const { return arena_size; }
+
+private:
+    struct Operand {
+        Tensor<T> tensor;           // Layout, and the data unless it views an input
+        int input = -1;             // Input it views, bound by run
+        int buffer = -1;            // Buffer it views, while the graph is built
+        std::ptrdiff_t offset = 0;  // Of its first element from the start of the input or buffer
+    };
+
+    struct Step {
+        OpKind kind;
+        Operand a, b, out;
+        T scalar;
+    };
+
+    static void bind(Operand& operand, const std::vector<Tensor<T>>& inputs) {
+        if (operand.input < 0) return;
+        const Tensor<T>& input = inputs[operand.input];
+        operand.tensor.data = std::shared_ptr<T[]>(input.data, input.data.get() + operand.offset);
+    }
+
+    static void unbind(Operand& operand) {
+        if (operand.input >= 0) operand.tensor.data = nullptr;
+    }
+
+    std::vector<Step> steps;
+    std::vector<Operand> output_views;
+    std::vector<Dims> input_shapes, input_strides;
+    std::shared_ptr<T[]> arena;
+    size_t arena_size = 0;
+    std::shared_ptr<std::mutex> run_mutex = std::make_shared<std::mutex>();
+};
+
+// Records the ops of this thread on Tensor<T> from construction until finish() or destruction.
+// Captures of the same dtype do not nest.
+template<typename T>
+class Capture {
+public:
+    Capture() {
+        if (current) throw std::runtime_error("A graph capture is already active on this thread");
+        current = this;
+    }
+    ~Capture() {
+        if (current == this) current = nullptr;
+    }
+    Capture(const Capture&) = delete;
+    Capture& operator=(const Capture&) = delete;
+
+    // Active capture of this thread, or nullptr
+    static Capture* active() { return current; }
+
+    void record(OpKind kind, const Tensor<T>& a, const Tensor<T>& b, const Tensor<T>& out, T scalar) {
+        ops.push_back({kind, a, b, out, scalar});
+    }
+
+    void allocated(const Tensor<T>& t) {
+        allocations.push_back({t.data, t.data.get(), t.numel});
+    }
+
+    // Ends the capture. inputs are the tensors replaced on every run and outputs the results
+    Graph<T> finish(const std::vector<Tensor<T>>& inputs, const std::vector<Tensor<T>>& outputs) {
+        if (current == this) current = nullptr;
+        return Graph<T>(ops, allocations, inputs, outputs);
+    }
+
+private:
+    static inline thread_local Capture* current = nullptr;
+    std::vector<RecordedOp<T>> ops;
+    std::vector<Allocation<T>> allocations;
+};
+
+// Hooks of the F:: ops: a thread_local load while no capture is active
+template<typename T>
+void record_op(OpKind kind, const Tensor<T>& a, const Tensor<T>& b, const Tensor<T>& out) {
+    if (Capture<T>* capture = Capture<T>::active()) capture->record(kind, a, b, out, T());
+}
+
+template<typename T>
+void record_op(OpKind kind, const Tensor<T>& a, T scalar, const Tensor<T>& out) {
+    if (Capture<T>* capture = Capture<T>::active()) capture->record(kind, a, Tensor<T>(), out, scalar);
+}
+
+// Hook of Tensor<T>::empty, to tell the results of ops from memory that existed before
+template<typename T>
+void record_allocation(const Tensor<T>& t) {
+    if (Capture<T>* capture = Capture<T>::active()) capture->allocated(t);
+}
+
+
+template<typename T>
+Graph<T>::Graph(const std::vector<RecordedOp<T>>& ops, const std::vector<Allocation<T>>& allocations,
+                const std::vector<Tensor<T>>& inputs, const std::vector<Tensor<T>>& outputs) {
+    struct Storage {
+        std::shared_ptr<T[]> owner;
+        const T* begin;  // Offsets of its views count from here
+        int input = -1;
+        int buffer = -1;
+    };
+    std::vector<Storage> storages;
+    std::vector<BufferLifetime> buffers;
+
+    auto find = [&](const Tensor<T>& t) {
+        for (size_t s = 0; s < storages.size(); s++) {
+            if (utils::shares_storage(storages[s].owner, t.data)) return static_cast<int>(s);
+        }
+        return -1;
+    };
+
+    // Allocation of the capture that t views, or -1
+    auto find_allocation = [&](const Tensor<T>& t) {
+        for (size_t i = 0; i < allocations.size(); i++) {
+            if (utils::shares_storage(allocations[i].owner.lock(), t.data)) return static_cast<int>(i);
+        }
+        return -1;
+    };
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (find(inputs[i]) >= 0) throw std::invalid_argument("Graph inputs must not share memory");
+        storages.push_back({inputs[i].data, inputs[i].data.get(), static_cast<int>(i), -1});
+        input_shapes.push_back(inputs[i].shape);
+        input_strides.push_back(inputs[i].strides);
+    }
+
+    auto resolve = [&](const Tensor<T>& t, int op_index, bool written) {
+        if (!t.data) return Operand{t};
+        int s = find(t);
+        if (s < 0) {
+            Storage storage{t.data, t.data.get()};
+            int a = find_allocation(t);
+            if (a >= 0) {
+                if (!written) {
+                    throw std::invalid_argument("A tensor created during the capture by an op that is not recorded "
+                                                "(e.g. contiguous(), to(), a reduction or a factory) is used by a "
+                                                "recorded op or returned; create it before the capture");
+                }
+                // Replays only reproduce what the op writes, so it must define every element. out is
+                // never a broadcast view, so numel elements of the allocation are all of it.
+                if (t.numel != allocations[a].numel) {
+                    throw std::invalid_argument("A tensor created during the capture is first written only in part "
+                                                "(e.g. through a slice), the rest can't be replayed; create it "
+                                                "before the capture or write it whole");
+                }
+                // The whole allocation, as other views of it may reach past this one
+                storage.begin = allocations[a].begin;
+                storage.buffer = static_cast<int>(buffers.size());
+                buffers.push_back({allocations[a].numel * sizeof(T), op_index, op_index});
+            }
+            storages.push_back(storage);
+            s = static_cast<int>(storages.size()) - 1;
+        }
+        const Storage& storage = storages[s];
+        if (storage.buffer >= 0) {
+            BufferLifetime& lifetime = buffers[storage.buffer];
+            lifetime.last_op = std::max(lifetime.last_op, op_index);
+        }
+        return Operand{t, storage.input, storage.buffer, t.data.get() - storage.begin};
+    };
+
+    for (size_t i = 0; i < ops.size(); i++) {
+        const RecordedOp<T>& op = ops[i];
+        int index = static_cast<int>(i);
+        Operand a = resolve(op.a, index, false);
+        Operand b = resolve(op.b, index, false);
+        steps.push_back({op.kind, a, b, resolve(op.out, index, true), op.scalar});
+    }
+    // Outputs stay alive past the last op
+    for (const Tensor<T>& output : outputs) output_views.push_back(resolve(output, static_cast<int>(ops.size()), false));
+
+    std::vector<size_t> offsets;
+    arena_size = plan_arena(buffers, offsets);
+    if (arena_size > 0) arena = memory::allocate_shared<T>(arena_size / sizeof(T));
+
+    auto place = [&](Operand& operand) {
+        if (operand.buffer >= 0) {
+            T* first = arena.get() + offsets[operand.buffer] / sizeof(T) + operand.offset;
+            operand.tensor.data = std::shared_ptr<T[]>(arena, first);
+            operand.buffer = -1;
+        }
+        unbind(operand);  // Views of the inputs of the capture are rebound on every run
+    };
+    for (Step& step : steps) {
+        place(step.a);
+        place(step.b);
+        place(step.out);
+    }
+    for (Operand& output : output_views) place(output);
+}
+
+template<typename T>
+Graph<T> Graph<T>::capture(const std::function<std::vector<Tensor<T>>(const std::vector<Tensor<T>>&)>& fn,
+                           const std::vector<Tensor<T>>& inputs) {
+    Capture<T> capture;
+    std::vector<Tensor<T>> outputs = fn(inputs);
+    return capture.finish(inputs, outputs);
+}
+
+template<typename T>
+std::vector<Tensor<T>> Graph<T>::run(const std::vector<Tensor<T>>& inputs) {
+    if (inputs.size() != input_shapes.size()) {
+        throw std::invalid_argument("Graph takes " + std::to_string(input_shapes.size()) + " inputs, got " +
+                                    std::to_string(inputs.size()));
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (!utils::shapes_equal(inputs[i].shape, input_shapes[i]) || !utils::shapes_equal(inputs[i].strides, input_strides[i])) {
+            throw std::invalid_argument("Input " + std::to_string(i) + " has shape " + utils::vector_to_string(inputs[i].shape) +
+                                        " and strides " + utils::vector_to_string(inputs[i].strides) +
+                                        ", but the graph was captured with shape " + utils::vector_to_string(input_shapes[i]) +
+                                        " and strides " + utils::vector_to_string(input_strides[i]));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(*run_mutex);
+    for (Step& step : steps) {
+        bind(step.a, inputs);
+        bind(step.b, inputs);
+        bind(step.out, inputs);
+        switch (step.kind) {
+            case OpKind::ADD: cpu::add_forward(step.a.tensor, step.b.tensor, step.out.tensor); break;
+            case OpKind::MUL: cpu::mul_forward(step.a.tensor, step.b.tensor, step.out.tensor); break;
+            case OpKind::ADD_SCALAR: cpu::add_scalar_forward(step.a.tensor, step.scalar, step.out.tensor); break;
+            case OpKind::MUL_SCALAR: cpu::mul_scalar_forward(step.a.tensor, step.scalar, step.out.tensor); break;
+            case OpKind::MATMUL: cpu::matmul_forward(step.a.tensor, step.b.tensor, step.out.tensor); break;
+            case OpKind::COPY: cpu::copy_forward(step.a.tensor, step.out.tensor); break;
+        }
+        // Don't keep the inputs alive between runs
+        unbind(step.a);
+        unbind(step.b);
+        unbind(step.out);
+    }
+
+    std::vector<Tensor<T>> results;
+    results.reserve(output_views.size());
+    for (Operand& output : output_views) {
+        bind(output, inputs);
+        results.push_back(output.tensor);
+        unbind(output);
+    }
+    return results;
+}
+
+} // namespace graph
+
+#endif
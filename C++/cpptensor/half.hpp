@@ -0,0 +1,159 @@
+#ifndef HALF_HPP
+#define HALF_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+
+// Half-precision storage types. They only hold the 16 bits: arithmetic converts them to
+// float32 (implicitly) and the result is rounded back to nearest-even when stored.
+// Bulk conversions use the vectorized kernels in simd_kernels.hpp.
+
+namespace half_detail {
+
+inline uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bits_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// IEEE binary16 <-> binary32, round to nearest-even, NaN stays NaN
+inline uint16_t float_to_half(float value) {
+    const uint32_t f32_infinity = 255u << 23;
+    const uint32_t f16_overflow = (127u + 16) << 23;             // 65536, first value rounding to inf
+    const uint32_t subnormal_magic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+    uint32_t bits = float_bits(value);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t half;
+    if (bits >= f16_overflow) {
+        half = bits > f32_infinity ? 0x7E00 : 0x7C00;
+    } else if (bits < (113u << 23)) {
+        // Subnormal or zero: let the float adder align and round the mantissa
+        half = static_cast<uint16_t>(float_bits(bits_float(bits) + bits_float(subnormal_magic)) - subnormal_magic);
+    } else {
+        uint32_t mantissa_odd = (bits >> 13) & 1;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF + mantissa_odd;
+        half = static_cast<uint16_t>(bits >> 13);
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+inline float half_to_float(uint16_t half) {
+    const uint32_t exponent_mask = 0x7C00u << 13;
+    uint32_t bits = (half & 0x7FFFu) << 13;
+    uint32_t exponent = bits & exponent_mask;
+    bits += (127u - 15) << 23;
+    if (exponent == exponent_mask) {
+        bits += (128u - 16) << 23;                                // Inf / NaN
+    } else if (exponent == 0) {
+        bits += 1u << 23;                                         // Zero / subnormal, renormalized
+        bits = float_bits(bits_float(bits) - bits_float(113u << 23));
+    }
+    return bits_float(bits | (static_cast<uint32_t>(half & 0x8000u) << 16));
+}
+
+// bfloat16 is the upper half of a binary32: round to nearest-even, keep NaN quiet
+inline uint16_t float_to_bfloat16(float value) {
+    uint32_t bits = float_bits(value);
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u) return static_cast<uint16_t>((bits >> 16) | 0x0040);
+    bits += 0x7FFF + ((bits >> 16) & 1);
+    return static_cast<uint16_t>(bits >> 16);
+}
+
+inline float bfloat16_to_float(uint16_t value) {
+    return bits_float(static_cast<uint32_t>(value) << 16);
+}
+
+} // namespace half_detail
+
+struct float16 {
+    uint16_t bits;
+
+    float16() = default;
+    float16(float value) : bits(half_detail::float_to_half(value)) {}
+    operator float() const { return half_detail::half_to_float(bits); }
+
+    static constexpr float16 from_bits(uint16_t bits) {
+        float16 result{};
+        result.bits = bits;
+        return result;
+    }
+};
+
+struct bfloat16 {
+    uint16_t bits;
+
+    bfloat16() = default;
+    bfloat16(float value) : bits(half_detail::float_to_bfloat16(value)) {}
+    operator float() const { return half_detail::bfloat16_to_float(bits); }
+
+    static constexpr bfloat16 from_bits(uint16_t bits) {
+        bfloat16 result{};
+        result.bits = bits;
+        return result;
+    }
+};
+
+// Storage types computed in float32
+template<typename T>
+constexpr bool is_half_v = std::is_same_v<T, float16> || std::is_same_v<T, bfloat16>;
+
+
+namespace std {
+
+template<>
+class numeric_limits<float16> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr int digits = 11;
+    static constexpr int max_exponent = 16;
+    static constexpr int min_exponent = -13;
+
+    static constexpr float16 min() { return float16::from_bits(0x0400); }
+    static constexpr float16 max() { return float16::from_bits(0x7BFF); }
+    static constexpr float16 lowest() { return float16::from_bits(0xFBFF); }
+    static constexpr float16 epsilon() { return float16::from_bits(0x1400); }
+    static constexpr float16 infinity() { return float16::from_bits(0x7C00); }
+    static constexpr float16 quiet_NaN() { return float16::from_bits(0x7E00); }
+};
+
+template<>
+class numeric_limits<bfloat16> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr int digits = 8;
+    static constexpr int max_exponent = 128;
+    static constexpr int min_exponent = -125;
+
+    static constexpr bfloat16 min() { return bfloat16::from_bits(0x0080); }
+    static constexpr bfloat16 max() { return bfloat16::from_bits(0x7F7F); }
+    static constexpr bfloat16 lowest() { return bfloat16::from_bits(0xFF7F); }
+    static constexpr bfloat16 epsilon() { return bfloat16::from_bits(0x3C00); }
+    static constexpr bfloat16 infinity() { return bfloat16::from_bits(0x7F80); }
+    static constexpr bfloat16 quiet_NaN() { return bfloat16::from_bits(0x7FC0); }
+};
+
+} // namespace std
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef ITERATOR_HPP
+#define ITERATOR_HPP
+
+#include "parallel.hpp"
+#include "dims.hpp"
+
+#include <array>
+#include <cstddef>
+#include <algorithm>
+
+// Walks N operands that share a shape but each have their own strides (in elements).
+// Dimensions of size 1 are dropped and adjacent dimensions that are contiguous with each
+// other in every operand are merged, so the innermost run is as long as possible. Offsets
+// are advanced by stride increments, never recomputed from a flat index.
+template<int N>
+class StridedIterator {
+public:
+    using Offsets = std::array<std::ptrdiff_t, N>;
+
+    StridedIterator(const Dims& shape, const std::array<const Dims*, N>& strides) {
+        numel = 1;
+        for (int size : shape) numel *= size;
+
+        // Collect dims innermost first, skipping the ones that do not move any operand
+        for (int d = static_cast<int>(shape.size()) - 1; d >= 0; d--) {
+            if (shape[d] == 1) continue;
+            Offsets dim_strides;
+            for (int op = 0; op < N; op++) dim_strides[op] = (*strides[op])[d];
+
+            if (!dims.empty()) {
+                bool mergeable = true;
+                for (int op = 0; op < N; op++) {
+                    if (dim_strides[op] != dims_strides.back()[op] * dims.back()) {
+                        mergeable = false;
+                        break;
+                    }
+                }
+                if (mergeable) {
+                    dims.back() *= shape[d];
+                    continue;
+                }
+            }
+            dims.push_back(shape[d]);
+            dims_strides.push_back(dim_strides);
+        }
+
+        if (dims.empty()) {
+            dims.push_back(1);
+            dims_strides.push_back(Offsets{});
+        }
+    }
+
+    // Number of elements walked by each call of the inner loop
+    size_t inner_size() const { return static_cast<size_t>(dims[0]); }
+    const Offsets& inner_strides() const { return dims_strides[0]; }
+
+    // Number of inner runs
+    size_t outer_size() const { return numel == 0 ? 0 : numel / inner_size(); }
+
+    // Number of merged dimensions left after coalescing
+    int ndim() const { return static_cast<int>(dims.size()); }
+
+    // Call fn(offsets, inner_size, inner_strides) for the inner runs [begin, end),
+    // where offsets holds the start of the run in each operand
+    template<typename Fn>
+    void for_each(size_t begin, size_t end, Fn&& fn) const {
+        if (begin >= end) return;
+        int outer_dims = static_cast<int>(dims.size()) - 1;
+        Dims counter(outer_dims, 0);
+        Offsets offsets{};
+
+        // Position the counters on the first run of the range
+        size_t rem = begin;
+        for (int d = 1; d <= outer_dims; d++) {
+            counter[d - 1] = static_cast<int>(rem % dims[d]);
+            rem /= dims[d];
+            for (int op = 0; op < N; op++) offsets[op] += counter[d - 1] * dims_strides[d][op];
+        }
+
+        size_t inner = inner_size();
+        const Offsets& inner_step = dims_strides[0];
+        for (size_t run = begin; run < end; run++) {
+            fn(static_cast<const Offsets&>(offsets), inner, inner_step);
+
+            for (int d = 1; d <= outer_dims; d++) {
+                const Offsets& step = dims_strides[d];
+                if (++counter[d - 1] < dims[d]) {
+                    for (int op = 0; op < N; op++) offsets[op] += step[op];
+                    break;
+                }
+                counter[d - 1] = 0;
+                for (int op = 0; op < N; op++) offsets[op] -= step[op] * (dims[d] - 1);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for_each(0, outer_size(), fn);
+    }
+
+private:
+    size_t numel;
+    Dims dims;            // Merged dimension sizes, innermost first
+    SmallVector<Offsets, INLINE_DIMS> dims_strides;  // Stride of every operand along each merged dimension
+};
+
+// Run fn(offsets, size, strides) over every inner run of iter on the thread pool, giving each
+// thread at least `grain` elements. A single long run (dense operands) is split as well.
+template<int N, typename Fn>
+void parallel_for_each(const StridedIterator<N>& iter, size_t grain, Fn&& fn) {
+    size_t inner = iter.inner_size();
+    const auto& inner_strides = iter.inner_strides();
+
+    if (iter.outer_size() == 1) {
+        parallel::parallel_for(0, inner, grain, [&](size_t begin, size_t end) {
+            typename StridedIterator<N>::Offsets offsets;
+            for (int op = 0; op < N; op++) offsets[op] = static_cast<std::ptrdiff_t>(begin) * inner_strides[op];
+            fn(static_cast<const typename StridedIterator<N>::Offsets&>(offsets), end - begin, inner_strides);
+        });
+        return;
+    }
+
+    size_t runs_grain = std::max<size_t>(1, grain / std::max<size_t>(inner, 1));
+    parallel::parallel_for(0, iter.outer_size(), runs_grain, [&](size_t begin, size_t end) {
+        iter.for_each(begin, end, fn);
+    });
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+thread_local bool inside_task = false;
+
+// State shared by the chunks of a single parallel_for call
+struct Job {
+    std::function<void(size_t, size_t)> fn;
+    std::atomic<size_t> remaining{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+struct Task {
+    std::shared_ptr<Job> job;
+    size_t begin;
+    size_t end;
+};
+
+void run_task(const Task& task) {
+    bool was_inside = inside_task;
+    inside_task = true;
+    try {
+        task.job->fn(task.begin, task.end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.job->mutex);
+        if (!task.job->error) task.job->error = std::current_exception();
+    }
+    inside_task = was_inside;
+
+    if (task.job->remaining.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(task.job->mutex);
+        task.job->done.notify_all();
+    }
+}
+
+int default_num_threads() {
+    if (const char* env = std::getenv("CPPTENSOR_NUM_THREADS")) {
+        int n = std::atoi(env);
+        if (n > 0) return n;
+    }
+    unsigned int hw = std::thread::hardware_concurrency();
+    return hw > 0 ? static_cast<int>(hw) : 1;
+}
+
+// Persistent pool of (num_threads - 1) workers; the calling thread runs chunks as well.
+// Several Python/C++ threads may submit jobs at the same time, they share the queue.
+class ThreadPool {
+public:
+    explicit ThreadPool(int num_threads) : num_threads(num_threads) {
+        for (int i = 0; i < num_threads - 1; i++) {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    int size() const { return num_threads; }
+
+    void run(const std::shared_ptr<Job>& job, std::vector<Task>& tasks) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 1; i < tasks.size(); i++) queue.push_back(tasks[i]);
+        }
+        cv.notify_all();
+        run_task(tasks[0]);
+
+        // Help draining the queue instead of idling until the workers finish
+        while (job->remaining.load() > 0) {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (queue.empty()) break;
+                task = queue.front();
+                queue.pop_front();
+            }
+            run_task(task);
+        }
+
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->done.wait(lock, [&] { return job->remaining.load() == 0; });
+    }
+
+private:
+    void worker_loop() {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stop || !queue.empty(); });
+                if (stop && queue.empty()) return;
+                task = queue.front();
+                queue.pop_front();
+            }
+            run_task(task);
+        }
+    }
+
+    int num_threads;
+    std::vector<std::thread> workers;
+    std::deque<Task> queue;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+};
+
+std::mutex pool_mutex;
+std::shared_ptr<ThreadPool> pool;
+
+std::shared_ptr<ThreadPool> get_pool() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!pool) pool = std::make_shared<ThreadPool>(default_num_threads());
+    return pool;
+}
+
+} // namespace
+
+
+void parallel::set_num_threads(int num_threads) {
+    if (num_threads < 1) {
+        throw std::invalid_argument("Number of threads must be at least 1");
+    }
+    std::shared_ptr<ThreadPool> old_pool;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (pool && pool->size() == num_threads) return;
+        old_pool = pool;
+        pool = std::make_shared<ThreadPool>(num_threads);
+    }
+    // Jobs still running on the old pool keep it alive until they finish
+}
+
+int parallel::get_num_threads() {
+    return get_pool()->size();
+}
+
+bool parallel::in_parallel_region() {
+    return inside_task;
+}
+
+void parallel::parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (begin >= end) return;
+    size_t range = end - begin;
+    grain = std::max<size_t>(grain, 1);
+
+    // Small ranges run inline without touching the pool
+    if (range <= grain || inside_task) {
+        fn(begin, end);
+        return;
+    }
+
+    std::shared_ptr<ThreadPool> current = get_pool();
+    size_t nchunks = std::min(static_cast<size_t>(current->size()), (range + grain - 1) / grain);
+    if (nchunks <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->fn = fn;
+    job->remaining.store(nchunks);
+
+    std::vector<Task> tasks(nchunks);
+    size_t chunk = range / nchunks;
+    size_t extra = range % nchunks;
+    size_t start = begin;
+    for (size_t i = 0; i < nchunks; i++) {
+        size_t len = chunk + (i < extra ? 1 : 0);
+        tasks[i] = Task{job, start, start + len};
+        start += len;
+    }
+
+    current->run(job, tasks);
+    if (job->error) std::rethrow_exception(job->error);
+}
@@ -0,0 +1,23 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace parallel {
+
+// Number of threads used by the parallel kernels. Defaults to the CPPTENSOR_NUM_THREADS
+// environment variable or, if unset, to the number of hardware threads.
+void set_num_threads(int num_threads);
+int get_num_threads();
+
+// True while running inside a parallel_for task (nested regions run serially)
+bool in_parallel_region();
+
+// Split [begin, end) into chunks of at least `grain` elements and run fn(chunk_begin, chunk_end)
+// on the thread pool. Blocks until every chunk is done and rethrows the first exception raised.
+void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+} // namespace parallel
+
+#endif
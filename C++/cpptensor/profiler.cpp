@@ -0,0 +1,142 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+
+std::atomic<bool> profiler::detail::enabled{false};
+
+namespace {
+
+std::mutex events_mutex;
+std::vector<profiler::Event> recorded;
+
+uint32_t current_thread_id() {
+    static std::atomic<uint32_t> next_id{0};
+    thread_local uint32_t id = next_id++;
+    return id;
+}
+
+std::string json_escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+
+void profiler::set_enabled(bool enabled) {
+    detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::vector<profiler::Event> profiler::events() {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    return recorded;
+}
+
+void profiler::clear() {
+    std::lock_guard<std::mutex> lock(events_mutex);
+    recorded.clear();
+}
+
+void profiler::record(Event&& event) {
+    event.thread_id = current_thread_id();
+    std::lock_guard<std::mutex> lock(events_mutex);
+    recorded.push_back(std::move(event));
+}
+
+void profiler::Scope::describe(std::initializer_list<const Dims*> shapes, const std::string& dtype,
+                               uint64_t bytes, uint64_t flops) {
+    this->shapes.clear();
+    for (const Dims* shape : shapes) {
+        if (!this->shapes.empty()) this->shapes += ' ';
+        this->shapes += '[';
+        for (size_t i = 0; i < shape->size(); i++) {
+            this->shapes += (i ? ", " : "") + std::to_string((*shape)[i]);
+        }
+        this->shapes += ']';
+    }
+    this->dtype = dtype;
+    this->bytes = bytes;
+    this->flops = flops;
+}
+
+void profiler::Scope::finish() {
+    Event event;
+    event.name = name;
+    event.shapes = std::move(shapes);
+    event.dtype = std::move(dtype);
+    event.start_ns = start;
+    event.duration_ns = now_ns() - start;
+    event.bytes = bytes;
+    event.flops = flops;
+    record(std::move(event));
+}
+
+std::string profiler::summary() {
+    struct Row {
+        size_t calls = 0;
+        uint64_t total_ns = 0, max_ns = 0, bytes = 0, flops = 0;
+    };
+    std::map<std::pair<std::string, std::string>, Row> rows;
+    for (const Event& e : events()) {
+        Row& row = rows[{e.name, e.dtype}];
+        row.calls++;
+        row.total_ns += e.duration_ns;
+        row.max_ns = std::max(row.max_ns, e.duration_ns);
+        row.bytes += e.bytes;
+        row.flops += e.flops;
+    }
+
+    std::vector<std::pair<std::pair<std::string, std::string>, Row>> sorted(rows.begin(), rows.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.total_ns > b.second.total_ns; });
+
+    std::ostringstream os;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-16s %-16s %8s %12s %12s %12s %10s %10s\n",
+                  "op", "dtype", "calls", "total ms", "mean us", "max us", "GFLOP/s", "GB/s");
+    os << line;
+    for (const auto& [key, row] : sorted) {
+        double seconds = row.total_ns * 1e-9;
+        double gflops = seconds > 0 ? row.flops / seconds * 1e-9 : 0.0;
+        double gbytes = seconds > 0 ? row.bytes / seconds * 1e-9 : 0.0;
+        std::snprintf(line, sizeof(line), "%-16s %-16s %8zu %12.3f %12.2f %12.2f %10.2f %10.2f\n",
+                      key.first.c_str(), key.second.c_str(), row.calls, row.total_ns * 1e-6,
+                      row.total_ns * 1e-3 / row.calls, row.max_ns * 1e-3, gflops, gbytes);
+        os << line;
+    }
+    return os.str();
+}
+
+void profiler::export_chrome_trace(const std::string& path) {
+    std::vector<Event> all = events();
+    uint64_t origin = all.empty() ? 0 : std::min_element(all.begin(), all.end(), [](const Event& a, const Event& b) {
+        return a.start_ns < b.start_ns;
+    })->start_ns;
+
+    std::ofstream file(path);
+    if (!file) throw std::runtime_error("Cannot open " + path + " for writing");
+    file << "{\"traceEvents\": [\n";
+    char times[64];
+    for (size_t i = 0; i < all.size(); i++) {
+        const Event& e = all[i];
+        // Complete events, timestamps in microseconds
+        std::snprintf(times, sizeof(times), "\"ts\": %.3f, \"dur\": %.3f", (e.start_ns - origin) * 1e-3, e.duration_ns * 1e-3);
+        file << "  {\"name\": \"" << json_escape(e.name) << "\", \"cat\": \"op\", \"ph\": \"X\", " << times
+             << ", \"pid\": 0, \"tid\": " << e.thread_id
+             << ", \"args\": {\"shapes\": \"" << json_escape(e.shapes) << "\", \"dtype\": \"" << json_escape(e.dtype)
+             << "\", \"bytes\": " << e.bytes << ", \"flops\": " << e.flops << "}}"
+             << (i + 1 < all.size() ? "," : "") << "\n";
+    }
+    file << "], \"displayTimeUnit\": \"ms\"}\n";
+    if (!file) throw std::runtime_error("Cannot write " + path);
+}
@@ -0,0 +1,86 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "dims.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Opt-in per-op profiler. Instrumented ops open a Scope; while profiling is disabled that is a
+// single relaxed load, and nothing is formatted or recorded.
+namespace profiler {
+
+struct Event {
+    std::string name;
+    std::string shapes;      // Operand shapes, e.g. "[64, 32] [32, 16]"
+    std::string dtype;
+    uint64_t start_ns = 0;   // Steady clock
+    uint64_t duration_ns = 0;
+    uint32_t thread_id = 0;  // Small index given to each thread on its first event
+    uint64_t bytes = 0;      // Read and written
+    uint64_t flops = 0;
+};
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}
+
+inline bool is_enabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+void set_enabled(bool enabled);
+
+// Recorded events, in completion order
+std::vector<Event> events();
+void clear();
+
+// Events grouped by op and dtype: calls, total/mean/max time, GFLOP/s and GB/s, slowest first
+std::string summary();
+
+// Writes the events as a Chrome trace_event JSON file (chrome://tracing, Perfetto)
+void export_chrome_trace(const std::string& path);
+
+void record(Event&& event);
+
+inline uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Times the enclosing scope as one event if profiling is enabled when it starts. The op
+// details are optional and only worth computing when active().
+class Scope {
+public:
+    explicit Scope(const char* name) : name(name), start(is_enabled() ? now_ns() : 0) {}
+
+    ~Scope() {
+        if (start != 0) finish();
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    bool active() const { return start != 0; }
+
+    void describe(std::initializer_list<const Dims*> shapes, const std::string& dtype,
+                  uint64_t bytes, uint64_t flops);
+
+private:
+    void finish();
+
+    const char* name;
+    uint64_t start;
+    std::string shapes;
+    std::string dtype;
+    uint64_t bytes = 0;
+    uint64_t flops = 0;
+};
+
+} // namespace profiler
+
+#endif
@@ -0,0 +1,260 @@
+#include "qgemm.hpp"
+#include "cpu_features.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(CPPTENSOR_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Register tile of MR x NR int32 accumulators. K is consumed in pairs: packed panels hold
+// (k, k+1) int16 pairs, so one pmaddwd computes two multiply-adds per output lane.
+constexpr int MR = cpu::qgemm_blocking::MR, NR = cpu::qgemm_blocking::NR, KC = cpu::qgemm_blocking::KC,
+              MC = cpu::qgemm_blocking::MC, NC = cpu::qgemm_blocking::NC;
+
+// Minimum number of elements given to each thread by requantize
+const size_t REQUANTIZE_GRAIN = 1 << 16;
+
+using qkernel = void (*)(int kp, const int16_t* a, const int16_t* b, int32* c, std::ptrdiff_t rs_c,
+                         std::ptrdiff_t cs_c, int mr, int nr, bool accumulate);
+
+// Copy an mc x kc block of A into panels of MR rows. Each k-pair stores MR (a[k], a[k+1]) pairs.
+void pack_a(int mc, int kc, const uint8* a, std::ptrdiff_t rs, std::ptrdiff_t cs, int32 zero, int16_t* packed) {
+    for (int ir = 0; ir < mc; ir += MR) {
+        int mr = std::min(MR, mc - ir);
+        for (int p = 0; p < kc; p += 2) {
+            for (int i = 0; i < MR; i++) {
+                const uint8* a_row = a + (ir + i) * rs + p * cs;
+                packed[0] = i < mr ? static_cast<int16_t>(a_row[0] - zero) : 0;
+                packed[1] = i < mr && p + 1 < kc ? static_cast<int16_t>(a_row[cs] - zero) : 0;
+                packed += 2;
+            }
+        }
+    }
+}
+
+// Copy a kc x nc block of B into panels of NR columns. Each k-pair stores NR (b[k], b[k+1]) pairs.
+void pack_b(int kc, int nc, const uint8* b, std::ptrdiff_t rs, std::ptrdiff_t cs, int32 zero, int16_t* packed) {
+    for (int jr = 0; jr < nc; jr += NR) {
+        int nr = std::min(NR, nc - jr);
+        for (int p = 0; p < kc; p += 2) {
+            const uint8* b_row = b + p * rs + jr * cs;
+            bool has_next = p + 1 < kc;
+            for (int j = 0; j < NR; j++) {
+                packed[0] = j < nr ? static_cast<int16_t>(b_row[j * cs] - zero) : 0;
+                packed[1] = j < nr && has_next ? static_cast<int16_t>(b_row[rs + j * cs] - zero) : 0;
+                packed += 2;
+            }
+        }
+    }
+}
+
+void store_tile(const int32 (&acc)[MR][NR], int32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c, int mr, int nr, bool accumulate) {
+    for (int i = 0; i < mr; i++) {
+        int32* c_row = c + i * rs_c;
+        if (accumulate) {
+            for (int j = 0; j < nr; j++) c_row[j * cs_c] += acc[i][j];
+        } else {
+            for (int j = 0; j < nr; j++) c_row[j * cs_c] = acc[i][j];
+        }
+    }
+}
+
+// Broadcast value of a packed (a[k], a[k+1]) pair as one 32-bit word
+inline int32 load_pair(const int16_t* a) {
+    int32 pair;
+    std::memcpy(&pair, a, sizeof(pair));
+    return pair;
+}
+
+void qkernel_scalar(int kp, const int16_t* a, const int16_t* b, int32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                    int mr, int nr, bool accumulate) {
+    int32 acc[MR][NR] = {};
+    for (int p = 0; p < kp; p++) {
+        for (int i = 0; i < MR; i++) {
+            int32 a0 = a[2 * i], a1 = a[2 * i + 1];
+            for (int j = 0; j < NR; j++) acc[i][j] += a0 * b[2 * j] + a1 * b[2 * j + 1];
+        }
+        a += 2 * MR;
+        b += 2 * NR;
+    }
+    store_tile(acc, c, rs_c, cs_c, mr, nr, accumulate);
+}
+
+#if defined(CPPTENSOR_X86)
+
+CPPTENSOR_TARGET("sse4.2")
+void qkernel_sse42(int kp, const int16_t* a, const int16_t* b, int32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                   int mr, int nr, bool accumulate) {
+    __m128i acc[MR][4];
+    for (int i = 0; i < MR; i++) {
+        for (int v = 0; v < 4; v++) acc[i][v] = _mm_setzero_si128();
+    }
+    for (int p = 0; p < kp; p++) {
+        __m128i bv[4];
+        for (int v = 0; v < 4; v++) bv[v] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b) + v);
+        for (int i = 0; i < MR; i++) {
+            __m128i av = _mm_set1_epi32(load_pair(a + 2 * i));
+            for (int v = 0; v < 4; v++) acc[i][v] = _mm_add_epi32(acc[i][v], _mm_madd_epi16(av, bv[v]));
+        }
+        a += 2 * MR;
+        b += 2 * NR;
+    }
+    int32 tile[MR][NR];
+    for (int i = 0; i < MR; i++) {
+        for (int v = 0; v < 4; v++) _mm_storeu_si128(reinterpret_cast<__m128i*>(tile[i] + 4 * v), acc[i][v]);
+    }
+    store_tile(tile, c, rs_c, cs_c, mr, nr, accumulate);
+}
+
+CPPTENSOR_TARGET("avx2")
+void qkernel_avx2(int kp, const int16_t* a, const int16_t* b, int32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                  int mr, int nr, bool accumulate) {
+    __m256i acc[MR][2];
+    for (int i = 0; i < MR; i++) {
+        acc[i][0] = _mm256_setzero_si256();
+        acc[i][1] = _mm256_setzero_si256();
+    }
+    for (int p = 0; p < kp; p++) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b) + 1);
+        for (int i = 0; i < MR; i++) {
+            __m256i av = _mm256_set1_epi32(load_pair(a + 2 * i));
+            acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(av, b0));
+            acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(av, b1));
+        }
+        a += 2 * MR;
+        b += 2 * NR;
+    }
+    int32 tile[MR][NR];
+    for (int i = 0; i < MR; i++) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile[i]), acc[i][0]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile[i] + 8), acc[i][1]);
+    }
+    store_tile(tile, c, rs_c, cs_c, mr, nr, accumulate);
+}
+
+CPPTENSOR_TARGET("avx512f,avx512bw")
+void qkernel_avx512(int kp, const int16_t* a, const int16_t* b, int32* c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c,
+                    int mr, int nr, bool accumulate) {
+    __m512i acc[MR];
+    for (int i = 0; i < MR; i++) acc[i] = _mm512_setzero_si512();
+    for (int p = 0; p < kp; p++) {
+        __m512i bv = _mm512_loadu_si512(b);
+        for (int i = 0; i < MR; i++) {
+            __m512i av = _mm512_set1_epi32(load_pair(a + 2 * i));
+            acc[i] = _mm512_add_epi32(acc[i], _mm512_madd_epi16(av, bv));
+        }
+        a += 2 * MR;
+        b += 2 * NR;
+    }
+    int32 tile[MR][NR];
+    for (int i = 0; i < MR; i++) _mm512_storeu_si512(tile[i], acc[i]);
+    store_tile(tile, c, rs_c, cs_c, mr, nr, accumulate);
+}
+
+#endif // CPPTENSOR_X86
+
+// Micro-kernel for the best instruction set of the host, selected on first use from CPUID
+qkernel select_kernel() {
+    static const qkernel kernel = [] {
+#if defined(CPPTENSOR_X86)
+        switch (cpu::simd_level()) {
+            case cpu::SimdLevel::AVX512: return qkernel_avx512;
+            case cpu::SimdLevel::AVX2:   return qkernel_avx2;
+            case cpu::SimdLevel::SSE42:  return qkernel_sse42;
+            default: break;
+        }
+#endif
+        return qkernel_scalar;
+    }();
+    return kernel;
+}
+
+int16_t* packing_buffer(std::vector<int16_t>& buffer, size_t size) {
+    if (buffer.size() < size) buffer.resize(size);
+    return buffer.data();
+}
+
+} // namespace
+
+
+void cpu::qgemm_batched(int batch, int M, int N, int K, MatrixRef<const uint8> a, std::ptrdiff_t a_bs, int32 a_zero,
+                        MatrixRef<const uint8> b, std::ptrdiff_t b_bs, int32 b_zero, MatrixRef<int32> c, std::ptrdiff_t c_bs) {
+    if (batch <= 0 || M <= 0 || N <= 0) return;
+    if (K <= 0) {
+        for (int e = 0; e < batch; e++) {
+            int32* c_e = c.ptr + e * c_bs;
+            for (int i = 0; i < M; i++) {
+                for (int j = 0; j < N; j++) c_e[i * c.rs + j * c.cs] = 0;
+            }
+        }
+        return;
+    }
+
+    qkernel kernel = select_kernel();
+
+    // Each thread owns its packing buffers, so concurrent calls never share them
+    thread_local std::vector<int16_t> a_buffer;
+    thread_local std::vector<int16_t> b_buffer;
+
+    for (int jc = 0; jc < N; jc += NC) {
+        int nc = std::min(NC, N - jc);
+        int nc_padded = (nc + NR - 1) / NR * NR;
+
+        for (int pc = 0; pc < K; pc += KC) {
+            int kc = std::min(KC, K - pc);
+            int kp = (kc + 1) / 2;
+            bool accumulate = pc > 0;
+
+            int16_t* b_packed = packing_buffer(b_buffer, static_cast<size_t>(2 * kp) * nc_padded);
+            for (int e = 0; e < batch; e++) {
+                // A shared B is packed once per block for the whole batch
+                if (e == 0 || b_bs != 0) {
+                    pack_b(kc, nc, b.ptr + e * b_bs + pc * b.rs + jc * b.cs, b.rs, b.cs, b_zero, b_packed);
+                }
+                const uint8* a_e = a.ptr + e * a_bs;
+                int32* c_e = c.ptr + e * c_bs;
+
+                for (int ic = 0; ic < M; ic += MC) {
+                    int mc = std::min(MC, M - ic);
+                    int mc_padded = (mc + MR - 1) / MR * MR;
+
+                    int16_t* a_packed = packing_buffer(a_buffer, static_cast<size_t>(2 * kp) * mc_padded);
+                    pack_a(mc, kc, a_e + ic * a.rs + pc * a.cs, a.rs, a.cs, a_zero, a_packed);
+
+                    for (int jr = 0; jr < nc; jr += NR) {
+                        int nr = std::min(NR, nc - jr);
+                        for (int ir = 0; ir < mc; ir += MR) {
+                            int mr = std::min(MR, mc - ir);
+                            int32* c_tile = c_e + (ic + ir) * c.rs + (jc + jr) * c.cs;
+                            kernel(kp, a_packed + ir * 2 * kp, b_packed + jr * 2 * kp, c_tile, c.rs, c.cs, mr, nr, accumulate);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void cpu::qgemm(int M, int N, int K, MatrixRef<const uint8> a, int32 a_zero, MatrixRef<const uint8> b, int32 b_zero,
+                MatrixRef<int32> c) {
+    qgemm_batched(1, M, N, K, a, 0, a_zero, b, 0, b_zero, c, 0);
+}
+
+void cpu::requantize(const int32* acc, size_t n, float multiplier, int32 zero_point, uint8* out) {
+    float zero = static_cast<float>(zero_point);
+    parallel::parallel_for(0, n, REQUANTIZE_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float value = std::nearbyint(static_cast<float>(acc[i]) * multiplier) + zero;
+            out[i] = static_cast<uint8>(std::min(255.0f, std::max(0.0f, value)));
+        }
+    });
+}
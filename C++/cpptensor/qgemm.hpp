@@ -0,0 +1,36 @@
+#ifndef QGEMM_HPP
+#define QGEMM_HPP
+
+#include "dtype.hpp"
+#include "gemm.hpp"
+
+#include <cstddef>
+
+namespace cpu {
+
+// Largest K whose products sum without int32 overflow: |a - a_zero|, |b - b_zero| <= 255
+constexpr int QGEMM_MAX_K = 2147483647 / (255 * 255);
+
+// Register tile and cache blocks of the quantized GEMM (K is consumed in pairs)
+struct qgemm_blocking {
+    static constexpr int MR = 4, NR = 16, KC = 512, MC = 96, NC = 2048;
+};
+
+// C[M x N] = (A - a_zero)[M x K] * (B - b_zero)[K x N] for uint8 operands, accumulated in int32.
+// Operands are widened to int16 (zero point subtracted) while packed, and the micro-kernel uses
+// 16-bit multiply-add instructions (pmaddwd) selected from CPUID. C is overwritten.
+// Exact as long as K * 255 * 255 fits in int32, i.e. K <= QGEMM_MAX_K.
+void qgemm(int M, int N, int K, MatrixRef<const uint8> a, int32 a_zero, MatrixRef<const uint8> b, int32 b_zero,
+           MatrixRef<int32> c);
+
+// Strided batch of qgemm products, with batch strides as in gemm_batched (0 shares an operand,
+// and a shared B is packed once per block)
+void qgemm_batched(int batch, int M, int N, int K, MatrixRef<const uint8> a, std::ptrdiff_t a_bs, int32 a_zero,
+                   MatrixRef<const uint8> b, std::ptrdiff_t b_bs, int32 b_zero, MatrixRef<int32> c, std::ptrdiff_t c_bs);
+
+// out[i] = clamp(round(acc[i] * multiplier) + zero_point, 0, 255)
+void requantize(const int32* acc, size_t n, float multiplier, int32 zero_point, uint8* out);
+
+} // namespace cpu
+
+#endif
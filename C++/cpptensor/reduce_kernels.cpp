@@ -0,0 +1,456 @@
+#include "reduce_kernels.hpp"
+#include "cpu_features.hpp"
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+
+#if defined(CPPTENSOR_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Elements summed in float lanes before the partial sum is moved to double
+const size_t SUM_BLOCK = 1024;
+
+// Scalar fallbacks, also used for the tails of the vector loops
+template<typename T>
+int64_t sum_scalar(const T* a, size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; i++) total += a[i];
+    return total;
+}
+
+double sum_scalar(const float32* a, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+    for (; i + 8 <= n; ) {
+        size_t block_end = std::min(n - n % 8, i + SUM_BLOCK);
+        float32 lanes[8] = {};
+        for (; i < block_end; i += 8) {
+            for (int l = 0; l < 8; l++) lanes[l] += a[i + l];
+        }
+        total += ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+    for (; i < n; i++) total += a[i];
+    return total;
+}
+
+// NaN wins, then the larger (Max) or smaller value
+template<bool Max, typename T>
+T pick(T a, T b) {
+    if (a != a) return a;
+    if (b != b) return b;
+    return Max ? std::max(a, b) : std::min(a, b);
+}
+
+template<bool Max, typename T>
+T minmax_scalar(const T* a, size_t n) {
+    T best = a[0];
+    for (size_t i = 1; i < n; i++) best = pick<Max>(best, a[i]);
+    return best;
+}
+
+// Combine the lanes of a vector register (stored to memory) with the scalar tail
+template<bool Max, typename T>
+T finish_minmax(const T* lanes, int count, const T* tail, size_t tail_size) {
+    T best = minmax_scalar<Max>(lanes, count);
+    return tail_size > 0 ? pick<Max>(best, minmax_scalar<Max>(tail, tail_size)) : best;
+}
+
+#if defined(CPPTENSOR_X86)
+
+// ---------------------------------------------------------------- SSE4.2
+
+CPPTENSOR_TARGET("sse4.2")
+double sum_f32_sse42(const float32* a, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+    while (i + 16 <= n) {
+        size_t block_end = std::min(n - n % 16, i + SUM_BLOCK);
+        __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+        for (; i < block_end; i += 16) {
+            s0 = _mm_add_ps(s0, _mm_loadu_ps(a + i));
+            s1 = _mm_add_ps(s1, _mm_loadu_ps(a + i + 4));
+            s2 = _mm_add_ps(s2, _mm_loadu_ps(a + i + 8));
+            s3 = _mm_add_ps(s3, _mm_loadu_ps(a + i + 12));
+        }
+        alignas(16) float32 lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+        total += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+    return total + sum_scalar(a + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+int64_t sum_i32_sse42(const int32* a, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+    }
+    alignas(16) int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return lanes[0] + lanes[1] + sum_scalar(a + i, n - i);
+}
+
+// psadbw against zero adds groups of 8 bytes into 64-bit lanes
+CPPTENSOR_TARGET("sse4.2")
+int64_t sum_u8_sse42(const uint8* a, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+    alignas(16) int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return lanes[0] + lanes[1] + sum_scalar(a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("sse4.2")
+float32 minmax_f32_sse42(const float32* a, size_t n) {
+    if (n < 4) return minmax_scalar<Max>(a, n);
+    __m128 best = _mm_loadu_ps(a);
+    __m128 nan = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(a + i);
+        nan = _mm_or_ps(nan, _mm_cmpunord_ps(v, v));
+        best = Max ? _mm_max_ps(best, v) : _mm_min_ps(best, v);
+    }
+    if (_mm_movemask_ps(nan)) return minmax_scalar<Max>(a, n);
+    alignas(16) float32 lanes[4];
+    _mm_store_ps(lanes, best);
+    return finish_minmax<Max>(lanes, 4, a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("sse4.2")
+int32 minmax_i32_sse42(const int32* a, size_t n) {
+    if (n < 4) return minmax_scalar<Max>(a, n);
+    __m128i best = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        best = Max ? _mm_max_epi32(best, v) : _mm_min_epi32(best, v);
+    }
+    alignas(16) int32 lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), best);
+    return finish_minmax<Max>(lanes, 4, a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("sse4.2")
+uint8 minmax_u8_sse42(const uint8* a, size_t n) {
+    if (n < 16) return minmax_scalar<Max>(a, n);
+    __m128i best = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        best = Max ? _mm_max_epu8(best, v) : _mm_min_epu8(best, v);
+    }
+    alignas(16) uint8 lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), best);
+    return finish_minmax<Max>(lanes, 16, a + i, n - i);
+}
+
+// ---------------------------------------------------------------- AVX2
+
+CPPTENSOR_TARGET("avx2")
+double sum_f32_avx2(const float32* a, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+    while (i + 32 <= n) {
+        size_t block_end = std::min(n - n % 32, i + SUM_BLOCK);
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+        for (; i < block_end; i += 32) {
+            s0 = _mm256_add_ps(s0, _mm256_loadu_ps(a + i));
+            s1 = _mm256_add_ps(s1, _mm256_loadu_ps(a + i + 8));
+            s2 = _mm256_add_ps(s2, _mm256_loadu_ps(a + i + 16));
+            s3 = _mm256_add_ps(s3, _mm256_loadu_ps(a + i + 24));
+        }
+        alignas(32) float32 lanes[8];
+        _mm256_store_ps(lanes, _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+        total += ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+    return total + sum_scalar(a + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+int64_t sum_i32_avx2(const int32* a, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_scalar(a + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+int64_t sum_u8_avx2(const uint8* a, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_scalar(a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("avx2")
+float32 minmax_f32_avx2(const float32* a, size_t n) {
+    if (n < 8) return minmax_scalar<Max>(a, n);
+    __m256 best = _mm256_loadu_ps(a);
+    __m256 nan = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(a + i);
+        nan = _mm256_or_ps(nan, _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+        best = Max ? _mm256_max_ps(best, v) : _mm256_min_ps(best, v);
+    }
+    if (_mm256_movemask_ps(nan)) return minmax_scalar<Max>(a, n);
+    alignas(32) float32 lanes[8];
+    _mm256_store_ps(lanes, best);
+    return finish_minmax<Max>(lanes, 8, a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("avx2")
+int32 minmax_i32_avx2(const int32* a, size_t n) {
+    if (n < 8) return minmax_scalar<Max>(a, n);
+    __m256i best = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        best = Max ? _mm256_max_epi32(best, v) : _mm256_min_epi32(best, v);
+    }
+    alignas(32) int32 lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), best);
+    return finish_minmax<Max>(lanes, 8, a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("avx2")
+uint8 minmax_u8_avx2(const uint8* a, size_t n) {
+    if (n < 32) return minmax_scalar<Max>(a, n);
+    __m256i best = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        best = Max ? _mm256_max_epu8(best, v) : _mm256_min_epu8(best, v);
+    }
+    alignas(32) uint8 lanes[32];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), best);
+    return finish_minmax<Max>(lanes, 32, a + i, n - i);
+}
+
+// ---------------------------------------------------------------- AVX-512
+
+CPPTENSOR_TARGET("avx512f")
+double sum_f32_avx512(const float32* a, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+    while (i + 64 <= n) {
+        size_t block_end = std::min(n - n % 64, i + SUM_BLOCK);
+        __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps(), s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+        for (; i < block_end; i += 64) {
+            s0 = _mm512_add_ps(s0, _mm512_loadu_ps(a + i));
+            s1 = _mm512_add_ps(s1, _mm512_loadu_ps(a + i + 16));
+            s2 = _mm512_add_ps(s2, _mm512_loadu_ps(a + i + 32));
+            s3 = _mm512_add_ps(s3, _mm512_loadu_ps(a + i + 48));
+        }
+        total += _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3)));
+    }
+    return total + sum_scalar(a + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+int64_t sum_i32_avx512(const int32* a, size_t n) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(a + i);
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    return _mm512_reduce_add_epi64(acc) + sum_scalar(a + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f,avx512bw")
+int64_t sum_u8_avx512(const uint8* a, size_t n) {
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_loadu_si512(a + i), zero));
+    }
+    return _mm512_reduce_add_epi64(acc) + sum_scalar(a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("avx512f")
+float32 minmax_f32_avx512(const float32* a, size_t n) {
+    if (n < 16) return minmax_scalar<Max>(a, n);
+    __m512 best = _mm512_loadu_ps(a);
+    __mmask16 nan = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(a + i);
+        nan |= _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+        best = Max ? _mm512_max_ps(best, v) : _mm512_min_ps(best, v);
+    }
+    if (nan) return minmax_scalar<Max>(a, n);
+    alignas(64) float32 lanes[16];
+    _mm512_store_ps(lanes, best);
+    return finish_minmax<Max>(lanes, 16, a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("avx512f")
+int32 minmax_i32_avx512(const int32* a, size_t n) {
+    if (n < 16) return minmax_scalar<Max>(a, n);
+    __m512i best = _mm512_loadu_si512(a);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(a + i);
+        best = Max ? _mm512_max_epi32(best, v) : _mm512_min_epi32(best, v);
+    }
+    alignas(64) int32 lanes[16];
+    _mm512_store_si512(lanes, best);
+    return finish_minmax<Max>(lanes, 16, a + i, n - i);
+}
+
+template<bool Max>
+CPPTENSOR_TARGET("avx512f,avx512bw")
+uint8 minmax_u8_avx512(const uint8* a, size_t n) {
+    if (n < 64) return minmax_scalar<Max>(a, n);
+    __m512i best = _mm512_loadu_si512(a);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i v = _mm512_loadu_si512(a + i);
+        best = Max ? _mm512_max_epu8(best, v) : _mm512_min_epu8(best, v);
+    }
+    alignas(64) uint8 lanes[64];
+    _mm512_store_si512(lanes, best);
+    return finish_minmax<Max>(lanes, 64, a + i, n - i);
+}
+
+#endif // CPPTENSOR_X86
+
+template<typename T>
+cpu::ReduceKernels<T> scalar_kernels() {
+    return {sum_scalar, minmax_scalar<true, T>, minmax_scalar<false, T>};
+}
+
+// Half-precision inputs are widened in blocks that stay in L1 and reduced as float32
+const size_t HALF_BLOCK = 512;
+
+template<typename H>
+double sum_half(const H* a, size_t n) {
+    const cpu::ReduceKernels<float32>& f32 = cpu::reduce_kernels<float32>();
+    float32 block[HALF_BLOCK];
+    double total = 0.0;
+    for (size_t i = 0; i < n; i += HALF_BLOCK) {
+        size_t m = std::min(HALF_BLOCK, n - i);
+        cpu::to_float32(a + i, block, m);
+        total += f32.sum(block, m);
+    }
+    return total;
+}
+
+// Widening is exact, so the float32 extreme converts back to the original element
+template<bool Max, typename H>
+H minmax_half(const H* a, size_t n) {
+    const cpu::ReduceKernels<float32>& f32 = cpu::reduce_kernels<float32>();
+    float32 block[HALF_BLOCK];
+    float32 best = 0.0f;
+    for (size_t i = 0; i < n; i += HALF_BLOCK) {
+        size_t m = std::min(HALF_BLOCK, n - i);
+        cpu::to_float32(a + i, block, m);
+        float32 block_best = Max ? f32.max(block, m) : f32.min(block, m);
+        best = i == 0 ? block_best : pick<Max>(best, block_best);
+    }
+    return H(best);
+}
+
+template<typename H>
+cpu::ReduceKernels<H> half_reduce_kernels() {
+    return {sum_half<H>, minmax_half<true, H>, minmax_half<false, H>};
+}
+
+} // namespace
+
+
+template<>
+const cpu::ReduceKernels<float32>& cpu::reduce_kernels<float32>() {
+    static const ReduceKernels<float32> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ReduceKernels<float32>{sum_f32_avx512, minmax_f32_avx512<true>, minmax_f32_avx512<false>};
+            case SimdLevel::AVX2:   return ReduceKernels<float32>{sum_f32_avx2, minmax_f32_avx2<true>, minmax_f32_avx2<false>};
+            case SimdLevel::SSE42:  return ReduceKernels<float32>{sum_f32_sse42, minmax_f32_sse42<true>, minmax_f32_sse42<false>};
+            default: break;
+        }
+#endif
+        return scalar_kernels<float32>();
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ReduceKernels<int32>& cpu::reduce_kernels<int32>() {
+    static const ReduceKernels<int32> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ReduceKernels<int32>{sum_i32_avx512, minmax_i32_avx512<true>, minmax_i32_avx512<false>};
+            case SimdLevel::AVX2:   return ReduceKernels<int32>{sum_i32_avx2, minmax_i32_avx2<true>, minmax_i32_avx2<false>};
+            case SimdLevel::SSE42:  return ReduceKernels<int32>{sum_i32_sse42, minmax_i32_sse42<true>, minmax_i32_sse42<false>};
+            default: break;
+        }
+#endif
+        return scalar_kernels<int32>();
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ReduceKernels<uint8>& cpu::reduce_kernels<uint8>() {
+    static const ReduceKernels<uint8> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ReduceKernels<uint8>{sum_u8_avx512, minmax_u8_avx512<true>, minmax_u8_avx512<false>};
+            case SimdLevel::AVX2:   return ReduceKernels<uint8>{sum_u8_avx2, minmax_u8_avx2<true>, minmax_u8_avx2<false>};
+            case SimdLevel::SSE42:  return ReduceKernels<uint8>{sum_u8_sse42, minmax_u8_sse42<true>, minmax_u8_sse42<false>};
+            default: break;
+        }
+#endif
+        return scalar_kernels<uint8>();
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ReduceKernels<float16>& cpu::reduce_kernels<float16>() {
+    static const ReduceKernels<float16> kernels = half_reduce_kernels<float16>();
+    return kernels;
+}
+
+template<>
+const cpu::ReduceKernels<bfloat16>& cpu::reduce_kernels<bfloat16>() {
+    static const ReduceKernels<bfloat16> kernels = half_reduce_kernels<bfloat16>();
+    return kernels;
+}
@@ -0,0 +1,40 @@
+#ifndef REDUCE_KERNELS_HPP
+#define REDUCE_KERNELS_HPP
+
+#include "dtype.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cpu {
+
+// Accumulator of sums and products, wider than the storage type
+template<typename T>
+struct accumulate_type { using type = int64_t; };
+template<>
+struct accumulate_type<float32> { using type = double; };
+template<>
+struct accumulate_type<float16> { using type = double; };
+template<>
+struct accumulate_type<bfloat16> { using type = double; };
+
+template<typename T>
+using accumulate_t = typename accumulate_type<T>::type;
+
+template<typename T>
+struct ReduceKernels {
+    // Sum of n contiguous elements. float32 is summed pairwise: blocks in float lanes, blocks in double
+    accumulate_t<T> (*sum)(const T* a, size_t n);
+    // Largest / smallest of n > 0 contiguous elements, NaN if any element is NaN
+    T (*max)(const T* a, size_t n);
+    T (*min)(const T* a, size_t n);
+};
+
+// Kernels for the best instruction set of the host, selected on first use from CPUID.
+// float16 and bfloat16 are widened to float32 in blocks and reduced by the float32 kernels.
+template<typename T>
+const ReduceKernels<T>& reduce_kernels();
+
+} // namespace cpu
+
+#endif
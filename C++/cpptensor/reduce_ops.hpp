@@ -0,0 +1,330 @@
+#ifndef REDUCE_OPS_HPP
+#define REDUCE_OPS_HPP
+
+#include "tensor.hpp"
+#include "parallel.hpp"
+#include "iterator.hpp"
+#include "reduce_kernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace cpu {
+
+// Minimum number of input elements given to each thread by the parallel reductions
+const size_t REDUCE_GRAIN = 1 << 16;
+// Number of outputs updated together when whole rows are folded into them
+const size_t REDUCE_COLUMN_BLOCK = 1024;
+
+// Reducers fold the input elements of each output into an accumulator:
+//   init()                                 accumulator of an empty range
+//   run(acc, p, n, stride, pos)            fold n elements starting at p into acc; pos is the
+//                                          index of p in the reduced space (row-major)
+//   column(acc, p, n, stride, pos)         acc[i] = fold(acc[i], p[i * stride]) for n outputs
+//   merge(a, b)                            combine partial results, b from later positions
+//   finalize(acc, count)                   output value of count reduced elements
+
+template<typename T>
+struct SumReducer {
+    using Acc = accumulate_t<T>;
+    using Out = sum_result_t<T>;
+
+    const ReduceKernels<T>& kernels = reduce_kernels<T>();
+
+    Acc init() const { return Acc(0); }
+
+    Acc run(Acc acc, const T* p, size_t n, std::ptrdiff_t stride, size_t) const {
+        if (stride == 1) return acc + kernels.sum(p, n);
+        for (size_t i = 0; i < n; i++) acc += p[i * stride];
+        return acc;
+    }
+
+    void column(Acc* acc, const T* p, size_t n, std::ptrdiff_t stride, size_t) const {
+        if (stride == 1) {
+            for (size_t i = 0; i < n; i++) acc[i] += p[i];
+        } else {
+            for (size_t i = 0; i < n; i++) acc[i] += p[i * stride];
+        }
+    }
+
+    Acc merge(Acc a, Acc b) const { return a + b; }
+    Out finalize(Acc acc, size_t) const { return static_cast<Out>(acc); }
+};
+
+template<typename T>
+struct MeanReducer : SumReducer<T> {
+    using Out = float32;
+
+    Out finalize(typename SumReducer<T>::Acc acc, size_t count) const {
+        if (count == 0) return std::numeric_limits<float32>::quiet_NaN();
+        return static_cast<float32>(static_cast<double>(acc) / static_cast<double>(count));
+    }
+};
+
+template<typename T>
+struct ProdReducer {
+    using Acc = accumulate_t<T>;
+    using Out = sum_result_t<T>;
+
+    // Integer products wrap around like the storage types instead of overflowing a signed type
+    static Acc multiply(Acc a, Acc b) {
+        if constexpr (std::is_integral_v<Acc>) {
+            return static_cast<Acc>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+        } else {
+            return a * b;
+        }
+    }
+
+    Acc init() const { return Acc(1); }
+
+    Acc run(Acc acc, const T* p, size_t n, std::ptrdiff_t stride, size_t) const {
+        for (size_t i = 0; i < n; i++) acc = multiply(acc, p[i * stride]);
+        return acc;
+    }
+
+    void column(Acc* acc, const T* p, size_t n, std::ptrdiff_t stride, size_t) const {
+        for (size_t i = 0; i < n; i++) acc[i] = multiply(acc[i], p[i * stride]);
+    }
+
+    Acc merge(Acc a, Acc b) const { return multiply(a, b); }
+    Out finalize(Acc acc, size_t) const { return static_cast<Out>(acc); }
+};
+
+// NaN propagates, like NumPy
+template<typename T, bool Max>
+struct MinMaxReducer {
+    using Acc = T;
+    using Out = T;
+
+    const ReduceKernels<T>& kernels = reduce_kernels<T>();
+
+    static T pick(T a, T b) {
+        if (a != a) return a;
+        if (b != b) return b;
+        return Max ? std::max(a, b) : std::min(a, b);
+    }
+
+    Acc init() const { return Max ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max(); }
+
+    Acc run(Acc acc, const T* p, size_t n, std::ptrdiff_t stride, size_t) const {
+        if (stride == 1) return pick(acc, Max ? kernels.max(p, n) : kernels.min(p, n));
+        for (size_t i = 0; i < n; i++) acc = pick(acc, p[i * stride]);
+        return acc;
+    }
+
+    void column(Acc* acc, const T* p, size_t n, std::ptrdiff_t stride, size_t) const {
+        for (size_t i = 0; i < n; i++) acc[i] = pick(acc[i], p[i * stride]);
+    }
+
+    Acc merge(Acc a, Acc b) const { return pick(a, b); }
+    Out finalize(Acc acc, size_t) const { return acc; }
+};
+
+// Index of the first largest element (of the first NaN, if any)
+template<typename T>
+struct ArgmaxReducer {
+    struct Acc {
+        T value;
+        int64_t index;
+    };
+    using Out = int32;
+
+    const ReduceKernels<T>& kernels = reduce_kernels<T>();
+
+    // Whether x, found after everything in acc, replaces it
+    static bool better(T x, const Acc& acc) {
+        if (acc.index < 0) return true;
+        if (x != x) return acc.value == acc.value;
+        return x > acc.value;
+    }
+
+    Acc init() const { return {std::numeric_limits<T>::lowest(), -1}; }
+
+    Acc run(Acc acc, const T* p, size_t n, std::ptrdiff_t stride, size_t pos) const {
+        if (stride == 1) {
+            // Vectorized max, then the first position holding it
+            T best = kernels.max(p, n);
+            size_t i = 0;
+            if (best != best) {
+                while (p[i] == p[i]) i++;
+            } else {
+                while (p[i] != best) i++;
+            }
+            return better(best, acc) ? Acc{best, static_cast<int64_t>(pos + i)} : acc;
+        }
+        for (size_t i = 0; i < n; i++) {
+            T x = p[i * stride];
+            if (better(x, acc)) acc = {x, static_cast<int64_t>(pos + i)};
+        }
+        return acc;
+    }
+
+    void column(Acc* acc, const T* p, size_t n, std::ptrdiff_t stride, size_t pos) const {
+        for (size_t i = 0; i < n; i++) {
+            T x = p[i * stride];
+            if (better(x, acc[i])) acc[i] = {x, static_cast<int64_t>(pos)};
+        }
+    }
+
+    Acc merge(Acc a, Acc b) const { return b.index >= 0 && better(b.value, a) ? b : a; }
+    Out finalize(Acc acc, size_t) const { return static_cast<Out>(acc.index); }
+};
+
+// Reduce t over the dims flagged in `reduced` into out, a contiguous buffer holding the
+// kept dims in row-major order.
+//
+// Kept dims before the last reduced dim are "outer" and kept dims after it "inner", so the
+// output is an [outer, inner] matrix and each outer index folds a [reduced..., inner...]
+// block: with no inner dims every output reduces its own runs (vectorized kernels), otherwise
+// whole rows of inner outputs are updated at once (column folds, contiguous in memory).
+// Many output blocks are spread over the threads; few blocks are split among them either by
+// columns or by slices of the reduced positions whose partial results are merged as a tree.
+template<typename T, typename Reducer>
+void reduce_forward(const Tensor<T>& t, const DimMask& reduced, typename Reducer::Out* out, const Reducer& reducer) {
+    using Acc = typename Reducer::Acc;
+
+    int last_reduced = -1;
+    for (int d = 0; d < t.ndim; d++) {
+        if (reduced[d]) last_reduced = d;
+    }
+
+    Dims outer_shape, outer_strides, reduce_shape, reduce_strides, inner_shape, inner_strides;
+    for (int d = 0; d < t.ndim; d++) {
+        if (reduced[d]) {
+            reduce_shape.push_back(t.shape[d]);
+            reduce_strides.push_back(t.strides[d]);
+        } else if (d < last_reduced) {
+            outer_shape.push_back(t.shape[d]);
+            outer_strides.push_back(t.strides[d]);
+        } else {
+            inner_shape.push_back(t.shape[d]);
+            inner_strides.push_back(t.strides[d]);
+        }
+    }
+
+    auto numel = [](const Dims& shape) {
+        size_t n = 1;
+        for (int size : shape) n *= static_cast<size_t>(size);
+        return n;
+    };
+    size_t outer_size = numel(outer_shape);
+    size_t reduce_size = numel(reduce_shape);
+    size_t inner_size = numel(inner_shape);
+    if (outer_size == 0 || inner_size == 0) return;
+
+    StridedIterator<1> reduce_iter(reduce_shape, {&reduce_strides});
+    StridedIterator<1> inner_iter(inner_shape, {&inner_strides});
+    bool single_inner_run = inner_iter.outer_size() == 1;
+    std::ptrdiff_t inner_stride = inner_iter.inner_strides()[0];
+    const T* data = t.data.get();
+
+    auto outer_offset = [&](size_t o) {
+        std::ptrdiff_t offset = 0;
+        for (int d = static_cast<int>(outer_shape.size()) - 1; d >= 0; d--) {
+            offset += static_cast<std::ptrdiff_t>(o % outer_shape[d]) * outer_strides[d];
+            o /= outer_shape[d];
+        }
+        return offset;
+    };
+
+    // Fold the reduced positions [p0, p1) of the block at base into acc. With a single inner
+    // run only the columns [c0, c1) are updated, otherwise all of them.
+    auto fold_columns = [&](const T* base, size_t p0, size_t p1, Acc* acc, size_t c0, size_t c1) {
+        size_t run_size = reduce_iter.inner_size();
+        size_t run = p0 / run_size;
+        reduce_iter.for_each(run, (p1 + run_size - 1) / run_size, [&](const auto& offsets, size_t n, const auto& strides) {
+            size_t start = run++ * run_size;
+            size_t lo = std::max(p0, start);
+            size_t hi = std::min(p1, start + n);
+            std::ptrdiff_t step = strides[0];
+            const T* p = base + offsets[0] + static_cast<std::ptrdiff_t>(lo - start) * step;
+
+            if (inner_size == 1) {
+                acc[0] = reducer.run(acc[0], p, hi - lo, step, lo);
+                return;
+            }
+            for (size_t pos = lo; pos < hi; pos++, p += step) {
+                if (single_inner_run) {
+                    reducer.column(acc + c0, p + static_cast<std::ptrdiff_t>(c0) * inner_stride, c1 - c0, inner_stride, pos);
+                } else {
+                    size_t col = 0;
+                    inner_iter.for_each([&](const auto& inner_offsets, size_t m, const auto& inner_steps) {
+                        reducer.column(acc + col, p + inner_offsets[0], m, inner_steps[0], pos);
+                        col += m;
+                    });
+                }
+            }
+        });
+    };
+
+    // Wide rows are folded one slab of columns at a time, so the accumulators stay in cache
+    auto fold = [&](const T* base, size_t p0, size_t p1, Acc* acc, size_t c0, size_t c1) {
+        if (p0 >= p1) return;
+        if (inner_size == 1 || !single_inner_run) {
+            fold_columns(base, p0, p1, acc, c0, c1);
+            return;
+        }
+        for (size_t c = c0; c < c1; c += REDUCE_COLUMN_BLOCK) {
+            fold_columns(base, p0, p1, acc, c, std::min(c1, c + REDUCE_COLUMN_BLOCK));
+        }
+    };
+
+    auto finalize_block = [&](size_t o, const Acc* acc) {
+        typename Reducer::Out* o_out = out + o * inner_size;
+        for (size_t i = 0; i < inner_size; i++) o_out[i] = reducer.finalize(acc[i], reduce_size);
+    };
+
+    size_t total = outer_size * reduce_size * inner_size;
+    size_t num_threads = parallel::in_parallel_region() ? 1 : static_cast<size_t>(parallel::get_num_threads());
+
+    if (num_threads == 1 || total <= REDUCE_GRAIN || outer_size >= num_threads) {
+        size_t block_work = std::max<size_t>(1, reduce_size * inner_size);
+        parallel::parallel_for(0, outer_size, std::max<size_t>(1, REDUCE_GRAIN / block_work), [&](size_t begin, size_t end) {
+            std::vector<Acc> acc(inner_size);
+            for (size_t o = begin; o < end; o++) {
+                std::fill(acc.begin(), acc.end(), reducer.init());
+                fold(data + outer_offset(o), 0, reduce_size, acc.data(), 0, inner_size);
+                finalize_block(o, acc.data());
+            }
+        });
+        return;
+    }
+
+    for (size_t o = 0; o < outer_size; o++) {
+        const T* base = data + outer_offset(o);
+        std::vector<Acc> acc(inner_size, reducer.init());
+
+        if (single_inner_run && inner_size >= num_threads * 64) {
+            // Wide rows: every thread owns a range of columns, nothing to merge
+            size_t grain = std::max<size_t>(64, REDUCE_GRAIN / std::max<size_t>(reduce_size, 1));
+            parallel::parallel_for(0, inner_size, grain, [&](size_t c0, size_t c1) {
+                fold(base, 0, reduce_size, acc.data(), c0, c1);
+            });
+        } else {
+            // Every thread folds a slice of the reduced positions into its own partial result
+            size_t nchunks = std::min({num_threads, reduce_size, std::max<size_t>(1, reduce_size * inner_size / REDUCE_GRAIN)});
+            std::vector<std::vector<Acc>> partials(nchunks, std::vector<Acc>(inner_size, reducer.init()));
+            parallel::parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; c++) {
+                    fold(base, reduce_size * c / nchunks, reduce_size * (c + 1) / nchunks, partials[c].data(), 0, inner_size);
+                }
+            });
+            for (size_t step = 1; step < nchunks; step *= 2) {
+                for (size_t c = 0; c + step < nchunks; c += 2 * step) {
+                    for (size_t i = 0; i < inner_size; i++) {
+                        partials[c][i] = reducer.merge(partials[c][i], partials[c + step][i]);
+                    }
+                }
+            }
+            if (nchunks > 0) acc = std::move(partials[0]);
+        }
+        finalize_block(o, acc.data());
+    }
+}
+
+} // namespace cpu
+
+#endif
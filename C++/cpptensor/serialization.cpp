@@ -0,0 +1,342 @@
+#include "serialization.hpp"
+#include "allocator.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+const char MAGIC[8] = {'C', 'P', 'T', 'E', 'N', 'S', 'O', 'R'};
+
+// Values are stored in host order, which the format fixes to little-endian
+void check_little_endian() {
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const uint8_t*>(&probe) != 1) {
+        throw std::runtime_error("Tensor files are only supported on little-endian hosts");
+    }
+}
+
+size_t align_up(size_t offset) {
+    return (offset + memory::ALIGNMENT - 1) / memory::ALIGNMENT * memory::ALIGNMENT;
+}
+
+// Stable on-disk dtype codes, independent of the DataType enum order
+uint32_t dtype_code(DataType dtype) {
+    switch (dtype) {
+        case DataType::UINT8:    return 0;
+        case DataType::INT32:    return 1;
+        case DataType::FLOAT32:  return 2;
+        case DataType::FLOAT16:  return 3;
+        case DataType::BFLOAT16: return 4;
+    }
+    throw std::invalid_argument("Unsupported dtype for save");
+}
+
+DataType dtype_from_code(uint32_t code) {
+    const DataType dtypes[] = {DataType::UINT8, DataType::INT32, DataType::FLOAT32, DataType::FLOAT16, DataType::BFLOAT16};
+    if (code >= sizeof(dtypes) / sizeof(dtypes[0])) throw std::runtime_error("Corrupt tensor file: unknown dtype");
+    return dtypes[code];
+}
+
+// Bytes spanned by a layout, one past the furthest element, or SIZE_MAX when that overflows
+// (more than any file holds, so a record claiming it is rejected)
+size_t span_bytes(const Dims& shape, const Dims& strides, size_t item_size) {
+    for (int dim : shape) {
+        if (dim == 0) return 0;
+    }
+    size_t last = 0;
+    for (size_t i = 0; i < shape.size(); i++) {
+        size_t extent = static_cast<size_t>(shape[i] - 1);
+        size_t stride = static_cast<size_t>(strides[i]);
+        if (stride != 0 && extent > (SIZE_MAX - last) / stride) return SIZE_MAX;
+        last += extent * stride;
+    }
+    if (last >= SIZE_MAX / item_size) return SIZE_MAX;
+    return (last + 1) * item_size;
+}
+
+template<typename V>
+void append(std::string& buffer, V value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(V));
+}
+
+// Bounds-checked reads from the header
+struct Reader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+
+    const uint8_t* take(size_t n) {
+        if (n > size - pos) throw std::runtime_error("Corrupt tensor file: truncated header");
+        const uint8_t* p = data + pos;
+        pos += n;
+        return p;
+    }
+
+    template<typename V>
+    V read() {
+        V value;
+        std::memcpy(&value, take(sizeof(V)), sizeof(V));
+        return value;
+    }
+};
+
+// Fixed-size start of the header
+const size_t PREFIX_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+struct Prefix {
+    uint32_t count;
+    uint64_t header_size;
+};
+
+// Fills in the payload offsets of records (in name order, after the header) and returns the header
+std::string encode_header(std::map<std::string, io::TensorRecord>& records) {
+    size_t header_size = PREFIX_SIZE;
+    for (const auto& [name, r] : records) {
+        if (name.empty()) throw std::invalid_argument("Tensor names cannot be empty");
+        if (r.shape.size() != r.strides.size()) throw std::invalid_argument("Tensor '" + name + "' has mismatched shape and strides");
+        header_size += sizeof(uint32_t) + name.size() + 2 * sizeof(uint32_t)
+                     + 2 * r.shape.size() * sizeof(int64_t) + 2 * sizeof(uint64_t);
+    }
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    append<uint32_t>(header, io::FORMAT_VERSION);
+    append<uint32_t>(header, static_cast<uint32_t>(records.size()));
+    append<uint64_t>(header, header_size);
+
+    size_t offset = align_up(header_size);
+    for (auto& [name, r] : records) {
+        r.offset = offset;
+        offset = align_up(offset + r.nbytes);
+        append<uint32_t>(header, static_cast<uint32_t>(name.size()));
+        header.append(name);
+        append<uint32_t>(header, dtype_code(r.dtype));
+        append<uint32_t>(header, static_cast<uint32_t>(r.shape.size()));
+        for (int dim : r.shape) append<int64_t>(header, dim);
+        for (int stride : r.strides) append<int64_t>(header, stride);
+        append<uint64_t>(header, r.offset);
+        append<uint64_t>(header, r.nbytes);
+    }
+    return header;
+}
+
+Prefix parse_prefix(Reader& reader, const std::string& path) {
+    if (std::memcmp(reader.take(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a tensor file: " + path);
+    }
+    uint32_t version = reader.read<uint32_t>();
+    if (version > io::FORMAT_VERSION) {
+        throw std::runtime_error("Tensor file version " + std::to_string(version) + " is newer than the supported "
+                                 + std::to_string(io::FORMAT_VERSION));
+    }
+    Prefix prefix;
+    prefix.count = reader.read<uint32_t>();
+    prefix.header_size = reader.read<uint64_t>();
+    return prefix;
+}
+
+// Records of a whole header, checked against the size of its file
+std::map<std::string, io::TensorRecord> parse_header(const uint8_t* data, size_t header_size, size_t file_size,
+                                                     const std::string& path) {
+    Reader reader{data, header_size};
+    uint32_t count = parse_prefix(reader, path).count;
+
+    std::map<std::string, io::TensorRecord> records;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t name_size = reader.read<uint32_t>();
+        std::string name(reinterpret_cast<const char*>(reader.take(name_size)), name_size);
+
+        io::TensorRecord r;
+        r.dtype = dtype_from_code(reader.read<uint32_t>());
+        uint32_t ndim = reader.read<uint32_t>();
+        if (ndim > header_size) throw std::runtime_error("Corrupt tensor file: truncated header");
+        r.shape.resize(ndim);
+        r.strides.resize(ndim);
+        for (int& dim : r.shape) {
+            int64_t value = reader.read<int64_t>();
+            if (value < 0 || value > INT32_MAX) throw std::runtime_error("Corrupt tensor file: invalid shape");
+            dim = static_cast<int>(value);
+        }
+        for (int& stride : r.strides) {
+            int64_t value = reader.read<int64_t>();
+            if (value < 0 || value > INT32_MAX) throw std::runtime_error("Corrupt tensor file: invalid strides");
+            stride = static_cast<int>(value);
+        }
+        r.offset = reader.read<uint64_t>();
+        r.nbytes = reader.read<uint64_t>();
+
+        if (r.offset % memory::ALIGNMENT != 0 || r.offset > file_size || r.nbytes > file_size - r.offset
+            || span_bytes(r.shape, r.strides, get_dtype_size(r.dtype)) > r.nbytes) {
+            throw std::runtime_error("Corrupt tensor file: payload of '" + name + "' out of bounds");
+        }
+        records.emplace(std::move(name), std::move(r));
+    }
+    return records;
+}
+
+// Whole file in memory: mapped where possible, read into a buffer otherwise
+struct FileView {
+    std::shared_ptr<uint8_t> data;
+    size_t size = 0;
+};
+
+FileView map_file(const std::string& path) {
+    FileView view;
+#if defined(_WIN32)
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    // 64-bit positions: long is 32 bits on Windows
+    _fseeki64(file, 0, SEEK_END);
+    view.size = static_cast<size_t>(_ftelli64(file));
+    _fseeki64(file, 0, SEEK_SET);
+    std::shared_ptr<uint8_t[]> buffer = memory::allocate_shared<uint8_t>(view.size);
+    size_t read = std::fread(buffer.get(), 1, view.size, file);
+    std::fclose(file);
+    if (read != view.size) throw std::runtime_error("Cannot read " + path);
+    view.data = std::shared_ptr<uint8_t>(buffer, buffer.get());
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    view.size = static_cast<size_t>(st.st_size);
+    if (view.size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Not a tensor file: " + path);
+    }
+    // Private writable mapping: untouched pages stay shared with the page cache
+    void* ptr = ::mmap(nullptr, view.size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) throw std::runtime_error("Cannot map " + path);
+    size_t size = view.size;
+    view.data = std::shared_ptr<uint8_t>(static_cast<uint8_t*>(ptr), [size](uint8_t* p) { ::munmap(p, size); });
+#endif
+    return view;
+}
+
+} // namespace
+
+
+void io::save(const std::string& path, const std::map<std::string, AnyTensor>& tensors) {
+    check_little_endian();
+
+    std::map<std::string, TensorRecord> records;
+    for (const auto& [name, t] : tensors) {
+        TensorRecord& r = records[name];
+        r.dtype = t.dtype;
+        r.shape = t.shape;
+        r.strides = t.strides;
+        r.nbytes = span_bytes(t.shape, t.strides, get_dtype_size(t.dtype));
+    }
+    std::string header = encode_header(records);
+
+    // Written next to the target and renamed over it once complete, so a failed save leaves the
+    // old file intact and tensors loaded (mapped) from it stay valid
+    const std::string tmp_path = path + ".tmp";
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("Cannot open " + tmp_path + " for writing");
+    file.write(header.data(), header.size());
+
+    const char padding[memory::ALIGNMENT] = {};
+    size_t written = header.size();
+    for (const auto& [name, t] : tensors) {
+        const TensorRecord& r = records[name];
+        file.write(padding, r.offset - written);
+        file.write(static_cast<const char*>(t.data.get()), r.nbytes);
+        written = r.offset + r.nbytes;
+    }
+    file.close();
+    std::error_code error;
+    if (!file) {
+        std::filesystem::remove(tmp_path, error);
+        throw std::runtime_error("Cannot write " + tmp_path);
+    }
+    std::filesystem::rename(tmp_path, path, error);
+    if (error) {
+        std::filesystem::remove(tmp_path, error);
+        throw std::runtime_error("Cannot replace " + path + ": " + error.message());
+    }
+}
+
+std::map<std::string, io::AnyTensor> io::load(const std::string& path) {
+    check_little_endian();
+    FileView file = map_file(path);
+    Reader reader{file.data.get(), file.size};
+    uint64_t header_size = parse_prefix(reader, path).header_size;
+    if (header_size > file.size) throw std::runtime_error("Corrupt tensor file: truncated header");
+
+    std::map<std::string, AnyTensor> tensors;
+    for (auto& [name, r] : parse_header(file.data.get(), header_size, file.size, path)) {
+        AnyTensor& t = tensors[name];
+        t.dtype = r.dtype;
+        t.shape = std::move(r.shape);
+        t.strides = std::move(r.strides);
+        t.data = std::shared_ptr<void>(file.data, file.data.get() + r.offset);
+    }
+    return tensors;
+}
+
+std::map<std::string, io::TensorRecord> io::read_header(const std::string& path) {
+    check_little_endian();
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    size_t file_size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    std::string header(std::min(file_size, PREFIX_SIZE), '\0');
+    file.read(header.data(), header.size());
+    Reader reader{reinterpret_cast<const uint8_t*>(header.data()), header.size()};
+    uint64_t header_size = parse_prefix(reader, path).header_size;
+    if (header_size < PREFIX_SIZE || header_size > file_size) throw std::runtime_error("Corrupt tensor file: truncated header");
+
+    header.resize(header_size);
+    file.read(header.data() + PREFIX_SIZE, header_size - PREFIX_SIZE);
+    if (!file) throw std::runtime_error("Cannot read " + path);
+    return parse_header(reinterpret_cast<const uint8_t*>(header.data()), header_size, file_size, path);
+}
+
+std::map<std::string, io::TensorRecord> io::create(const std::string& path, const std::map<std::string, TensorRecord>& layout) {
+    check_little_endian();
+
+    std::map<std::string, TensorRecord> records;
+    for (const auto& [name, spec] : layout) {
+        TensorRecord& r = records[name];
+        r.dtype = spec.dtype;
+        r.shape = spec.shape;
+        r.strides = utils::calc_strides(spec.shape);
+        r.nbytes = span_bytes(r.shape, r.strides, get_dtype_size(r.dtype));
+        if (r.nbytes == SIZE_MAX) throw std::invalid_argument("Tensor '" + name + "' is too large for a tensor file");
+    }
+    std::string header = encode_header(records);
+
+    size_t end = header.size();
+    for (const auto& [name, r] : records) end = std::max<size_t>(end, r.offset + r.nbytes);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("Cannot open " + path + " for writing");
+    file.write(header.data(), header.size());
+    // Writing the last byte extends the file without touching the payloads in between
+    if (end > header.size()) {
+        file.seekp(end - 1);
+        file.put('\0');
+    }
+    if (!file) throw std::runtime_error("Cannot write " + path);
+    return records;
+}
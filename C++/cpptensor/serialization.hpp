@@ -0,0 +1,78 @@
+#ifndef SERIALIZATION_HPP
+#define SERIALIZATION_HPP
+
+#include "tensor.hpp"
+#include "dtype.hpp"
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace io {
+
+// Binary container of named tensors, little-endian:
+//   magic "CPTENSOR", uint32 version, uint32 tensor count, uint64 header bytes
+//   per tensor (sorted by name): uint32 name length, name, uint32 dtype, uint32 ndim,
+//     int64 shape[ndim], int64 strides[ndim] (in elements), uint64 payload offset, uint64 payload bytes
+//   payloads at memory::ALIGNMENT-aligned offsets from the start of the file
+const uint32_t FORMAT_VERSION = 1;
+
+// A tensor of any dtype, as saved to or loaded from a file
+struct AnyTensor {
+    DataType dtype = DataType::FLOAT32;
+    Dims shape;
+    Dims strides;
+    std::shared_ptr<void> data;   // First element, keeps its owner (a buffer or a file mapping) alive
+
+    AnyTensor() = default;
+
+    // Dense tensors are stored with their layout, other views are made contiguous first
+    template<typename T>
+    AnyTensor(const Tensor<T>& t) {
+        Tensor<T> dense = t.is_dense ? t : t.contiguous();
+        dtype = get_dtype<T>();
+        shape = dense.shape;
+        strides = dense.strides;
+        data = std::shared_ptr<void>(dense.data, dense.data.get());
+    }
+
+    template<typename T>
+    Tensor<T> as() const {
+        if (dtype != get_dtype<T>()) {
+            throw std::invalid_argument("Tensor of dtype " + dtype_to_str(dtype) + " read as " + dtype_to_str(get_dtype<T>()));
+        }
+        return Tensor<T>(std::shared_ptr<T[]>(data, static_cast<T*>(data.get())), shape, strides);
+    }
+};
+
+// Where and how a tensor is laid out in a file
+struct TensorRecord {
+    DataType dtype = DataType::FLOAT32;
+    Dims shape;
+    Dims strides;
+    uint64_t offset = 0;   // Payload position from the start of the file
+    uint64_t nbytes = 0;
+};
+
+// Writes the tensors to path.tmp, then renames it over path
+void save(const std::string& path, const std::map<std::string, AnyTensor>& tensors);
+
+// Maps the file into memory and returns tensors that point into the mapping, which stays
+// alive while any of them does. Nothing is copied: pages are read on first access and shared
+// with other processes mapping the same file. The mapping is copy-on-write, so writes to the
+// tensors are private to the process and never reach the file.
+std::map<std::string, AnyTensor> load(const std::string& path);
+
+// Reads the header of a file only, to access its payloads without mapping them
+std::map<std::string, TensorRecord> read_header(const std::string& path);
+
+// Creates a file of zero-filled contiguous tensors with the dtypes and shapes of layout, to be
+// written in place (the payloads are left sparse where the filesystem allows). Returns the
+// records as stored, with their strides and offsets.
+std::map<std::string, TensorRecord> create(const std::string& path, const std::map<std::string, TensorRecord>& layout);
+
+} // namespace io
+
+#endif
@@ -0,0 +1,710 @@
+#include "simd_kernels.hpp"
+#include "cpu_features.hpp"
+
+#include <algorithm>
+
+#if defined(CPPTENSOR_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Scalar fallbacks, also used for the tails of the vector loops
+template<typename T>
+void add_scalar(const T* a, const T* b, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = a[i] + b[i];
+}
+
+template<typename T>
+void mul_scalar(const T* a, const T* b, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = a[i] * b[i];
+}
+
+template<typename T>
+void add_value_scalar(const T* a, T b, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = a[i] + b;
+}
+
+template<typename T>
+void mul_value_scalar(const T* a, T b, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = a[i] * b;
+}
+
+template<typename H>
+void half_to_f32_scalar(const H* a, float32* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = a[i];
+}
+
+template<typename H>
+void f32_to_half_scalar(const float32* a, H* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = H(a[i]);
+}
+
+#if defined(CPPTENSOR_X86)
+
+// ---------------------------------------------------------------- SSE4.2
+
+CPPTENSOR_TARGET("sse4.2")
+void add_f32_sse42(const float32* a, const float32* b, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void add_value_f32_sse42(const float32* a, float32 b, float32* out, size_t n) {
+    const __m128 vb = _mm_set1_ps(b);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void mul_f32_sse42(const float32* a, const float32* b, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void mul_value_f32_sse42(const float32* a, float32 b, float32* out, size_t n) {
+    const __m128 vb = _mm_set1_ps(b);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), vb));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void add_i32_sse42(const int32* a, const int32* b, int32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi32(va, vb));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void add_value_i32_sse42(const int32* a, int32 b, int32* out, size_t n) {
+    const __m128i vb = _mm_set1_epi32(b);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi32(va, vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void mul_i32_sse42(const int32* a, const int32* b, int32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_mullo_epi32(va, vb));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void mul_value_i32_sse42(const int32* a, int32 b, int32* out, size_t n) {
+    const __m128i vb = _mm_set1_epi32(b);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_mullo_epi32(va, vb));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void add_u8_sse42(const uint8* a, const uint8* b, uint8* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi8(va, vb));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void add_value_u8_sse42(const uint8* a, uint8 b, uint8* out, size_t n) {
+    const __m128i vb = _mm_set1_epi8(static_cast<char>(b));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi8(va, vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+// There is no 8-bit multiply: multiply even and odd bytes as 16-bit lanes and keep the low bytes
+CPPTENSOR_TARGET("sse4.2")
+void mul_u8_sse42(const uint8* a, const uint8* b, uint8* out, size_t n) {
+    const __m128i low_mask = _mm_set1_epi16(0x00FF);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i even = _mm_and_si128(_mm_mullo_epi16(va, vb), low_mask);
+        __m128i odd = _mm_slli_epi16(_mm_mullo_epi16(_mm_srli_epi16(va, 8), _mm_srli_epi16(vb, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(even, odd));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void mul_value_u8_sse42(const uint8* a, uint8 b, uint8* out, size_t n) {
+    const __m128i low_mask = _mm_set1_epi16(0x00FF);
+    const __m128i vb = _mm_set1_epi8(static_cast<char>(b));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i even = _mm_and_si128(_mm_mullo_epi16(va, vb), low_mask);
+        __m128i odd = _mm_slli_epi16(_mm_mullo_epi16(_mm_srli_epi16(va, 8), _mm_srli_epi16(vb, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(even, odd));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+// ---------------------------------------------------------------- AVX2
+
+CPPTENSOR_TARGET("avx2")
+void add_f32_avx2(const float32* a, const float32* b, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void add_value_f32_avx2(const float32* a, float32 b, float32* out, size_t n) {
+    const __m256 vb = _mm256_set1_ps(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void mul_f32_avx2(const float32* a, const float32* b, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void mul_value_f32_avx2(const float32* a, float32 b, float32* out, size_t n) {
+    const __m256 vb = _mm256_set1_ps(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), vb));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void add_i32_avx2(const int32* a, const int32* b, int32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi32(va, vb));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void add_value_i32_avx2(const int32* a, int32 b, int32* out, size_t n) {
+    const __m256i vb = _mm256_set1_epi32(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi32(va, vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void mul_i32_avx2(const int32* a, const int32* b, int32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mullo_epi32(va, vb));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void mul_value_i32_avx2(const int32* a, int32 b, int32* out, size_t n) {
+    const __m256i vb = _mm256_set1_epi32(b);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mullo_epi32(va, vb));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void add_u8_avx2(const uint8* a, const uint8* b, uint8* out, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi8(va, vb));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void add_value_u8_avx2(const uint8* a, uint8 b, uint8* out, size_t n) {
+    const __m256i vb = _mm256_set1_epi8(static_cast<char>(b));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi8(va, vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void mul_u8_avx2(const uint8* a, const uint8* b, uint8* out, size_t n) {
+    const __m256i low_mask = _mm256_set1_epi16(0x00FF);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i even = _mm256_and_si256(_mm256_mullo_epi16(va, vb), low_mask);
+        __m256i odd = _mm256_slli_epi16(_mm256_mullo_epi16(_mm256_srli_epi16(va, 8), _mm256_srli_epi16(vb, 8)), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(even, odd));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void mul_value_u8_avx2(const uint8* a, uint8 b, uint8* out, size_t n) {
+    const __m256i low_mask = _mm256_set1_epi16(0x00FF);
+    const __m256i vb = _mm256_set1_epi8(static_cast<char>(b));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i even = _mm256_and_si256(_mm256_mullo_epi16(va, vb), low_mask);
+        __m256i odd = _mm256_slli_epi16(_mm256_mullo_epi16(_mm256_srli_epi16(va, 8), _mm256_srli_epi16(vb, 8)), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(even, odd));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+// ---------------------------------------------------------------- AVX-512
+
+CPPTENSOR_TARGET("avx512f")
+void add_f32_avx512(const float32* a, const float32* b, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void add_value_f32_avx512(const float32* a, float32 b, float32* out, size_t n) {
+    const __m512 vb = _mm512_set1_ps(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_loadu_ps(a + i), vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void mul_f32_avx512(const float32* a, const float32* b, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void mul_value_f32_avx512(const float32* a, float32 b, float32* out, size_t n) {
+    const __m512 vb = _mm512_set1_ps(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_loadu_ps(a + i), vb));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void add_i32_avx512(const int32* a, const int32* b, int32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(out + i, _mm512_add_epi32(va, vb));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void add_value_i32_avx512(const int32* a, int32 b, int32* out, size_t n) {
+    const __m512i vb = _mm512_set1_epi32(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        _mm512_storeu_si512(out + i, _mm512_add_epi32(va, vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void mul_i32_avx512(const int32* a, const int32* b, int32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(out + i, _mm512_mullo_epi32(va, vb));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void mul_value_i32_avx512(const int32* a, int32 b, int32* out, size_t n) {
+    const __m512i vb = _mm512_set1_epi32(b);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        _mm512_storeu_si512(out + i, _mm512_mullo_epi32(va, vb));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f,avx512bw")
+void add_u8_avx512(const uint8* a, const uint8* b, uint8* out, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(out + i, _mm512_add_epi8(va, vb));
+    }
+    add_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f,avx512bw")
+void add_value_u8_avx512(const uint8* a, uint8 b, uint8* out, size_t n) {
+    const __m512i vb = _mm512_set1_epi8(static_cast<char>(b));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        _mm512_storeu_si512(out + i, _mm512_add_epi8(va, vb));
+    }
+    add_value_scalar(a + i, b, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f,avx512bw")
+void mul_u8_avx512(const uint8* a, const uint8* b, uint8* out, size_t n) {
+    const __m512i low_mask = _mm512_set1_epi16(0x00FF);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + i);
+        __m512i even = _mm512_and_si512(_mm512_mullo_epi16(va, vb), low_mask);
+        __m512i odd = _mm512_slli_epi16(_mm512_mullo_epi16(_mm512_srli_epi16(va, 8), _mm512_srli_epi16(vb, 8)), 8);
+        _mm512_storeu_si512(out + i, _mm512_or_si512(even, odd));
+    }
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f,avx512bw")
+void mul_value_u8_avx512(const uint8* a, uint8 b, uint8* out, size_t n) {
+    const __m512i low_mask = _mm512_set1_epi16(0x00FF);
+    const __m512i vb = _mm512_set1_epi8(static_cast<char>(b));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i even = _mm512_and_si512(_mm512_mullo_epi16(va, vb), low_mask);
+        __m512i odd = _mm512_slli_epi16(_mm512_mullo_epi16(_mm512_srli_epi16(va, 8), _mm512_srli_epi16(vb, 8)), 8);
+        _mm512_storeu_si512(out + i, _mm512_or_si512(even, odd));
+    }
+    mul_value_scalar(a + i, b, out + i, n - i);
+}
+
+// ---------------------------------------------------------------- Half precision
+
+// bfloat16 widening is a 16-bit shift; narrowing rounds to nearest-even on the integer bits
+// and keeps NaN quiet. float16 uses the hardware conversions (F16C, AVX-512).
+
+CPPTENSOR_TARGET("sse4.2")
+void bf16_to_f32_sse42(const bfloat16* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i)));
+        _mm_storeu_ps(out + i, _mm_castsi128_ps(_mm_slli_epi32(v, 16)));
+    }
+    half_to_f32_scalar(a + i, out + i, n - i);
+}
+
+// bfloat16 bits of 4 floats, in the low half of each 32-bit lane
+CPPTENSOR_TARGET("sse4.2")
+__m128i round_bf16_sse42(__m128 v) {
+    __m128i bits = _mm_castps_si128(v);
+    __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+    __m128i rounded = _mm_srli_epi32(_mm_add_epi32(bits, _mm_add_epi32(odd, _mm_set1_epi32(0x7FFF))), 16);
+    __m128i quiet_nan = _mm_or_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x40));
+    return _mm_blendv_epi8(rounded, quiet_nan, _mm_castps_si128(_mm_cmpunord_ps(v, v)));
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void f32_to_bf16_sse42(const float32* a, bfloat16* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = round_bf16_sse42(_mm_loadu_ps(a + i));
+        __m128i hi = round_bf16_sse42(_mm_loadu_ps(a + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi32(lo, hi));
+    }
+    f32_to_half_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2,f16c")
+void f16_to_f32_f16c(const float16* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))));
+    }
+    half_to_f32_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2,f16c")
+void f32_to_f16_f16c(const float32* a, float16* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(a + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+    f32_to_half_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+void bf16_to_f32_avx2(const bfloat16* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        _mm256_storeu_ps(out + i, _mm256_castsi256_ps(_mm256_slli_epi32(v, 16)));
+    }
+    half_to_f32_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx2")
+__m256i round_bf16_avx2(__m256 v) {
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(odd, _mm256_set1_epi32(0x7FFF))), 16);
+    __m256i quiet_nan = _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x40));
+    return _mm256_blendv_epi8(rounded, quiet_nan, _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+}
+
+CPPTENSOR_TARGET("avx2")
+void f32_to_bf16_avx2(const float32* a, bfloat16* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = round_bf16_avx2(_mm256_loadu_ps(a + i));
+        __m256i hi = round_bf16_avx2(_mm256_loadu_ps(a + i + 8));
+        // packus works per 128-bit lane, the permute restores the element order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    f32_to_half_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void f16_to_f32_avx512(const float16* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i))));
+    }
+    half_to_f32_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void f32_to_f16_avx512(const float32* a, float16* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(a + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), h);
+    }
+    f32_to_half_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void bf16_to_f32_avx512(const bfloat16* a, float32* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+        _mm512_storeu_ps(out + i, _mm512_castsi512_ps(_mm512_slli_epi32(v, 16)));
+    }
+    half_to_f32_scalar(a + i, out + i, n - i);
+}
+
+CPPTENSOR_TARGET("avx512f")
+void f32_to_bf16_avx512(const float32* a, bfloat16* out, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(a + i);
+        __m512i bits = _mm512_castps_si512(v);
+        __m512i odd = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+        __m512i rounded = _mm512_srli_epi32(_mm512_add_epi32(bits, _mm512_add_epi32(odd, _mm512_set1_epi32(0x7FFF))), 16);
+        __m512i quiet_nan = _mm512_or_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(0x40));
+        __m512i result = _mm512_mask_blend_epi32(_mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q), rounded, quiet_nan);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtepi32_epi16(result));
+    }
+    f32_to_half_scalar(a + i, out + i, n - i);
+}
+
+#endif // CPPTENSOR_X86
+
+template<typename T>
+cpu::ElementwiseKernels<T> scalar_kernels() {
+    return {add_scalar<T>, mul_scalar<T>, add_value_scalar<T>, mul_value_scalar<T>};
+}
+
+// Half-precision operands are widened to float32 in blocks that stay in L1, computed by the
+// float32 kernels and rounded back
+const size_t HALF_BLOCK = 512;
+
+template<typename H, bool Mul>
+void binary_half(const H* a, const H* b, H* out, size_t n) {
+    const cpu::ElementwiseKernels<float32>& f32 = cpu::elementwise_kernels<float32>();
+    float32 va[HALF_BLOCK], vb[HALF_BLOCK];
+    for (size_t i = 0; i < n; i += HALF_BLOCK) {
+        size_t m = std::min(HALF_BLOCK, n - i);
+        cpu::to_float32(a + i, va, m);
+        cpu::to_float32(b + i, vb, m);
+        (Mul ? f32.mul : f32.add)(va, vb, va, m);
+        cpu::from_float32(va, out + i, m);
+    }
+}
+
+template<typename H, bool Mul>
+void binary_value_half(const H* a, H b, H* out, size_t n) {
+    const cpu::ElementwiseKernels<float32>& f32 = cpu::elementwise_kernels<float32>();
+    float32 va[HALF_BLOCK];
+    for (size_t i = 0; i < n; i += HALF_BLOCK) {
+        size_t m = std::min(HALF_BLOCK, n - i);
+        cpu::to_float32(a + i, va, m);
+        (Mul ? f32.mul_scalar : f32.add_scalar)(va, b, va, m);
+        cpu::from_float32(va, out + i, m);
+    }
+}
+
+template<typename H>
+cpu::ElementwiseKernels<H> half_elementwise_kernels() {
+    return {binary_half<H, false>, binary_half<H, true>, binary_value_half<H, false>, binary_value_half<H, true>};
+}
+
+} // namespace
+
+
+template<>
+const cpu::ElementwiseKernels<float32>& cpu::elementwise_kernels<float32>() {
+    static const ElementwiseKernels<float32> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ElementwiseKernels<float32>{add_f32_avx512, mul_f32_avx512, add_value_f32_avx512, mul_value_f32_avx512};
+            case SimdLevel::AVX2:   return ElementwiseKernels<float32>{add_f32_avx2, mul_f32_avx2, add_value_f32_avx2, mul_value_f32_avx2};
+            case SimdLevel::SSE42:  return ElementwiseKernels<float32>{add_f32_sse42, mul_f32_sse42, add_value_f32_sse42, mul_value_f32_sse42};
+            default: break;
+        }
+#endif
+        return scalar_kernels<float32>();
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ElementwiseKernels<int32>& cpu::elementwise_kernels<int32>() {
+    static const ElementwiseKernels<int32> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ElementwiseKernels<int32>{add_i32_avx512, mul_i32_avx512, add_value_i32_avx512, mul_value_i32_avx512};
+            case SimdLevel::AVX2:   return ElementwiseKernels<int32>{add_i32_avx2, mul_i32_avx2, add_value_i32_avx2, mul_value_i32_avx2};
+            case SimdLevel::SSE42:  return ElementwiseKernels<int32>{add_i32_sse42, mul_i32_sse42, add_value_i32_sse42, mul_value_i32_sse42};
+            default: break;
+        }
+#endif
+        return scalar_kernels<int32>();
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ElementwiseKernels<uint8>& cpu::elementwise_kernels<uint8>() {
+    static const ElementwiseKernels<uint8> kernels = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512: return ElementwiseKernels<uint8>{add_u8_avx512, mul_u8_avx512, add_value_u8_avx512, mul_value_u8_avx512};
+            case SimdLevel::AVX2:   return ElementwiseKernels<uint8>{add_u8_avx2, mul_u8_avx2, add_value_u8_avx2, mul_value_u8_avx2};
+            case SimdLevel::SSE42:  return ElementwiseKernels<uint8>{add_u8_sse42, mul_u8_sse42, add_value_u8_sse42, mul_value_u8_sse42};
+            default: break;
+        }
+#endif
+        return scalar_kernels<uint8>();
+    }();
+    return kernels;
+}
+
+template<>
+const cpu::ElementwiseKernels<float16>& cpu::elementwise_kernels<float16>() {
+    static const ElementwiseKernels<float16> kernels = half_elementwise_kernels<float16>();
+    return kernels;
+}
+
+template<>
+const cpu::ElementwiseKernels<bfloat16>& cpu::elementwise_kernels<bfloat16>() {
+    static const ElementwiseKernels<bfloat16> kernels = half_elementwise_kernels<bfloat16>();
+    return kernels;
+}
+
+const cpu::HalfKernels& cpu::half_kernels() {
+    static const HalfKernels kernels = [] {
+        HalfKernels selected{half_to_f32_scalar<float16>, f32_to_half_scalar<float16>,
+                             half_to_f32_scalar<bfloat16>, f32_to_half_scalar<bfloat16>};
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512:
+                return HalfKernels{f16_to_f32_avx512, f32_to_f16_avx512, bf16_to_f32_avx512, f32_to_bf16_avx512};
+            case SimdLevel::AVX2:
+                selected.bfloat16_to_float32 = bf16_to_f32_avx2;
+                selected.float32_to_bfloat16 = f32_to_bf16_avx2;
+                if (cpu_features().f16c) {
+                    selected.float16_to_float32 = f16_to_f32_f16c;
+                    selected.float32_to_float16 = f32_to_f16_f16c;
+                }
+                break;
+            case SimdLevel::SSE42:
+                selected.bfloat16_to_float32 = bf16_to_f32_sse42;
+                selected.float32_to_bfloat16 = f32_to_bf16_sse42;
+                break;
+            default: break;
+        }
+#endif
+        return selected;
+    }();
+    return kernels;
+}
@@ -0,0 +1,50 @@
+#ifndef SIMD_KERNELS_HPP
+#define SIMD_KERNELS_HPP
+
+#include "dtype.hpp"
+
+#include <cstddef>
+
+namespace cpu {
+
+// out[i] = a[i] op b[i] over n contiguous elements. out may alias a or b.
+template<typename T>
+using binary_kernel = void (*)(const T* a, const T* b, T* out, size_t n);
+
+// out[i] = a[i] op value over n contiguous elements. out may alias a.
+template<typename T>
+using scalar_kernel = void (*)(const T* a, T value, T* out, size_t n);
+
+template<typename T>
+struct ElementwiseKernels {
+    binary_kernel<T> add;
+    binary_kernel<T> mul;
+    scalar_kernel<T> add_scalar;
+    scalar_kernel<T> mul_scalar;
+};
+
+// Kernels for the best instruction set of the host, selected on first use from CPUID.
+// float16 and bfloat16 are computed in float32 blocks and rounded back.
+template<typename T>
+const ElementwiseKernels<T>& elementwise_kernels();
+
+// Conversions between the half-precision storage types and float32 over n contiguous elements
+struct HalfKernels {
+    void (*float16_to_float32)(const float16* a, float32* out, size_t n);
+    void (*float32_to_float16)(const float32* a, float16* out, size_t n);
+    void (*bfloat16_to_float32)(const bfloat16* a, float32* out, size_t n);
+    void (*float32_to_bfloat16)(const float32* a, bfloat16* out, size_t n);
+};
+
+// Kernels for the best instruction set of the host (F16C / AVX-512 for float16)
+const HalfKernels& half_kernels();
+
+// The same conversions picked by storage type, for code templated on it
+inline void to_float32(const float16* a, float32* out, size_t n) { half_kernels().float16_to_float32(a, out, n); }
+inline void to_float32(const bfloat16* a, float32* out, size_t n) { half_kernels().bfloat16_to_float32(a, out, n); }
+inline void from_float32(const float32* a, float16* out, size_t n) { half_kernels().float32_to_float16(a, out, n); }
+inline void from_float32(const float32* a, bfloat16* out, size_t n) { half_kernels().float32_to_bfloat16(a, out, n); }
+
+} // namespace cpu
+
+#endif
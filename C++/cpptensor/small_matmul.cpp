@@ -0,0 +1,52 @@
+#include "small_matmul.hpp"
+#include "gemm.hpp"
+
+#include <array>
+#include <utility>
+
+
+namespace {
+
+// M and N are compile-time trip counts, so the compiler unrolls the i/j loops and keeps acc in
+// registers
+template<typename T, int M, int N>
+void small_matmul(int K, const T* a, const T* b, T* c) {
+    using P = cpu::gemm_compute_t<T>;
+    P acc[M][N] = {};
+    for (int p = 0; p < K; p++) {
+        P b_row[N];
+        for (int j = 0; j < N; j++) b_row[j] = static_cast<P>(b[p * N + j]);
+        for (int i = 0; i < M; i++) {
+            P av = static_cast<P>(a[i * K + p]);
+            for (int j = 0; j < N; j++) acc[i][j] += av * b_row[j];
+        }
+    }
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) c[i * N + j] = static_cast<T>(acc[i][j]);
+    }
+}
+
+const int TABLE_SIZE = cpu::SMALL_MATMUL_MAX * cpu::SMALL_MATMUL_MAX;
+
+// Entry (M - 1) * SMALL_MATMUL_MAX + (N - 1) holds the M x N kernel
+template<typename T, int... I>
+constexpr std::array<cpu::small_matmul_kernel<T>, TABLE_SIZE> make_table(std::integer_sequence<int, I...>) {
+    return {small_matmul<T, I / cpu::SMALL_MATMUL_MAX + 1, I % cpu::SMALL_MATMUL_MAX + 1>...};
+}
+
+} // namespace
+
+
+template<typename T>
+cpu::small_matmul_kernel<T> cpu::small_matmul_kernel_for(int M, int N) {
+    static constexpr std::array<small_matmul_kernel<T>, TABLE_SIZE> table =
+        make_table<T>(std::make_integer_sequence<int, TABLE_SIZE>{});
+    if (M < 1 || M > SMALL_MATMUL_MAX || N < 1 || N > SMALL_MATMUL_MAX) return nullptr;
+    return table[(M - 1) * SMALL_MATMUL_MAX + (N - 1)];
+}
+
+template cpu::small_matmul_kernel<uint8> cpu::small_matmul_kernel_for<uint8>(int, int);
+template cpu::small_matmul_kernel<int32> cpu::small_matmul_kernel_for<int32>(int, int);
+template cpu::small_matmul_kernel<float32> cpu::small_matmul_kernel_for<float32>(int, int);
+template cpu::small_matmul_kernel<float16> cpu::small_matmul_kernel_for<float16>(int, int);
+template cpu::small_matmul_kernel<bfloat16> cpu::small_matmul_kernel_for<bfloat16>(int, int);
@@ -0,0 +1,24 @@
+#ifndef SMALL_MATMUL_HPP
+#define SMALL_MATMUL_HPP
+
+#include "dtype.hpp"
+
+namespace cpu {
+
+// Largest M and N of the small matmul kernels
+const int SMALL_MATMUL_MAX = 8;
+
+// C[M x N] = A[M x K] * B[K x N] for dense row-major matrices, with M and N fixed at compile time:
+// the M x N accumulator tile is unrolled into registers and only K is a loop. Half-precision
+// products are accumulated in float32 and rounded once.
+template<typename T>
+using small_matmul_kernel = void (*)(int K, const T* a, const T* b, T* c);
+
+// Kernel for an M x N result, from a table built at compile time, or nullptr if M or N is not
+// in [1, SMALL_MATMUL_MAX]
+template<typename T>
+small_matmul_kernel<T> small_matmul_kernel_for(int M, int N);
+
+} // namespace cpu
+
+#endif
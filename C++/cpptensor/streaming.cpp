@@ -0,0 +1,228 @@
+#include "streaming.hpp"
+#include "allocator.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+
+// One open file shared by the copies of a FileTensor. I/O is serialized per file.
+struct streaming::FileTensor::File {
+    std::string path;
+    std::fstream stream;
+    std::mutex mutex;
+    bool writable = false;
+
+    // Reopens the stream for reading and writing, with the mutex held
+    void make_writable() {
+        if (writable) return;
+        stream.close();
+        stream.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!stream) throw std::runtime_error("Cannot open " + path + " for writing");
+        writable = true;
+    }
+};
+
+streaming::FileTensor streaming::FileTensor::open(const std::string& path, const std::string& name) {
+    std::map<std::string, io::TensorRecord> records = io::read_header(path);
+    auto it = records.find(name);
+    if (it == records.end()) throw std::invalid_argument("No tensor '" + name + "' in " + path);
+    const io::TensorRecord& record = it->second;
+    if (record.strides != utils::calc_strides(record.shape)) {
+        throw std::invalid_argument("Tensor '" + name + "' in " + path + " is not contiguous and cannot be streamed");
+    }
+
+    FileTensor t;
+    t.dtype = record.dtype;
+    t.shape = record.shape;
+    t.offset = record.offset;
+    t.file = std::make_shared<File>();
+    t.file->path = path;
+    // Inputs may be read-only files; writing reopens the file for reading and writing
+    t.file->stream.open(path, std::ios::binary | std::ios::in);
+    if (!t.file->stream) throw std::runtime_error("Cannot open " + path);
+    return t;
+}
+
+streaming::FileTensor streaming::FileTensor::create(const std::string& path, const std::string& name, DataType dtype,
+                                                    const Dims& shape) {
+    io::TensorRecord spec;
+    spec.dtype = dtype;
+    spec.shape = shape;
+    io::create(path, {{name, spec}});
+    FileTensor t = open(path, name);
+    t.file->make_writable();   // An output, written next
+    return t;
+}
+
+size_t streaming::FileTensor::rows() const {
+    return shape.empty() ? 1 : static_cast<size_t>(shape[0]);
+}
+
+size_t streaming::FileTensor::row_bytes() const {
+    size_t bytes = get_dtype_size(dtype);
+    for (size_t d = 1; d < shape.size(); d++) bytes *= static_cast<size_t>(shape[d]);
+    return bytes;
+}
+
+void streaming::FileTensor::read_rows(size_t begin, size_t count, void* dst) const {
+    if (begin + count > rows()) throw std::out_of_range("Rows out of range of the file tensor");
+    std::lock_guard<std::mutex> lock(file->mutex);
+    file->stream.seekg(static_cast<std::streamoff>(offset + begin * row_bytes()));
+    file->stream.read(static_cast<char*>(dst), static_cast<std::streamsize>(count * row_bytes()));
+    if (!file->stream) throw std::runtime_error("Cannot read " + file->path);
+}
+
+void streaming::FileTensor::write_rows(size_t begin, size_t count, const void* src) const {
+    if (begin + count > rows()) throw std::out_of_range("Rows out of range of the file tensor");
+    std::lock_guard<std::mutex> lock(file->mutex);
+    file->make_writable();
+    file->stream.seekp(static_cast<std::streamoff>(offset + begin * row_bytes()));
+    file->stream.write(static_cast<const char*>(src), static_cast<std::streamsize>(count * row_bytes()));
+    file->stream.flush();
+    if (!file->stream) throw std::runtime_error("Cannot write " + file->path);
+}
+
+size_t streaming::chunk_rows(const std::vector<const FileTensor*>& tensors, size_t chunk_bytes) {
+    size_t bytes_per_row = 0;
+    for (const FileTensor* t : tensors) bytes_per_row += t->row_bytes();
+    if (bytes_per_row == 0) return 1;
+    return std::max<size_t>(1, chunk_bytes / bytes_per_row);
+}
+
+namespace {
+
+// Background thread of one for_each_chunk call. It runs the I/O jobs the compute loop hands it,
+// one at a time, so a call starts a single thread however many blocks it streams.
+class IoThread {
+public:
+    IoThread() : thread([this] { loop(); }) {}
+
+    ~IoThread() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        thread.join();
+    }
+
+    // Starts job; the previous one must have been waited for
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->job = std::move(job);
+            pending = true;
+        }
+        cv.notify_all();
+    }
+
+    // Waits for the submitted job to finish
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !pending; });
+    }
+
+    // Waits for the submitted job and rethrows its exception
+    void get() {
+        wait();
+        if (error) std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+private:
+    void loop() {
+        while (true) {
+            std::function<void()> next;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stop || pending; });
+                if (!pending) return;
+                next = std::move(job);
+            }
+            std::exception_ptr failure;
+            try {
+                next();
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = failure;
+                pending = false;
+            }
+            cv.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::function<void()> job;
+    bool pending = false;
+    bool stop = false;
+    std::exception_ptr error;
+    std::thread thread;  // Last, so it starts once the rest is initialized
+};
+
+} // namespace
+
+void streaming::for_each_chunk(const std::vector<const FileTensor*>& inputs, const FileTensor* out, size_t chunk_rows,
+                               const ChunkFn& compute) {
+    if (inputs.empty() && !out) return;
+    size_t rows = inputs.empty() ? out->rows() : inputs[0]->rows();
+    for (const FileTensor* t : inputs) {
+        if (t->rows() != rows) throw std::invalid_argument("Streamed tensors must have the same size in dim 0");
+    }
+    if (out && out->rows() != rows) throw std::invalid_argument("Streamed tensors must have the same size in dim 0");
+    if (chunk_rows == 0) throw std::invalid_argument("chunk_rows must be positive");
+
+    // Two blocks per tensor: one being computed, the other being read or written
+    auto allocate = [&](const FileTensor* t) {
+        return memory::allocate_shared<uint8_t>(std::max<size_t>(1, chunk_rows * t->row_bytes()));
+    };
+    std::vector<std::shared_ptr<uint8_t[]>> in_blocks[2], out_blocks;
+    for (int slot = 0; slot < 2; slot++) {
+        for (const FileTensor* t : inputs) in_blocks[slot].push_back(allocate(t));
+        if (out) out_blocks.push_back(allocate(out));
+    }
+
+    size_t num_chunks = (rows + chunk_rows - 1) / chunk_rows;
+    auto chunk_size = [&](size_t chunk) { return std::min(chunk_rows, rows - chunk * chunk_rows); };
+    auto read_chunk = [&](size_t chunk) {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            inputs[i]->read_rows(chunk * chunk_rows, chunk_size(chunk), in_blocks[chunk % 2][i].get());
+        }
+    };
+    auto write_chunk = [&](size_t chunk) {
+        out->write_rows(chunk * chunk_rows, chunk_size(chunk), out_blocks[chunk % 2].get());
+    };
+
+    // A single block has nothing to overlap with, so it needs no I/O thread
+    std::unique_ptr<IoThread> io;
+    if (num_chunks > 1) io = std::make_unique<IoThread>();
+
+    if (num_chunks > 0) read_chunk(0);
+    for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+        if (io) {
+            io->submit([&, chunk] {
+                if (out && chunk > 0) write_chunk(chunk - 1);
+                if (chunk + 1 < num_chunks) read_chunk(chunk + 1);
+            });
+        }
+
+        std::vector<const void*> blocks;
+        for (const auto& block : in_blocks[chunk % 2]) blocks.push_back(block.get());
+        try {
+            compute(chunk * chunk_rows, chunk_size(chunk), blocks, out ? out_blocks[chunk % 2].get() : nullptr);
+        } catch (...) {
+            if (io) io->wait();
+            throw;
+        }
+        if (io) io->get();
+    }
+    if (out && num_chunks > 0) write_chunk(num_chunks - 1);
+}
@@ -0,0 +1,178 @@
+#ifndef STREAMING_HPP
+#define STREAMING_HPP
+
+#include "tensor.hpp"
+#include "utils.hpp"
+#include "functional.hpp"
+#include "serialization.hpp"
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Out-of-core execution: ops over tensors stored in tensor files (see serialization.hpp) that
+// process them in blocks of rows (slices along dim 0), so only a few blocks are in memory at a time.
+namespace streaming {
+
+// Default memory budget of one block of every streamed tensor together
+const size_t DEFAULT_CHUNK_BYTES = size_t(64) << 20;
+
+// A contiguous tensor in a tensor file, read and written in blocks of rows with positioned
+// I/O instead of being loaded whole. Copies share the open file.
+class FileTensor {
+public:
+    DataType dtype = DataType::FLOAT32;
+    Dims shape;
+
+    // Tensor name of an existing file, opened read-only until rows are first written
+    static FileTensor open(const std::string& path, const std::string& name);
+    // New file holding a single zero-filled tensor
+    static FileTensor create(const std::string& path, const std::string& name, DataType dtype, const Dims& shape);
+
+    size_t rows() const;        // Size of dim 0 (1 for a scalar)
+    size_t row_bytes() const;
+
+    void read_rows(size_t begin, size_t count, void* dst) const;
+    void write_rows(size_t begin, size_t count, const void* src) const;
+
+    struct File;
+
+private:
+    std::shared_ptr<File> file;
+    uint64_t offset = 0;   // Of the payload in the file
+};
+
+// Rows per block such that one block of each tensor fits in chunk_bytes together (at least 1)
+size_t chunk_rows(const std::vector<const FileTensor*>& tensors, size_t chunk_bytes);
+
+// Calls compute(begin, rows, inputs, output) on consecutive blocks of chunk_rows rows of the
+// inputs, which share dim 0. inputs holds the blocks read and output the block to fill, written
+// to out if given (out must have the same rows). The next blocks are read, and the previous
+// output written, while compute runs, by one background thread started for the whole call, so at
+// most two blocks of each tensor are resident.
+using ChunkFn = std::function<void(size_t begin, size_t rows, const std::vector<const void*>& inputs, void* output)>;
+void for_each_chunk(const std::vector<const FileTensor*>& inputs, const FileTensor* out, size_t chunk_rows,
+                    const ChunkFn& compute);
+
+namespace detail {
+
+template<typename T>
+void check_dtype(const FileTensor& t) {
+    if (t.dtype != get_dtype<T>()) {
+        throw std::invalid_argument("File tensor of dtype " + dtype_to_str(t.dtype) + " used as " + dtype_to_str(get_dtype<T>()));
+    }
+}
+
+// Non-owning tensor over a block of rows of t
+template<typename T>
+Tensor<T> block_view(const FileTensor& t, const void* data, size_t rows) {
+    Dims shape = t.shape;
+    if (!shape.empty()) shape[0] = static_cast<int>(rows);
+    T* ptr = static_cast<T*>(const_cast<void*>(data));
+    return Tensor<T>(std::shared_ptr<T[]>(ptr, [](T*) {}), shape);
+}
+
+template<typename T, typename Forward>
+void binary(const FileTensor& a, const FileTensor& b, const FileTensor& out, size_t chunk_bytes, Forward forward) {
+    check_dtype<T>(a);
+    check_dtype<T>(b);
+    check_dtype<T>(out);
+    if (a.shape != b.shape || a.shape != out.shape) {
+        throw std::invalid_argument("Streamed elementwise ops need operands and output of the same shape");
+    }
+    for_each_chunk({&a, &b}, &out, chunk_rows({&a, &b, &out}, chunk_bytes),
+        [&](size_t, size_t rows, const std::vector<const void*>& inputs, void* output) {
+            forward(block_view<T>(a, inputs[0], rows), block_view<T>(b, inputs[1], rows), block_view<T>(out, output, rows));
+        });
+}
+
+// Reduces each block with reduce and then the per-block results with combine
+template<typename T, typename R, typename Reduce, typename Combine>
+Tensor<R> reduce(const FileTensor& t, size_t chunk_bytes, Reduce reduce, Combine combine) {
+    check_dtype<T>(t);
+    std::vector<R> partials;
+    for_each_chunk({&t}, nullptr, chunk_rows({&t}, chunk_bytes),
+        [&](size_t, size_t rows, const std::vector<const void*>& inputs, void*) {
+            partials.push_back(reduce(block_view<T>(t, inputs[0], rows)).data[0]);
+        });
+    Tensor<R> values = Tensor<R>::empty({static_cast<int>(partials.size())});
+    std::copy(partials.begin(), partials.end(), values.data.get());
+    return combine(values);
+}
+
+} // namespace detail
+
+// out = a + b, elementwise over operands of the same shape
+template<typename T>
+void add(const FileTensor& a, const FileTensor& b, const FileTensor& out, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+    detail::binary<T>(a, b, out, chunk_bytes, [](const Tensor<T>& x, const Tensor<T>& y, const Tensor<T>& o) {
+        cpu::add_forward(x, y, o);
+    });
+}
+
+// out = a * b, elementwise over operands of the same shape
+template<typename T>
+void mul(const FileTensor& a, const FileTensor& b, const FileTensor& out, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+    detail::binary<T>(a, b, out, chunk_bytes, [](const Tensor<T>& x, const Tensor<T>& y, const Tensor<T>& o) {
+        cpu::mul_forward(x, y, o);
+    });
+}
+
+// out[M, N] = a[M, K] @ b[K, N], streaming the rows of a and out while b stays in memory
+template<typename T>
+void matmul(const FileTensor& a, const Tensor<T>& b, const FileTensor& out, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+    detail::check_dtype<T>(a);
+    detail::check_dtype<T>(out);
+    if (a.shape.size() != 2 || b.ndim != 2 || out.shape.size() != 2 || a.shape[1] != b.shape[0]
+        || out.shape[0] != a.shape[0] || out.shape[1] != b.shape[1]) {
+        throw std::invalid_argument("Streamed matmul needs a [M, K], b [K, N] and out [M, N]");
+    }
+    Tensor<T> rhs = b.contiguous();
+    for_each_chunk({&a}, &out, chunk_rows({&a, &out}, chunk_bytes),
+        [&](size_t, size_t rows, const std::vector<const void*>& inputs, void* output) {
+            Tensor<T> lhs = detail::block_view<T>(a, inputs[0], rows);
+            cpu::matmul_forward(lhs, rhs, detail::block_view<T>(out, output, rows));
+        });
+}
+
+// Reductions over all the elements
+template<typename T>
+Tensor<sum_result_t<T>> sum(const FileTensor& t, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+    using R = sum_result_t<T>;
+    return detail::reduce<T, R>(t, chunk_bytes, [](const Tensor<T>& block) { return F::sum(block); },
+                                [](const Tensor<R>& partials) { return F::sum(partials); });
+}
+
+template<typename T>
+Tensor<float32> mean(const FileTensor& t, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+    detail::check_dtype<T>(t);
+    double total = 0.0;
+    size_t count = 0;
+    for_each_chunk({&t}, nullptr, chunk_rows({&t}, chunk_bytes),
+        [&](size_t, size_t rows, const std::vector<const void*>& inputs, void*) {
+            Tensor<T> block = detail::block_view<T>(t, inputs[0], rows);
+            total += static_cast<double>(F::sum(block).data[0]);
+            count += block.numel;
+        });
+    float32 value = count == 0 ? std::numeric_limits<float32>::quiet_NaN() : static_cast<float32>(total / count);
+    return Tensor<float32>::full({}, value);
+}
+
+template<typename T>
+Tensor<T> max(const FileTensor& t, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+    return detail::reduce<T, T>(t, chunk_bytes, [](const Tensor<T>& block) { return F::max(block); },
+                                [](const Tensor<T>& partials) { return F::max(partials); });
+}
+
+template<typename T>
+Tensor<T> min(const FileTensor& t, size_t chunk_bytes = DEFAULT_CHUNK_BYTES) {
+    return detail::reduce<T, T>(t, chunk_bytes, [](const Tensor<T>& block) { return F::min(block); },
+                                [](const Tensor<T>& partials) { return F::min(partials); });
+}
+
+} // namespace streaming
+
+#endif
@@ -2,6 +2,9 @@
 #include "tensor.hpp"
 #include "utils.hpp"
 #include "functional.hpp"
+#include "iterator.hpp"
+#include "allocator.hpp"
+#include "profiler.hpp"
 
 #include <stdexcept>
 #include <numeric>
@@ -10,6 +13,8 @@
 template class Tensor<uint8>;
 template class Tensor<int32>;
 template class Tensor<float32>;
+template class Tensor<float16>;
+template class Tensor<bfloat16>;
 
 
 // Default constructor
@@ -20,7 +25,7 @@ Tensor<T>::Tensor()
 template<typename T>
 Tensor<T>::Tensor(
     const std::shared_ptr<T[]>& data,
-    const std::vector<int>& shape) 
+    const Dims& shape) 
     : 
     data(data), 
     numel(std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>())), 
@@ -32,26 +37,31 @@ Tensor<T>::Tensor(
 template<typename T>
 Tensor<T>::Tensor(
     const std::shared_ptr<T[]>& data,
-    const std::vector<int>& shape,
-    const std::vector<int>& strides)
+    const Dims& shape,
+    const Dims& strides)
     :
     data(data),
     numel(std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>())),
     shape(shape),
     ndim(static_cast<int>(shape.size())),
     dtype(get_dtype<T>()),
-    strides(strides) {}
+    strides(strides),
+    is_contiguous(utils::is_contiguous(shape, strides)),
+    is_dense(utils::is_dense(shape, strides)),
+    has_broadcast(utils::has_broadcast_dims(shape, strides)) {}
 
 
 template<typename T>
-Tensor<T> Tensor<T>::empty(const std::vector<int>& shape) {
+Tensor<T> Tensor<T>::empty(const Dims& shape) {
     int numel = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>());
-    std::shared_ptr<T[]> data = std::shared_ptr<T[]>(new T[numel]);
-    return Tensor<T>(data, shape);
+    std::shared_ptr<T[]> data = memory::allocate_shared<T>(numel);
+    Tensor<T> tensor(data, shape);
+    graph::record_allocation(tensor);
+    return tensor;
 }
 
 template<typename T>
-Tensor<T> Tensor<T>::full(const std::vector<int>& shape, double value) {
+Tensor<T> Tensor<T>::full(const Dims& shape, double value) {
     Tensor<T> tensor = Tensor<T>::empty(shape);
     T cvalue = utils::cast_value<T>(value);
 
@@ -62,12 +72,12 @@ Tensor<T> Tensor<T>::full(const std::vector<int>& shape, double value) {
 }
 
 template<typename T>
-Tensor<T> Tensor<T>::ones(const std::vector<int>& shape) {
+Tensor<T> Tensor<T>::ones(const Dims& shape) {
     return Tensor<T>::full(shape, 1.0);
 }
 
 template<typename T>
-Tensor<T> Tensor<T>::zeros(const std::vector<int>& shape) {
+Tensor<T> Tensor<T>::zeros(const Dims& shape) {
     return Tensor<T>::full(shape, 0.0);
 }
 
@@ -85,14 +95,12 @@ Tensor<T>& Tensor<T>::operator+=(const Tensor<T>& t2) {
 
 template<typename T>
 Tensor<T> Tensor<T>::operator+(const double value) const {
-    Tensor<T> t2 = Tensor<T>::full({1}, value);
-    return F::add(*this, t2);
+    return F::add(*this, value);
 }
 
 template<typename T>
 Tensor<T>& Tensor<T>::operator+=(const double value) {
-    Tensor<T> t2 = Tensor<T>::full({1}, value);
-    F::add(*this, t2, true);
+    F::add(*this, value, *this);
     return *this;
 }
 
@@ -109,14 +117,12 @@ Tensor<T>& Tensor<T>::operator*=(const Tensor<T>& t2) {
 
 template<typename T>
 Tensor<T> Tensor<T>::operator*(const double value) const {
-    Tensor<T> t2 = Tensor<T>::full({1}, value);
-    return F::mul(*this, t2);
+    return F::mul(*this, value);
 }
 
 template<typename T>
 Tensor<T>& Tensor<T>::operator*=(const double value) {
-    Tensor<T> t2 = Tensor<T>::full({1}, value);
-    F::mul(*this, t2, true);
+    F::mul(*this, value, *this);
     return *this;
 }
 
@@ -130,28 +136,6 @@ Tensor<T> Tensor<T>::matmul(const Tensor<T>& t2) const {
     return F::matmul(*this, t2);
 }
 
-// Tensor Tensor::operator[](int index) const {
-//     if (index < 0 || index >= this->shape[0]) {
-//         throw std::out_of_range("Index out of range");
-//     }
-
-//     DataType out_dtype = this->dtype;
-//     size_t out_numel = this->numel / this->shape[0];
-    
-//     std::vector<int> out_shape(this->shape.begin() + 1, this->shape.end());
-
-//     size_t offset = index * out_numel;
-
-//     TensorData out_data = std::visit([offset](auto& data_ptr) -> TensorData {
-//         using T = std::decay_t<decltype(data_ptr.get()[0])>;
-//         // Create a new shared_ptr that points to the correct offset
-//         return std::shared_ptr<T[]>(data_ptr, data_ptr.get() + offset);
-//     }, this->data);
-
-//     return Tensor(out_data, out_numel, out_shape, out_dtype);
-// }
-
-
 template<typename T>
 T Tensor<T>::get(int idx) const {
     return *(this->get_ptr(idx));
@@ -159,21 +143,19 @@ T Tensor<T>::get(int idx) const {
 
 template<typename T>
 T* Tensor<T>::get_ptr(int idx) const {
-    if (!this->is_view) return this->data.get() + idx;
+    if (this->is_contiguous) return this->data.get() + idx;
+    // Random access only, bulk loops walk the strides with a StridedIterator instead
     int offset = 0;
-    for (int i=0; i < this->ndim; i++) {
-        if (idx < this->strides[i]) continue;
-        int blocks = idx % this->shape[i];
-        int nelem = blocks * this->strides[i];
-        offset += nelem;
-        idx -= nelem;
+    for (int i = this->ndim - 1; i >= 0; i--) {
+        offset += (idx % this->shape[i]) * this->strides[i];
+        idx /= this->shape[i];
     }
     return this->data.get() + offset;
 }
 
 template<typename T>
-Tensor<T> Tensor<T>::view(const std::vector<int>& shape) const {
-    std::vector<int> new_shape(shape);
+Tensor<T> Tensor<T>::view(const Dims& shape) const {
+    Dims new_shape(shape);
     // Check if there's at most one -1 in the new shape
     int neg_one_count = static_cast<int>(std::count(new_shape.begin(), new_shape.end(), -1));
     if (neg_one_count > 1) {
@@ -207,6 +189,14 @@ Tensor<T> Tensor<T>::view(const std::vector<int>& shape) const {
         throw std::invalid_argument("New shape does not match the number of elements in the tensor");
     }
 
+    // Strided layouts cannot be reinterpreted in place, so they are materialized first: the
+    // result is a copy, not a view, and writes to it don't reach this tensor
+    if (!this->is_contiguous) {
+        Tensor<T> copy = this->contiguous().view(new_shape);
+        copy.is_view = false;
+        return copy;
+    }
+
     // Create a new Tensor with the same data but new shape
     Tensor<T> viewed_tensor(this->data, new_shape);
     viewed_tensor.is_view = true;
@@ -215,7 +205,7 @@ Tensor<T> Tensor<T>::view(const std::vector<int>& shape) const {
 }
 
 template<typename T>
-Tensor<T> Tensor<T>::expand(const std::vector<int>& shape) const {
+Tensor<T> Tensor<T>::expand(const Dims& shape) const {
     if (utils::shapes_equal(this->shape, shape)) return *this;
 
 
@@ -224,8 +214,8 @@ Tensor<T> Tensor<T>::expand(const std::vector<int>& shape) const {
         throw std::invalid_argument("New shape must have at least as many dimensions as the current shape");
     }
 
-    std::vector<int> current_shape = this->shape;
-    std::vector<int> current_strides = this->strides;
+    Dims current_shape = this->shape;
+    Dims current_strides = this->strides;
 
     // Pad the current shape and strides with 1's and 0's at the front if necessary
     while (current_shape.size() < shape.size()) {
@@ -233,11 +223,11 @@ Tensor<T> Tensor<T>::expand(const std::vector<int>& shape) const {
         current_strides.insert(current_strides.begin(), 0);
     }
 
-    std::vector<int> new_strides(shape.size());
+    Dims new_strides(shape.size());
 
     // Check compatibility and compute new strides
     for (size_t i = 0; i < shape.size(); ++i) {
-        if (shape[i] < current_shape[i]) {
+        if (shape[i] < current_shape[i] && current_shape[i] != 1) {
             std::ostringstream oss;
             oss << "Cannot broadcast to a smaller size. Dimension " << i 
                 << " of input is " << current_shape[i] 
@@ -247,7 +237,7 @@ Tensor<T> Tensor<T>::expand(const std::vector<int>& shape) const {
         if (current_shape[i] == shape[i]) {
             new_strides[i] = current_strides[i];
         } else if (current_shape[i] == 1) {
-            new_strides[i] = 0;  // Broadcast this dimension
+            new_strides[i] = 0;  // Broadcast this dimension, also to size 0 as in broadcast_shapes
         } else {
             std::ostringstream oss;
             oss << "Shape is not compatible for broadcasting at dimension " << i 
@@ -266,74 +256,254 @@ Tensor<T> Tensor<T>::expand(const std::vector<int>& shape) const {
 }
 
 template<typename T>
-Tensor<T> Tensor<T>::broadcast_to(const std::vector<int>& shape) const {
+Tensor<T> Tensor<T>::broadcast_to(const Dims& shape) const {
     return this->expand(shape);
 }
 
+// squeeze and unsqueeze only drop or add dims of size 1 in the shape and strides, so they are
+// views of any layout
 template<typename T>
-Tensor<T> Tensor<T>::squeeze(const std::vector<int>& dims) const {
-    std::vector<int> new_shape = shape;
-    
-    // If specific dimensions are provided
-    if (!dims.empty()) {
-        for (int dim : dims) {
-            if (dim < 0 || dim >= ndim) {
-                throw std::invalid_argument("Dimension out of range for squeeze");
-            }
-            if (shape[dim] != 1) {
-                throw std::invalid_argument("Cannot squeeze a dimension that is not 1");
-            }
-            // Erase the dimension
-            new_shape.erase(new_shape.begin() + dim);
-        }
-    } 
+Tensor<T> Tensor<T>::squeeze(const Dims& dims) const {
     // If no dimensions are provided, squeeze all dimensions of size 1
-    else {
-        new_shape.erase(
-            std::remove(new_shape.begin(), new_shape.end(), 1),
-            new_shape.end()
-        );
+    DimMask removed(ndim, dims.empty());
+    for (int dim : dims) {
+        if (dim < 0 || dim >= ndim) {
+            throw std::invalid_argument("Dimension out of range for squeeze");
+        }
+        if (shape[dim] != 1) {
+            throw std::invalid_argument("Cannot squeeze a dimension that is not 1");
+        }
+        removed[dim] = true;
     }
-    
-    return this->view(new_shape);
+
+    Dims new_shape, new_strides;
+    for (int d = 0; d < ndim; d++) {
+        if (removed[d] && shape[d] == 1) continue;
+        new_shape.push_back(shape[d]);
+        new_strides.push_back(strides[d]);
+    }
+    Tensor<T> result(this->data, new_shape, new_strides);
+    result.is_view = true;
+    return result;
 }
 
 template<typename T>
-Tensor<T> Tensor<T>::unsqueeze(const std::vector<int>& dims) const {
-    std::vector<int> new_shape = shape;
+Tensor<T> Tensor<T>::unsqueeze(const Dims& dims) const {
+    Dims new_shape = shape, new_strides = strides;
     
     // Sort the dimensions to unsqueeze, so we can insert them in the correct order
-    std::vector<int> sorted_dims = dims;
+    Dims sorted_dims = dims;
     std::sort(sorted_dims.begin(), sorted_dims.end());
     
     for (int dim : sorted_dims) {
-        if (dim < 0 || dim > ndim) {
+        // Dims index the result, which has one more dim after each insertion
+        if (dim < 0 || dim > static_cast<int>(new_shape.size())) {
             throw std::invalid_argument("Dimension out of range for unsqueeze");
         }
-        // Insert a new dimension of size 1 at the specified position
+        // Insert a new dimension of size 1 at the specified position, with the stride that
+        // steps over the dim after it (never used, since the dim has a single element)
+        int stride = dim < static_cast<int>(new_shape.size()) ? new_strides[dim] * new_shape[dim] : 1;
         new_shape.insert(new_shape.begin() + dim, 1);
+        new_strides.insert(new_strides.begin() + dim, stride);
     }
-    
-    return this->view(new_shape);
+
+    Tensor<T> result(this->data, new_shape, new_strides);
+    result.is_view = true;
+    return result;
+}
+
+namespace {
+
+// Dim index from one that may count from the end
+int wrap_dim(int dim, int ndim, const char* op) {
+    int wrapped = dim < 0 ? dim + ndim : dim;
+    if (wrapped < 0 || wrapped >= ndim) {
+        throw std::out_of_range(std::string("Dimension ") + std::to_string(dim) + " out of range for " + op +
+                                " of a tensor with " + std::to_string(ndim) + " dims");
+    }
+    return wrapped;
+}
+
+} // namespace
+
+template<typename T>
+Tensor<T> Tensor<T>::operator[](int index) const {
+    return select(0, index);
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::select(int dim, int index) const {
+    dim = wrap_dim(dim, ndim, "select");
+    int wrapped = index < 0 ? index + shape[dim] : index;
+    if (wrapped < 0 || wrapped >= shape[dim]) {
+        throw std::out_of_range("Index " + std::to_string(index) + " out of range for dimension " + std::to_string(dim) +
+                                " of size " + std::to_string(shape[dim]));
+    }
+    Dims new_shape = shape, new_strides = strides;
+    new_shape.erase(new_shape.begin() + dim);
+    new_strides.erase(new_strides.begin() + dim);
+    // Aliasing pointer: shares ownership of the storage but starts at the selected element
+    std::shared_ptr<T[]> offset_data(this->data, this->data.get() + static_cast<std::ptrdiff_t>(wrapped) * strides[dim]);
+    Tensor<T> result(offset_data, new_shape, new_strides);
+    result.is_view = true;
+    return result;
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::narrow(int dim, int start, int length) const {
+    dim = wrap_dim(dim, ndim, "narrow");
+    if (start < 0) start += shape[dim];
+    if (start < 0 || length < 0 || start + length > shape[dim]) {
+        throw std::out_of_range("narrow(" + std::to_string(dim) + ", " + std::to_string(start) + ", " +
+                                std::to_string(length) + ") out of range for dimension of size " + std::to_string(shape[dim]));
+    }
+    return slice(dim, start, start + length, 1);
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::slice(int dim, int start, int stop, int step) const {
+    dim = wrap_dim(dim, ndim, "slice");
+    if (step <= 0) throw std::invalid_argument("Slice step must be positive");
+    // Python semantics: negative bounds count from the end, out of range ones are clamped
+    int size = shape[dim];
+    if (start < 0) start += size;
+    if (stop < 0) stop += size;
+    start = std::clamp(start, 0, size);
+    stop = std::clamp(stop, start, size);
+
+    Dims new_shape = shape, new_strides = strides;
+    new_shape[dim] = (stop - start + step - 1) / step;
+    new_strides[dim] = strides[dim] * step;
+    std::shared_ptr<T[]> offset_data(this->data, this->data.get() + static_cast<std::ptrdiff_t>(start) * strides[dim]);
+    Tensor<T> result(offset_data, new_shape, new_strides);
+    result.is_view = true;
+    return result;
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::permute(const Dims& dims) const {
+    if (dims.size() != static_cast<size_t>(ndim)) {
+        throw std::invalid_argument("permute needs one dim for each of the " + std::to_string(ndim) + " dims of the tensor");
+    }
+    Dims new_shape(ndim), new_strides(ndim);
+    DimMask used(ndim, false);
+    for (int i = 0; i < ndim; i++) {
+        int dim = dims[i] < 0 ? dims[i] + ndim : dims[i];
+        if (dim < 0 || dim >= ndim) throw std::invalid_argument("Dimension out of range for permute");
+        if (used[dim]) throw std::invalid_argument("Repeated dimension in permute");
+        used[dim] = true;
+        new_shape[i] = shape[dim];
+        new_strides[i] = strides[dim];
+    }
+    Tensor<T> result(this->data, new_shape, new_strides);
+    result.is_view = true;
+    return result;
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::transpose(int dim0, int dim1) const {
+    Dims dims(ndim);
+    for (int i = 0; i < ndim; i++) dims[i] = i;
+    if (dim0 < 0) dim0 += ndim;
+    if (dim1 < 0) dim1 += ndim;
+    if (dim0 < 0 || dim0 >= ndim || dim1 < 0 || dim1 >= ndim) {
+        throw std::invalid_argument("Dimension out of range for transpose");
+    }
+    std::swap(dims[dim0], dims[dim1]);
+    return permute(dims);
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::transpose() const {
+    Dims dims(ndim);
+    for (int i = 0; i < ndim; i++) dims[i] = ndim - 1 - i;
+    return permute(dims);
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::contiguous() const {
+    if (this->is_contiguous) return *this;
+    Tensor<T> result = Tensor<T>::empty(this->shape);
+    cpu::copy_forward(*this, result);
+    return result;
+}
+
+template<typename T>
+Tensor<sum_result_t<T>> Tensor<T>::sum(const Dims& dims, bool keepdim) const {
+    return F::sum(*this, dims, keepdim);
+}
+
+template<typename T>
+Tensor<float32> Tensor<T>::mean(const Dims& dims, bool keepdim) const {
+    return F::mean(*this, dims, keepdim);
+}
+
+template<typename T>
+Tensor<sum_result_t<T>> Tensor<T>::prod(const Dims& dims, bool keepdim) const {
+    return F::prod(*this, dims, keepdim);
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::max(const Dims& dims, bool keepdim) const {
+    return F::max(*this, dims, keepdim);
+}
+
+template<typename T>
+Tensor<T> Tensor<T>::min(const Dims& dims, bool keepdim) const {
+    return F::min(*this, dims, keepdim);
+}
+
+template<typename T>
+Tensor<int32> Tensor<T>::argmax(const Dims& dims, bool keepdim) const {
+    return F::argmax(*this, dims, keepdim);
 }
 
 template<typename T>
 template<typename U>
 Tensor<U> Tensor<T>::to() const {
-    static_assert(is_allowed_tensor_type<U>::value, "Conversion is only allowed to uint8, int32, and float32");
-
     if constexpr (std::is_same_v<T, U>) return *this;
+    return to<U>(1.0f, 0.0f);
+}
+
+template<typename T>
+template<typename U>
+Tensor<U> Tensor<T>::to(float32 scale, float32 shift) const {
+    static_assert(is_allowed_tensor_type<U>::value, "Conversion is only allowed to uint8, int32, float32, float16 and bfloat16");
+
+    profiler::Scope scope("to");
+
     // Create a new tensor with the same shape but new type
     Tensor<U> result = Tensor<U>::empty(this->shape);
-
-    // Copy and cast each element
-    for (size_t i = 0; i < this->numel; ++i) {
-        *(result.get_ptr(i)) = static_cast<U>(this->get(i));
+    cpu::convert_forward(*this, result, scale, shift);
+    if (scope.active()) {
+        bool affine = scale != 1.0f || shift != 0.0f;
+        scope.describe({&this->shape}, dtype_to_str(this->dtype) + "->" + dtype_to_str(result.dtype),
+                       this->numel * (sizeof(T) + sizeof(U)), affine ? 2 * this->numel : 0);
     }
-
     return result;
 }
 
+// Conversions between every pair of supported types
+#define INSTANTIATE_TO(T) \
+    template Tensor<uint8> Tensor<T>::to<uint8>() const; \
+    template Tensor<int32> Tensor<T>::to<int32>() const; \
+    template Tensor<float32> Tensor<T>::to<float32>() const; \
+    template Tensor<float16> Tensor<T>::to<float16>() const; \
+    template Tensor<bfloat16> Tensor<T>::to<bfloat16>() const; \
+    template Tensor<uint8> Tensor<T>::to<uint8>(float32, float32) const; \
+    template Tensor<int32> Tensor<T>::to<int32>(float32, float32) const; \
+    template Tensor<float32> Tensor<T>::to<float32>(float32, float32) const; \
+    template Tensor<float16> Tensor<T>::to<float16>(float32, float32) const; \
+    template Tensor<bfloat16> Tensor<T>::to<bfloat16>(float32, float32) const;
+
+INSTANTIATE_TO(uint8)
+INSTANTIATE_TO(int32)
+INSTANTIATE_TO(float32)
+INSTANTIATE_TO(float16)
+INSTANTIATE_TO(bfloat16)
+
+#undef INSTANTIATE_TO
+
 template<typename T>
 std::string Tensor<T>::to_string() const {
     size_t mem_size = this->numel * get_dtype_size(this->dtype);
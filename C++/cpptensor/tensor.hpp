@@ -2,6 +2,7 @@
 #define TENSOR_HPP
 
 #include "dtype.hpp"
+#include "dims.hpp"
 
 #include <iostream>
 #include <vector>
@@ -16,34 +17,48 @@ struct is_allowed_tensor_type : std::false_type {};
 template<> struct is_allowed_tensor_type<uint8> : std::true_type {};
 template<> struct is_allowed_tensor_type<int32> : std::true_type {};
 template<> struct is_allowed_tensor_type<float32> : std::true_type {};
+template<> struct is_allowed_tensor_type<float16> : std::true_type {};
+template<> struct is_allowed_tensor_type<bfloat16> : std::true_type {};
 
 
+// Thread safety: Tensor objects are plain handles to shared data. Any number of threads may
+// run ops (arithmetic, matmul, views, copies, conversions) concurrently as long as they only
+// read their inputs; each op writes to its own freshly allocated output. The shared pieces
+// they touch are thread-safe: the kernel thread pool accepts jobs from several callers, the
+// allocator is locked/per-thread and the GEMM packing buffers are thread_local.
+// In-place ops (+=, *=) write to their left operand, and views share data with their base:
+// writing a tensor while another thread reads it, or any view of it, needs external locking.
 template<typename T>
 class Tensor {
     // Manually check if the provided type is valid. Otherwise, it will raise a linker error but less intuitive
-    static_assert(is_allowed_tensor_type<T>::value, "Tensor only supports uint8, int32, and float32");
+    static_assert(is_allowed_tensor_type<T>::value, "Tensor only supports uint8, int32, float32, float16 and bfloat16");
 public:
     std::shared_ptr<T[]> data;
     size_t numel;
-    std::vector<int> shape;
+    Dims shape;
     int ndim;
     DataType dtype;
-    std::vector<int> strides;
-    bool is_view = false;
+    Dims strides;
+    bool is_view = false;          // Shares its data with another tensor
+
+    // Layout metadata, derived from shape and strides
+    bool is_contiguous = true;     // Row-major (C) order without gaps
+    bool is_dense = true;          // No gaps or overlaps, but possibly permuted dims
+    bool has_broadcast = false;    // Some dim of size > 1 has stride 0
 
     // Constructors
     Tensor();
-    Tensor(const std::shared_ptr<T[]>& data, const std::vector<int>& shape);
-    Tensor(const std::shared_ptr<T[]>& data, const std::vector<int>& shape, const std::vector<int>& strides);
+    Tensor(const std::shared_ptr<T[]>& data, const Dims& shape);
+    Tensor(const std::shared_ptr<T[]>& data, const Dims& shape, const Dims& strides);
 
     T get(int idx) const;
     T* get_ptr(int idx) const;
 
     // Initializers
-    static Tensor empty(const std::vector<int>& shape);
-    static Tensor full(const std::vector<int>& shape, double value);
-    static Tensor ones(const std::vector<int>& shape);
-    static Tensor zeros(const std::vector<int>& shape);
+    static Tensor empty(const Dims& shape);
+    static Tensor full(const Dims& shape, double value);
+    static Tensor ones(const Dims& shape);
+    static Tensor zeros(const Dims& shape);
 
     // Operator overloads
     Tensor operator+(const Tensor& t2) const;
@@ -57,17 +72,43 @@ public:
 
     static Tensor matmul(const Tensor& t1, const Tensor& t2);
     Tensor matmul(const Tensor& t2) const;
-    
-    // Tensor operator[](int index) const;
-
-    Tensor view(const std::vector<int>& shape) const;
-    Tensor expand(const std::vector<int>& shape) const;       // Broadcast
-    Tensor broadcast_to(const std::vector<int>& shape) const; // Same as expand
-    Tensor squeeze(const std::vector<int>& dims) const;
-    Tensor unsqueeze(const std::vector<int>& dims) const;
 
+    // Views into part of the tensor that share its storage through an aliasing pointer to their
+    // first element, so they cost O(1) and every op reads them like any strided tensor.
+    // Negative indices count from the end.
+    Tensor operator[](int index) const;                  // select(0, index)
+    Tensor select(int dim, int index) const;             // Element index of dim, which is removed
+    Tensor narrow(int dim, int start, int length) const; // length elements of dim from start
+    Tensor slice(int dim, int start, int stop, int step = 1) const;  // Python start:stop:step, clamped, step > 0
+
+    Tensor view(const Dims& shape) const;  // A copy (is_view false) if the layout is not contiguous
+    Tensor expand(const Dims& shape) const;       // Broadcast
+    Tensor broadcast_to(const Dims& shape) const; // Same as expand
+    Tensor squeeze(const Dims& dims) const;
+    Tensor unsqueeze(const Dims& dims) const;
+    // Views with reordered dims (negative dims count from the end): dim i of the result is dim
+    // dims[i] of this tensor. No data is moved; contiguous() makes a dense copy if one is needed.
+    Tensor permute(const Dims& dims) const;
+    Tensor transpose(int dim0, int dim1) const;  // Swaps two dims
+    Tensor transpose() const;                    // Reverses all dims (.T)
+    Tensor contiguous() const;  // Dense row-major copy, or the tensor itself if already contiguous
+
+    // Reductions over dims (negative dims count from the end, none means all)
+    Tensor<sum_result_t<T>> sum(const Dims& dims = {}, bool keepdim = false) const;
+    Tensor<float32> mean(const Dims& dims = {}, bool keepdim = false) const;
+    Tensor<sum_result_t<T>> prod(const Dims& dims = {}, bool keepdim = false) const;
+    Tensor max(const Dims& dims = {}, bool keepdim = false) const;
+    Tensor min(const Dims& dims = {}, bool keepdim = false) const;
+    Tensor<int32> argmax(const Dims& dims = {}, bool keepdim = false) const;  // Single dim or all
+
+    // Conversion to another dtype. Narrowing a floating value to an integer type truncates toward
+    // zero and saturates, while int32 to uint8 wraps like a C++ cast. The second form computes
+    // U(x * scale + shift) in one pass, e.g. to normalize; its values go through float32, so
+    // int32 values beyond 2^24 are rounded and integer results saturate.
     template<typename U>
     Tensor<U> to() const;
+    template<typename U>
+    Tensor<U> to(float32 scale, float32 shift) const;
 
     // String representation
     std::string to_string() const;
@@ -77,5 +118,7 @@ public:
 extern template class Tensor<uint8>;
 extern template class Tensor<int32>;
 extern template class Tensor<float32>;
+extern template class Tensor<float16>;
+extern template class Tensor<bfloat16>;
 
 #endif
\ No newline at end of file
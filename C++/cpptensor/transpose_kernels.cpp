@@ -0,0 +1,140 @@
+#include "transpose_kernels.hpp"
+#include "cpu_features.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#if defined(CPPTENSOR_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Square tiles small enough that the source and destination tile stay in L1 together,
+// so each cache line read or written is used in full before being evicted
+const size_t TILE = 32;
+
+template<typename E>
+void transpose_tile_scalar(const E* src, size_t ld_src, E* dst, size_t ld_dst, size_t rows, size_t cols) {
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) dst[i * ld_dst + j] = src[j * ld_src + i];
+    }
+}
+
+template<typename E, typename TileFn>
+void transpose_blocked(const void* src_, size_t ld_src, void* dst_, size_t ld_dst, size_t rows, size_t cols,
+                       TileFn tile) {
+    const E* src = static_cast<const E*>(src_);
+    E* dst = static_cast<E*>(dst_);
+    for (size_t i = 0; i < rows; i += TILE) {
+        for (size_t j = 0; j < cols; j += TILE) {
+            tile(src + j * ld_src + i, ld_src, dst + i * ld_dst + j, ld_dst,
+                 std::min(TILE, rows - i), std::min(TILE, cols - j));
+        }
+    }
+}
+
+template<typename E>
+void transpose_scalar(const void* src, size_t ld_src, void* dst, size_t ld_dst, size_t rows, size_t cols) {
+    transpose_blocked<E>(src, ld_src, dst, ld_dst, rows, cols, transpose_tile_scalar<E>);
+}
+
+#if defined(CPPTENSOR_X86)
+
+// ---------------------------------------------------------------- SSE4.2
+
+// 4x4 register transposes over the tile, scalar at the edges
+CPPTENSOR_TARGET("sse4.2")
+void transpose_tile_32_sse42(const uint32_t* src, size_t ld_src, uint32_t* dst, size_t ld_dst, size_t rows, size_t cols) {
+    size_t i = 0;
+    for (; i + 4 <= rows; i += 4) {
+        size_t j = 0;
+        for (; j + 4 <= cols; j += 4) {
+            const float* s = reinterpret_cast<const float*>(src + j * ld_src + i);
+            __m128 r0 = _mm_loadu_ps(s);
+            __m128 r1 = _mm_loadu_ps(s + ld_src);
+            __m128 r2 = _mm_loadu_ps(s + 2 * ld_src);
+            __m128 r3 = _mm_loadu_ps(s + 3 * ld_src);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            float* d = reinterpret_cast<float*>(dst + i * ld_dst + j);
+            _mm_storeu_ps(d, r0);
+            _mm_storeu_ps(d + ld_dst, r1);
+            _mm_storeu_ps(d + 2 * ld_dst, r2);
+            _mm_storeu_ps(d + 3 * ld_dst, r3);
+        }
+        transpose_tile_scalar(src + j * ld_src + i, ld_src, dst + i * ld_dst + j, ld_dst, 4, cols - j);
+    }
+    transpose_tile_scalar(src + i, ld_src, dst + i * ld_dst, ld_dst, rows - i, cols);
+}
+
+CPPTENSOR_TARGET("sse4.2")
+void transpose_32_sse42(const void* src, size_t ld_src, void* dst, size_t ld_dst, size_t rows, size_t cols) {
+    transpose_blocked<uint32_t>(src, ld_src, dst, ld_dst, rows, cols, transpose_tile_32_sse42);
+}
+
+// ---------------------------------------------------------------- AVX2
+
+// 8x8 register transposes over the tile: unpack pairs, then quads, then swap the 128-bit halves
+CPPTENSOR_TARGET("avx2")
+void transpose_tile_32_avx2(const uint32_t* src, size_t ld_src, uint32_t* dst, size_t ld_dst, size_t rows, size_t cols) {
+    size_t i = 0;
+    for (; i + 8 <= rows; i += 8) {
+        size_t j = 0;
+        for (; j + 8 <= cols; j += 8) {
+            const float* s = reinterpret_cast<const float*>(src + j * ld_src + i);
+            __m256 r[8], t[8];
+            for (int k = 0; k < 8; k++) r[k] = _mm256_loadu_ps(s + k * ld_src);
+            for (int k = 0; k < 8; k += 2) {
+                t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+                t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+            }
+            for (int k = 0; k < 8; k += 4) {
+                r[k] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+                r[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            float* d = reinterpret_cast<float*>(dst + i * ld_dst + j);
+            for (int k = 0; k < 4; k++) {
+                _mm256_storeu_ps(d + k * ld_dst, _mm256_permute2f128_ps(r[k], r[k + 4], 0x20));
+                _mm256_storeu_ps(d + (k + 4) * ld_dst, _mm256_permute2f128_ps(r[k], r[k + 4], 0x31));
+            }
+        }
+        transpose_tile_scalar(src + j * ld_src + i, ld_src, dst + i * ld_dst + j, ld_dst, 8, cols - j);
+    }
+    transpose_tile_scalar(src + i, ld_src, dst + i * ld_dst, ld_dst, rows - i, cols);
+}
+
+CPPTENSOR_TARGET("avx2")
+void transpose_32_avx2(const void* src, size_t ld_src, void* dst, size_t ld_dst, size_t rows, size_t cols) {
+    transpose_blocked<uint32_t>(src, ld_src, dst, ld_dst, rows, cols, transpose_tile_32_avx2);
+}
+
+#endif
+
+} // namespace
+
+
+cpu::transpose_kernel cpu::transpose_kernel_for(size_t elem_size) {
+    static const transpose_kernel kernel_32 = [] {
+#if defined(CPPTENSOR_X86)
+        switch (simd_level()) {
+            case SimdLevel::AVX512:
+            case SimdLevel::AVX2:   return transpose_32_avx2;
+            case SimdLevel::SSE42:  return transpose_32_sse42;
+            default: break;
+        }
+#endif
+        return transpose_scalar<uint32_t>;
+    }();
+
+    switch (elem_size) {
+        case 1: return transpose_scalar<uint8_t>;
+        case 2: return transpose_scalar<uint16_t>;
+        case 4: return kernel_32;
+        default: throw std::invalid_argument("No transpose kernel for elements of " + std::to_string(elem_size) + " bytes");
+    }
+}
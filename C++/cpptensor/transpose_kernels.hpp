@@ -0,0 +1,18 @@
+#ifndef TRANSPOSE_KERNELS_HPP
+#define TRANSPOSE_KERNELS_HPP
+
+#include <cstddef>
+
+namespace cpu {
+
+// dst[i * ld_dst + j] = src[j * ld_src + i] for i < rows and j < cols: writes the transpose of
+// a cols x rows block (row pitch ld_src elements) as a rows x cols block (row pitch ld_dst).
+// Elements are only moved, so the kernel depends on their size alone.
+using transpose_kernel = void (*)(const void* src, size_t ld_src, void* dst, size_t ld_dst, size_t rows, size_t cols);
+
+// Kernel for elements of elem_size bytes (1, 2 or 4), for the best instruction set of the host
+transpose_kernel transpose_kernel_for(size_t elem_size);
+
+} // namespace cpu
+
+#endif
@@ -1,12 +1,14 @@
 
 #include "utils.hpp"
 #include <utility>
+#include <algorithm>
 #include <stdexcept>
 #include <string>
+#include <cmath>
 
 
-std::vector<int> utils::calc_strides(const std::vector<int>& shape) {
-    std::vector<int> strides(shape.size());
+Dims utils::calc_strides(const Dims& shape) {
+    Dims strides(shape.size());
     size_t numel = 1;
     int i = static_cast<int>(shape.size()-1);
     for (i; i >= 0; i--) {
@@ -16,7 +18,7 @@ std::vector<int> utils::calc_strides(const std::vector<int>& shape) {
     return strides;
 }
 
-bool utils::shapes_equal(const std::vector<int>& shape1, const std::vector<int>& shape2) {
+bool utils::shapes_equal(const Dims& shape1, const Dims& shape2) {
     if (shape1.size() != shape2.size()) return false;
     for (int i=0; i < shape1.size(); i++) {
         if (shape1[i] != shape2[i]) return false;
@@ -24,9 +26,45 @@ bool utils::shapes_equal(const std::vector<int>& shape1, const std::vector<int>&
     return true;
 }
 
-std::vector<int> utils::broadcast_shapes(const std::vector<int>& shape1, const std::vector<int>& shape2) {
+bool utils::is_contiguous(const Dims& shape, const Dims& strides) {
+    if (std::find(shape.begin(), shape.end(), 0) != shape.end()) return true;
+    int expected = 1;
+    for (int i = static_cast<int>(shape.size()) - 1; i >= 0; i--) {
+        if (shape[i] == 1) continue;
+        if (strides[i] != expected) return false;
+        expected *= shape[i];
+    }
+    return true;
+}
+
+bool utils::is_dense(const Dims& shape, const Dims& strides) {
+    // Dense means the elements fill a block of numel values without gaps or overlaps,
+    // in any dimension order: sorted by stride, every dim must step over the previous ones
+    SmallVector<std::pair<int, int>, INLINE_DIMS> dims;
+    for (size_t i = 0; i < shape.size(); i++) {
+        if (shape[i] == 0) return true;
+        if (shape[i] != 1) dims.push_back({strides[i], shape[i]});
+    }
+    std::sort(dims.begin(), dims.end());
+
+    int expected = 1;
+    for (const auto& [stride, size] : dims) {
+        if (stride != expected) return false;
+        expected *= size;
+    }
+    return true;
+}
+
+bool utils::has_broadcast_dims(const Dims& shape, const Dims& strides) {
+    for (size_t i = 0; i < shape.size(); i++) {
+        if (shape[i] > 1 && strides[i] == 0) return true;
+    }
+    return false;
+}
+
+Dims utils::broadcast_shapes(const Dims& shape1, const Dims& shape2) {
     int max_dims = static_cast<int>(std::max(shape1.size(), shape2.size()));
-    std::vector<int> result(max_dims);
+    Dims result(max_dims);
 
     // Iterate from right to left (least significant dimension to most significant)
     for (int i = 1; i <= max_dims; ++i) {
@@ -49,11 +87,11 @@ std::vector<int> utils::broadcast_shapes(const std::vector<int>& shape1, const s
     return result;
 }
 
-std::pair<std::vector<int>, std::vector<int>> utils::broadcast_shapes_for_matmul(
-                const std::vector<int>& shape1, const std::vector<int>& shape2) {
+std::pair<Dims, Dims> utils::broadcast_shapes_for_matmul(
+                const Dims& shape1, const Dims& shape2) {
     // Ensure shapes have at least 2 dimensions
-    auto padded1 = shape1.size() < 2 ? std::vector<int>{1, shape1.back()} : shape1;
-    auto padded2 = shape2.size() < 2 ? std::vector<int>{shape2.front(), 1} : shape2;
+    auto padded1 = shape1.size() < 2 ? Dims{1, shape1.back()} : shape1;
+    auto padded2 = shape2.size() < 2 ? Dims{shape2.front(), 1} : shape2;
 
     // Check if the matrix dimensions are compatible
     if (padded1.back() != padded2[padded2.size() - 2]) {
@@ -63,11 +101,11 @@ std::pair<std::vector<int>, std::vector<int>> utils::broadcast_shapes_for_matmul
     }
 
     // Extract batch dimensions
-    std::vector<int> batch1(padded1.begin(), padded1.end() - 2);
-    std::vector<int> batch2(padded2.begin(), padded2.end() - 2);
+    Dims batch1(padded1.begin(), padded1.end() - 2);
+    Dims batch2(padded2.begin(), padded2.end() - 2);
 
     // Broadcast batch dimensions
-    std::vector<int> broadcasted_batch;
+    Dims broadcasted_batch;
     try {
         broadcasted_batch = broadcast_shapes(batch1, batch2);
     } catch (const std::runtime_error& e) {
@@ -75,11 +113,49 @@ std::pair<std::vector<int>, std::vector<int>> utils::broadcast_shapes_for_matmul
     }
 
     // Construct the final shapes
-    std::vector<int> result1 = broadcasted_batch;
+    Dims result1 = broadcasted_batch;
     result1.insert(result1.end(), padded1.end() - 2, padded1.end());
 
-    std::vector<int> result2 = broadcasted_batch;
+    Dims result2 = broadcasted_batch;
     result2.insert(result2.end(), padded2.end() - 2, padded2.end());
 
     return {result1, result2};
-}
\ No newline at end of file
+}
+
+DimMask utils::reduction_mask(const Dims& dims, int ndim) {
+    // No dims means all of them
+    DimMask mask(ndim, dims.empty());
+    for (int dim : dims) {
+        int d = dim < 0 ? dim + ndim : dim;
+        if (d < 0 || d >= ndim) {
+            throw std::invalid_argument("Dimension " + std::to_string(dim) + " out of range for reduction over " +
+                                        std::to_string(ndim) + " dims");
+        }
+        if (mask[d]) {
+            throw std::invalid_argument("Dimension " + std::to_string(dim) + " appears twice in the reduction");
+        }
+        mask[d] = true;
+    }
+    return mask;
+}
+
+Dims utils::reduced_shape(const Dims& shape, const DimMask& mask, bool keepdim) {
+    Dims result;
+    for (size_t d = 0; d < shape.size(); d++) {
+        if (!mask[d]) {
+            result.push_back(shape[d]);
+        } else if (keepdim) {
+            result.push_back(1);
+        }
+    }
+    return result;
+}
+
+void utils::check_quant_params(const QuantParams& params) {
+    if (!(params.scale > 0.0f) || !std::isfinite(params.scale)) {
+        throw std::invalid_argument("Quantization scale must be positive and finite, got " + std::to_string(params.scale));
+    }
+    if (params.zero_point < 0 || params.zero_point > 255) {
+        throw std::invalid_argument("Quantization zero point must be in [0, 255], got " + std::to_string(params.zero_point));
+    }
+}
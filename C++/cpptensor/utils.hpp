@@ -2,6 +2,7 @@
 #define UTILS_HPP
 
 #include "tensor.hpp"
+#include "iterator.hpp"
 
 #include <vector>
 #include <cstdint>
@@ -16,14 +17,33 @@ const int VALUES_PER_LINE = 8;
 
 namespace utils {
 
-std::vector<int> calc_strides(const std::vector<int>& shape);
+Dims calc_strides(const Dims& shape);
 
-bool shapes_equal(const std::vector<int>& shape1, const std::vector<int>& shape2);
+bool shapes_equal(const Dims& shape1, const Dims& shape2);
 
-std::vector<int> broadcast_shapes(const std::vector<int>& shape1, const std::vector<int>& shape2);
+// Layout queries on a shape/strides pair (dims of size 1 never matter)
+bool is_contiguous(const Dims& shape, const Dims& strides);
+bool is_dense(const Dims& shape, const Dims& strides);
+bool has_broadcast_dims(const Dims& shape, const Dims& strides);
 
-std::pair<std::vector<int>, std::vector<int>> broadcast_shapes_for_matmul(
-                const std::vector<int>& shape1, const std::vector<int>& shape2);
+Dims broadcast_shapes(const Dims& shape1, const Dims& shape2);
+
+std::pair<Dims, Dims> broadcast_shapes_for_matmul(
+                const Dims& shape1, const Dims& shape2);
+
+// Dims reduced by a reduction as a per-dim mask. Negative dims count from the end, no dims means all
+DimMask reduction_mask(const Dims& dims, int ndim);
+// Shape left by a reduction: reduced dims are dropped, or kept with size 1
+Dims reduced_shape(const Dims& shape, const DimMask& mask, bool keepdim);
+
+// Throws unless scale is positive and finite and zero_point is a uint8 value
+void check_quant_params(const QuantParams& params);
+
+// Whether two data pointers belong to the same allocation, e.g. a tensor and a view of it
+template<typename T>
+bool shares_storage(const std::shared_ptr<T[]>& a, const std::shared_ptr<T[]>& b) {
+    return a && b && !a.owner_before(b) && !b.owner_before(a);
+}
 
 template<typename T>
 T cast_value(double value) {
@@ -31,8 +51,9 @@ T cast_value(double value) {
 
     if (value > std::numeric_limits<T>::max()) {
         tvalue = std::numeric_limits<T>::max();
-    } else if (value < std::numeric_limits<T>::min()) {
-        tvalue = std::numeric_limits<T>::min();
+    } else if (value < std::numeric_limits<T>::lowest()) {
+        // lowest(), not min(): for floating types min() is the smallest positive value
+        tvalue = std::numeric_limits<T>::lowest();
     } else {
         tvalue = static_cast<T>(value);
     }
@@ -53,6 +74,10 @@ std::string array_to_string(const T* array, size_t length, int padding=0) {
         // Check if T is a floating-point type (e.g., float, double)
         else if constexpr (std::is_floating_point_v<T>) {
             oss << std::fixed << std::setprecision(DECIMALS) << array[i];
+        }
+        // Half-precision types print their float32 value
+        else if constexpr (is_half_v<T>) {
+            oss << std::fixed << std::setprecision(DECIMALS) << static_cast<float32>(array[i]);
         } 
         else {
             throw std::invalid_argument("Unsupported data type.");
@@ -72,8 +97,9 @@ std::string array_to_string(const T* array, size_t length, int padding=0) {
     return oss.str();
 }
 
-template <typename T>
-std::string vector_to_string(const std::vector<T>& vector, int padding=0) {
+// Any vector-like container with data() and size(), e.g. std::vector or Dims
+template <typename Vector>
+std::string vector_to_string(const Vector& vector, int padding=0) {
     return array_to_string(vector.data(), vector.size(), padding);
 }
 
@@ -81,8 +107,20 @@ template<typename T>
 std::string tensor_to_string(const Tensor<T>& tensor, int padding=0) {
     int ndim = tensor.ndim;
     int last_dim_size = tensor.shape[ndim - 1];
+    int last_dim_stride = tensor.strides[ndim - 1];
     size_t narrays = tensor.numel / last_dim_size;
-    std::vector<int> strides = calc_strides(tensor.shape);
+    Dims strides = calc_strides(tensor.shape);
+
+    // Start offset of every row, collected by walking the leading dims by strides
+    Dims row_shape(tensor.shape.begin(), tensor.shape.end() - 1);
+    Dims row_strides(tensor.strides.begin(), tensor.strides.end() - 1);
+    std::vector<std::ptrdiff_t> row_offsets;
+    row_offsets.reserve(narrays);
+    StridedIterator<1> iter(row_shape, {&row_strides});
+    iter.for_each([&](const auto& offsets, size_t n, const auto& inner_strides) {
+        for (size_t j = 0; j < n; j++) row_offsets.push_back(offsets[0] + j * inner_strides[0]);
+    });
+    std::vector<T> row_buffer(last_dim_stride == 1 ? 0 : last_dim_size);
 
     std::string buffer;
     int dims_ended = (ndim - 1);
@@ -94,8 +132,12 @@ std::string tensor_to_string(const Tensor<T>& tensor, int padding=0) {
         }
         buffer.append(dims_ended, '[');
 
-        // Get array string
-        T* array = tensor.get_ptr(i*last_dim_size);
+        // Get array string, gathering the row first if it is not contiguous
+        const T* array = tensor.data.get() + row_offsets[i];
+        if (last_dim_stride != 1) {
+            for (int j = 0; j < last_dim_size; j++) row_buffer[j] = array[j * last_dim_stride];
+            array = row_buffer.data();
+        }
         std::string array_str = array_to_string(array, last_dim_size, 7);
         buffer.append(array_str);
 
@@ -1,83 +1,544 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/operators.h>
+#include <pybind11/numpy.h>
 #include "cpptensor/tensor.hpp"
+#include "cpptensor/utils.hpp"
+#include "cpptensor/functional.hpp"
+#include "cpptensor/expression.hpp"
+#include "cpptensor/parallel.hpp"
+#include "cpptensor/cpu_features.hpp"
+#include "cpptensor/allocator.hpp"
+#include "cpptensor/serialization.hpp"
+#include "cpptensor/streaming.hpp"
+#include "cpptensor/profiler.hpp"
+#include "cpptensor/graph.hpp"
+
+#include <limits>
+#include <string>
 
 namespace py = pybind11;
 
+// float16 tensors share their buffer with numpy.float16 arrays ("e" in the buffer protocol).
+// NumPy has no bfloat16 type, so those tensors are converted to float32 instead.
+namespace pybind11 {
+template<> struct format_descriptor<float16> {
+    static std::string format() { return "e"; }
+};
+namespace detail {
+template<> struct npy_format_descriptor<float16> {
+    static constexpr auto name = const_name("float16");
+    static pybind11::dtype dtype() { return pybind11::dtype("float16"); }
+};
+// Shapes, strides and dims convert from and to Python lists like std::vector<int>
+template<> struct type_caster<Dims> : list_caster<Dims, int> {};
+} // namespace detail
+} // namespace pybind11
+
+// Call policy of the bindings that do not touch Python objects while they run
+using release_gil = py::call_guard<py::gil_scoped_release>;
+
+// Runs fn with the GIL released and converts its result once the GIL is held again
+template<typename Fn>
+py::object call_without_gil(Fn&& fn) {
+    auto result = [&] {
+        py::gil_scoped_release release;
+        return fn();
+    }();
+    return py::cast(std::move(result));
+}
+
 // Factory function to create Tensor based on dtype
-py::object create_tensor_ones(const std::vector<int>& shape, const DataType dt) {
+py::object create_tensor_ones(const Dims& shape, const DataType dt) {
     if (dt == DataType::UINT8) {
-        return py::cast(Tensor<uint8>::ones(shape));
+        return call_without_gil([&] { return Tensor<uint8>::ones(shape); });
     } else if (dt == DataType::INT32) {
-        return py::cast(Tensor<int32>::ones(shape));
+        return call_without_gil([&] { return Tensor<int32>::ones(shape); });
     } else if (dt == DataType::FLOAT32) {
-        return py::cast(Tensor<float32>::ones(shape));
+        return call_without_gil([&] { return Tensor<float32>::ones(shape); });
+    } else if (dt == DataType::FLOAT16) {
+        return call_without_gil([&] { return Tensor<float16>::ones(shape); });
+    } else if (dt == DataType::BFLOAT16) {
+        return call_without_gil([&] { return Tensor<bfloat16>::ones(shape); });
     }
 
     throw std::invalid_argument("Unsupported dtype for Tensor.ones");
 }
 
-py::object create_tensor_zeros(const std::vector<int>& shape, const DataType dt) {
+py::object create_tensor_zeros(const Dims& shape, const DataType dt) {
     if (dt == DataType::UINT8) {
-        return py::cast(Tensor<uint8>::zeros(shape));
+        return call_without_gil([&] { return Tensor<uint8>::zeros(shape); });
     } else if (dt == DataType::INT32) {
-        return py::cast(Tensor<int32>::zeros(shape));
+        return call_without_gil([&] { return Tensor<int32>::zeros(shape); });
     } else if (dt == DataType::FLOAT32) {
-        return py::cast(Tensor<float32>::zeros(shape));
+        return call_without_gil([&] { return Tensor<float32>::zeros(shape); });
+    } else if (dt == DataType::FLOAT16) {
+        return call_without_gil([&] { return Tensor<float16>::zeros(shape); });
+    } else if (dt == DataType::BFLOAT16) {
+        return call_without_gil([&] { return Tensor<bfloat16>::zeros(shape); });
     }
 
     throw std::invalid_argument("Unsupported dtype for Tensor.zeros");
 }
 
-py::object create_tensor_full(const std::vector<int>& shape, const DataType dt, double value) {
+py::object create_tensor_full(const Dims& shape, const DataType dt, double value) {
     if (dt == DataType::UINT8) {
-        return py::cast(Tensor<uint8>::full(shape, value));
+        return call_without_gil([&] { return Tensor<uint8>::full(shape, value); });
     } else if (dt == DataType::INT32) {
-        return py::cast(Tensor<int32>::full(shape, value));
+        return call_without_gil([&] { return Tensor<int32>::full(shape, value); });
     } else if (dt == DataType::FLOAT32) {
-        return py::cast(Tensor<float32>::full(shape, value));
+        return call_without_gil([&] { return Tensor<float32>::full(shape, value); });
+    } else if (dt == DataType::FLOAT16) {
+        return call_without_gil([&] { return Tensor<float16>::full(shape, value); });
+    } else if (dt == DataType::BFLOAT16) {
+        return call_without_gil([&] { return Tensor<bfloat16>::full(shape, value); });
     }
 
     throw std::invalid_argument("Unsupported dtype for Tensor.full");
 }
 
+// NumPy interop. Tensors and arrays share the same buffer; strides are translated
+// between elements (Tensor) and bytes (NumPy / buffer protocol)
+template<typename T>
+py::buffer_info tensor_buffer_info(const Tensor<T>& t) {
+    std::vector<py::ssize_t> shape(t.shape.begin(), t.shape.end());
+    std::vector<py::ssize_t> strides;
+    for (int stride : t.strides) {
+        strides.push_back(static_cast<py::ssize_t>(stride) * static_cast<py::ssize_t>(sizeof(T)));
+    }
+    // Broadcast dims alias one element, so writes through them would change every copy
+    return py::buffer_info(t.data.get(), sizeof(T), py::format_descriptor<T>::format(), t.ndim, shape, strides,
+                           t.has_broadcast);
+}
+
+template<typename T>
+py::array tensor_to_numpy(const Tensor<T>& t) {
+    if (!t.data) throw std::runtime_error("Cannot convert an uninitialized Tensor to a NumPy array");
+    py::buffer_info info = tensor_buffer_info(t);
+    // The capsule holds a reference to the tensor data for as long as the array lives
+    auto* owner = new std::shared_ptr<T[]>(t.data);
+    py::capsule base(owner, [](void* p) { delete static_cast<std::shared_ptr<T[]>*>(p); });
+    py::array array = py::array_t<T>(info.shape, info.strides, t.data.get(), base);
+    // Read-only like np.broadcast_to: one write would reach every broadcast copy of the element
+    if (t.has_broadcast) array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+// Tensor sizes and strides are int: larger NumPy ones would wrap around and alias other memory
+void check_int_layout(const py::array& array) {
+    const py::ssize_t limit = std::numeric_limits<int>::max();
+    for (py::ssize_t i = 0; i < array.ndim(); i++) {
+        py::ssize_t stride = array.strides(i) / array.itemsize();
+        if (array.shape(i) > limit || stride > limit || stride < -limit) {
+            throw py::value_error("from_numpy: dim " + std::to_string(i) + " has size " + std::to_string(array.shape(i)) +
+                                  " and stride " + std::to_string(stride) + " elements, which do not fit in a Tensor (int)");
+        }
+    }
+}
+
+template<typename T>
+Tensor<T> tensor_from_numpy(py::array array) {
+    // Zero-copy when dtype and strides can be represented by the tensor. Other dtypes,
+    // read-only arrays and negative or unaligned strides get a C-contiguous copy first.
+    check_int_layout(array);
+    bool shareable = py::isinstance<py::array_t<T>>(array) && array.writeable();
+    for (py::ssize_t i = 0; shareable && i < array.ndim(); i++) {
+        py::ssize_t stride = array.strides(i);
+        shareable = stride >= 0 && stride % static_cast<py::ssize_t>(sizeof(T)) == 0;
+    }
+    if (!shareable) {
+        array = py::array(array.attr("astype")(py::dtype::of<T>(), py::arg("order") = "C"));
+        check_int_layout(array);
+    }
+
+    Dims shape(array.ndim());
+    Dims strides(array.ndim());
+    for (py::ssize_t i = 0; i < array.ndim(); i++) {
+        shape[i] = static_cast<int>(array.shape(i));
+        strides[i] = static_cast<int>(array.strides(i) / static_cast<py::ssize_t>(sizeof(T)));
+    }
+
+    // The tensor data keeps the array alive. It may be released from a thread without the GIL
+    T* ptr = static_cast<T*>(array.mutable_data());
+    py::handle owner = array.inc_ref();
+    std::shared_ptr<T[]> data(ptr, [owner](T*) {
+        py::gil_scoped_acquire gil;
+        owner.dec_ref();
+    });
+
+    Tensor<T> tensor(data, shape, strides);
+    tensor.is_view = true;
+    return tensor;
+}
+
+// NumPy has no bfloat16, so these tensors are exported as and imported from float32 copies
+template<>
+py::array tensor_to_numpy(const Tensor<bfloat16>& t) {
+    if (!t.data) throw std::runtime_error("Cannot convert an uninitialized Tensor to a NumPy array");
+    Tensor<float32> values = [&] {
+        py::gil_scoped_release release;
+        return t.to<float32>();
+    }();
+    return tensor_to_numpy(values);
+}
+
+template<>
+Tensor<bfloat16> tensor_from_numpy(py::array array) {
+    Tensor<float32> values = tensor_from_numpy<float32>(array);
+    py::gil_scoped_release release;
+    return values.to<bfloat16>();
+}
+
+py::object create_tensor_from_numpy(const py::array& array) {
+    if (py::isinstance<py::array_t<uint8>>(array)) {
+        return py::cast(tensor_from_numpy<uint8>(array));
+    } else if (py::isinstance<py::array_t<int32>>(array)) {
+        return py::cast(tensor_from_numpy<int32>(array));
+    } else if (py::isinstance<py::array_t<float32>>(array)) {
+        return py::cast(tensor_from_numpy<float32>(array));
+    } else if (py::isinstance<py::array_t<float16>>(array)) {
+        return py::cast(tensor_from_numpy<float16>(array));
+    }
+
+    throw std::invalid_argument("Unsupported dtype for from_numpy: " + py::str(array.dtype()).cast<std::string>());
+}
+
+// Copy of t converted to another dtype
+template<typename T>
+py::object tensor_to_dtype(const Tensor<T>& t, const DataType dt, float32 scale, float32 shift) {
+    // Converts as U(x * scale + shift); the plain conversion keeps a same-dtype tensor as is
+    auto convert = [&](auto tag) {
+        using U = decltype(tag);
+        bool affine = scale != 1.0f || shift != 0.0f;
+        return call_without_gil([&] { return affine ? t.template to<U>(scale, shift) : t.template to<U>(); });
+    };
+    if (dt == DataType::UINT8) {
+        return convert(uint8{});
+    } else if (dt == DataType::INT32) {
+        return convert(int32{});
+    } else if (dt == DataType::FLOAT32) {
+        return convert(float32{});
+    } else if (dt == DataType::FLOAT16) {
+        return convert(float16{});
+    } else if (dt == DataType::BFLOAT16) {
+        return convert(bfloat16{});
+    }
+
+    throw std::invalid_argument("Unsupported dtype for Tensor.to");
+}
+
+// Basic indexing like NumPy's: t[i], t[start:stop:step] and tuples of them with at most one
+// ellipsis. Every item is applied as a view (select or slice), so no data is copied.
+template<typename T>
+Tensor<T> tensor_getitem(const Tensor<T>& t, const py::object& index) {
+    py::tuple items = py::isinstance<py::tuple>(index) ? py::reinterpret_borrow<py::tuple>(index) : py::make_tuple(index);
+    int indexed = 0;
+    bool has_ellipsis = false;
+    for (py::handle item : items) {
+        if (!item.is(py::ellipsis())) {
+            indexed++;
+        } else if (has_ellipsis) {
+            throw py::index_error("An index can only have a single ellipsis");
+        } else {
+            has_ellipsis = true;
+        }
+    }
+    if (indexed > t.ndim) {
+        throw py::index_error("Too many indices for a tensor with " + std::to_string(t.ndim) + " dims");
+    }
+
+    Tensor<T> result = t;
+    int dim = 0;  // Dim of result the next item applies to
+    for (py::handle item : items) {
+        if (item.is(py::ellipsis())) {
+            dim += t.ndim - indexed;
+        } else if (py::isinstance<py::slice>(item)) {
+            py::ssize_t start, stop, step, length;
+            if (!py::reinterpret_borrow<py::slice>(item).compute(result.shape[dim], &start, &stop, &step, &length)) {
+                throw py::error_already_set();
+            }
+            if (step <= 0) throw py::index_error("Slice step must be positive");
+            result = result.slice(dim, static_cast<int>(start), static_cast<int>(stop), static_cast<int>(step));
+            dim++;
+        } else if (PyIndex_Check(item.ptr())) {
+            // Any object with __index__, like Python sequences: ints, NumPy integer scalars, ...
+            py::ssize_t i = PyNumber_AsSsize_t(item.ptr(), PyExc_IndexError);
+            if (i == -1 && PyErr_Occurred()) throw py::error_already_set();
+            if (i < std::numeric_limits<int>::min() || i > std::numeric_limits<int>::max()) {
+                throw py::index_error("Index " + std::to_string(i) + " is out of range for dim " + std::to_string(dim));
+            }
+            result = result.select(dim, static_cast<int>(i));
+        } else {
+            throw py::type_error("Tensor indices must be integers, slices or ...");
+        }
+    }
+    return result;
+}
+
+// Result of an op with an optional out= tensor. Without out the op allocates its result; with
+// it the result is written into out (a tensor of the operands' dtype) and out itself is returned.
+template<typename T, typename Allocating, typename Into>
+py::object with_out(const py::object& out, Allocating&& allocating, Into&& into) {
+    if (out.is_none()) return call_without_gil(allocating);
+    if (!py::isinstance<Tensor<T>>(out)) throw py::type_error("out must be a tensor of the same dtype as the operands");
+    const Tensor<T>& target = out.cast<const Tensor<T>&>();
+    {
+        py::gil_scoped_release release;
+        into(target);
+    }
+    return out;
+}
+
+// Bind fma(a, b, c) = a * b + c for b and c of type B and C (a tensor or a scalar). It goes
+// through the lazy expression layer: one pass and no temporaries, e.g. for scale and shift.
+template<typename T, typename B, typename C>
+void bind_fma(py::module_& m) {
+    m.def("fma", [](const Tensor<T>& a, const B& b, const C& c, const py::object& out) {
+        auto e = expr::lazy(a) * b + c;
+        return with_out<T>(out, [&] { return e.eval(); }, [&](const Tensor<T>& o) { expr::assign(o, e); });
+    }, "a * b + c with broadcasting, fused in a single pass, written into out if given",
+       py::arg("a"), py::arg("b"), py::arg("c"), py::arg("out") = py::none());
+}
+
+// Bind a reduction method taking either a list of dims (empty or omitted: all dims) or a single dim
+template<typename T, typename R>
+void bind_reduction(py::class_<Tensor<T>>& cls, const char* name, R (Tensor<T>::*method)(const Dims&, bool) const) {
+    cls.def(name, method, py::arg("dims") = Dims{}, py::arg("keepdim") = false, release_gil());
+    cls.def(name, [method](const Tensor<T>& t, int dim, bool keepdim) {
+        return (t.*method)({dim}, keepdim);
+    }, py::arg("dim"), py::arg("keepdim") = false, release_gil());
+}
+
 // Templated function to bind the Tensor class
 template<typename T>
 void bind_tensor(py::module& m, const std::string& class_name) {
-    py::class_<Tensor<T>>(m, class_name.c_str())
+    // bfloat16 has no buffer format NumPy understands, so it does not expose its buffer
+    constexpr bool has_buffer = !std::is_same_v<T, bfloat16>;
+    py::class_<Tensor<T>> cls = has_buffer ? py::class_<Tensor<T>>(m, class_name.c_str(), py::buffer_protocol())
+                                           : py::class_<Tensor<T>>(m, class_name.c_str());
+    if constexpr (has_buffer) {
+        cls.def_buffer([](Tensor<T>& t) { return tensor_buffer_info(t); });
+    }
+    cls
         .def(py::init<>())
         .def_readonly("numel", &Tensor<T>::numel)
         .def_readonly("shape", &Tensor<T>::shape)
         .def_readonly("ndim", &Tensor<T>::ndim)
         .def_readonly("dtype", &Tensor<T>::dtype)
         .def_readonly("strides", &Tensor<T>::strides)
-        .def("__repr__", &Tensor<T>::to_string)
-        .def(py::self + py::self)
-        .def(py::self += py::self)
-        .def(py::self * py::self)
-        .def(py::self *= py::self)
-        .def(py::self + double())
-        .def(py::self += double())
-        .def(py::self * double())
-        .def(py::self *= double())
-        .def("view", &Tensor<T>::view)
+        .def_readonly("is_contiguous", &Tensor<T>::is_contiguous)
+        .def_readonly("is_dense", &Tensor<T>::is_dense)
+        .def_readonly("has_broadcast", &Tensor<T>::has_broadcast)
+        .def("__repr__", &Tensor<T>::to_string, release_gil())
+        .def(py::self + py::self, release_gil())
+        .def(py::self += py::self, release_gil())
+        .def(py::self * py::self, release_gil())
+        .def(py::self *= py::self, release_gil())
+        .def(py::self + double(), release_gil())
+        .def(py::self += double(), release_gil())
+        .def(py::self * double(), release_gil())
+        .def(py::self *= double(), release_gil())
+        .def("view", &Tensor<T>::view, release_gil())
         .def("expand", &Tensor<T>::expand)
         .def("broadcast_to", &Tensor<T>::broadcast_to)
         .def("squeeze", &Tensor<T>::squeeze)
         .def("unsqueeze", &Tensor<T>::unsqueeze)
-        .def("__matmul__", static_cast<Tensor<T> (Tensor<T>::*)(const Tensor<T>&) const>(&Tensor<T>::matmul))
-        .def_static("matmul", static_cast<Tensor<T> (*)(const Tensor<T>&, const Tensor<T>&)>(&Tensor<T>::matmul))
-        .def_static("empty", [](const std::vector<int>& shape) {
+        .def("__getitem__", &tensor_getitem<T>)
+        .def("narrow", &Tensor<T>::narrow, py::arg("dim"), py::arg("start"), py::arg("length"))
+        .def("select", &Tensor<T>::select, py::arg("dim"), py::arg("index"))
+        .def("permute", &Tensor<T>::permute, py::arg("dims"))
+        .def("transpose", py::overload_cast<int, int>(&Tensor<T>::transpose, py::const_), py::arg("dim0"), py::arg("dim1"))
+        .def_property_readonly("T", py::overload_cast<>(&Tensor<T>::transpose, py::const_))
+        .def("contiguous", &Tensor<T>::contiguous, release_gil())
+        .def("to", &tensor_to_dtype<T>, "Copy of the tensor converted to dtype as dtype(x * scale + shift), "
+             "truncating floats toward zero and saturating for integer dtypes (int32 to uint8 without scale or shift wraps)",
+             py::arg("dtype"), py::arg("scale") = 1.0f, py::arg("shift") = 0.0f)
+        .def("numpy", &tensor_to_numpy<T>, "NumPy array sharing the tensor data (a float32 copy for bfloat16)")
+        .def("__array__", [](const Tensor<T>& t, py::object dtype, py::object copy) {
+            py::array array = tensor_to_numpy(t);
+            bool force_copy = !copy.is_none() && copy.cast<bool>();
+            if (dtype.is_none() && !force_copy) return array;
+            py::object target = dtype.is_none() ? py::object(array.dtype()) : dtype;
+            return py::array(array.attr("astype")(target, py::arg("copy") = force_copy));
+        }, py::arg("dtype") = py::none(), py::arg("copy") = py::none())
+        .def("__matmul__", static_cast<Tensor<T> (Tensor<T>::*)(const Tensor<T>&) const>(&Tensor<T>::matmul), release_gil())
+        .def_static("matmul", static_cast<Tensor<T> (*)(const Tensor<T>&, const Tensor<T>&)>(&Tensor<T>::matmul), release_gil())
+        .def_static("empty", [](const Dims& shape) {
             return Tensor<T>::empty(shape);
-        })
-        .def_static("full", [](const std::vector<int>& shape, double value) {
+        }, release_gil())
+        .def_static("full", [](const Dims& shape, double value) {
             return Tensor<T>::full(shape, value);
-        })
-        .def_static("ones", &Tensor<T>::ones)
-        .def_static("zeros", &Tensor<T>::zeros);
+        }, release_gil())
+        .def_static("from_numpy", &tensor_from_numpy<T>, "Tensor sharing the memory of a NumPy array", py::arg("array"))
+        .def_static("ones", &Tensor<T>::ones, release_gil())
+        .def_static("zeros", &Tensor<T>::zeros, release_gil());
+
+    bind_reduction(cls, "sum", &Tensor<T>::sum);
+    bind_reduction(cls, "mean", &Tensor<T>::mean);
+    bind_reduction(cls, "prod", &Tensor<T>::prod);
+    bind_reduction(cls, "max", &Tensor<T>::max);
+    bind_reduction(cls, "min", &Tensor<T>::min);
+    bind_reduction(cls, "argmax", &Tensor<T>::argmax);
+
+    // Module-level ops with out=, e.g. to reuse preallocated buffers in a loop
+    m.def("add", [](const Tensor<T>& a, const Tensor<T>& b, const py::object& out) {
+        return with_out<T>(out, [&] { return F::add(a, b); }, [&](const Tensor<T>& o) { F::add(a, b, o); });
+    }, "a + b with broadcasting, written into out if given", py::arg("a"), py::arg("b"), py::arg("out") = py::none());
+    m.def("add", [](const Tensor<T>& a, double b, const py::object& out) {
+        return with_out<T>(out, [&] { return F::add(a, b); }, [&](const Tensor<T>& o) { F::add(a, b, o); });
+    }, "a + b for a scalar b, written into out if given", py::arg("a"), py::arg("b"), py::arg("out") = py::none());
+    m.def("mul", [](const Tensor<T>& a, const Tensor<T>& b, const py::object& out) {
+        return with_out<T>(out, [&] { return F::mul(a, b); }, [&](const Tensor<T>& o) { F::mul(a, b, o); });
+    }, "a * b with broadcasting, written into out if given", py::arg("a"), py::arg("b"), py::arg("out") = py::none());
+    m.def("mul", [](const Tensor<T>& a, double b, const py::object& out) {
+        return with_out<T>(out, [&] { return F::mul(a, b); }, [&](const Tensor<T>& o) { F::mul(a, b, o); });
+    }, "a * b for a scalar b, written into out if given", py::arg("a"), py::arg("b"), py::arg("out") = py::none());
+    bind_fma<T, Tensor<T>, Tensor<T>>(m);
+    bind_fma<T, Tensor<T>, double>(m);
+    bind_fma<T, double, Tensor<T>>(m);
+    bind_fma<T, double, double>(m);
+    m.def("matmul", [](const Tensor<T>& a, const Tensor<T>& b, const py::object& out) {
+        return with_out<T>(out, [&] { return F::matmul(a, b); }, [&](const Tensor<T>& o) { F::matmul(a, b, o); });
+    }, "a @ b, written into out (not overlapping a or b) if given", py::arg("a"), py::arg("b"), py::arg("out") = py::none());
+}
+
+// Writes a dict of named tensors of any dtype to a tensor file
+void save_tensors(const std::string& path, const py::dict& tensors) {
+    std::map<std::string, io::AnyTensor> entries;
+    for (auto item : tensors) {
+        std::string name = item.first.cast<std::string>();
+        py::handle value = item.second;
+        if (py::isinstance<Tensor<uint8>>(value)) {
+            entries[name] = value.cast<const Tensor<uint8>&>();
+        } else if (py::isinstance<Tensor<int32>>(value)) {
+            entries[name] = value.cast<const Tensor<int32>&>();
+        } else if (py::isinstance<Tensor<float32>>(value)) {
+            entries[name] = value.cast<const Tensor<float32>&>();
+        } else if (py::isinstance<Tensor<float16>>(value)) {
+            entries[name] = value.cast<const Tensor<float16>&>();
+        } else if (py::isinstance<Tensor<bfloat16>>(value)) {
+            entries[name] = value.cast<const Tensor<bfloat16>&>();
+        } else {
+            throw std::invalid_argument("save expects tensors, got " + py::str(value.get_type()).cast<std::string>() + " for '" + name + "'");
+        }
+    }
+    py::gil_scoped_release release;
+    io::save(path, entries);
+}
+
+// Maps a tensor file and returns its tensors by name, without copying them
+py::dict load_tensors(const std::string& path) {
+    std::map<std::string, io::AnyTensor> entries = [&] {
+        py::gil_scoped_release release;
+        return io::load(path);
+    }();
+    py::dict result;
+    for (const auto& [name, t] : entries) {
+        if (t.dtype == DataType::UINT8) {
+            result[name.c_str()] = t.as<uint8>();
+        } else if (t.dtype == DataType::INT32) {
+            result[name.c_str()] = t.as<int32>();
+        } else if (t.dtype == DataType::FLOAT32) {
+            result[name.c_str()] = t.as<float32>();
+        } else if (t.dtype == DataType::FLOAT16) {
+            result[name.c_str()] = t.as<float16>();
+        } else if (t.dtype == DataType::BFLOAT16) {
+            result[name.c_str()] = t.as<bfloat16>();
+        }
+    }
+    return result;
 }
 
+// Calls fn with a value of the element type of dt, e.g. to pick the instantiation of a streamed op
+template<typename Fn>
+auto visit_dtype(const DataType dt, Fn&& fn) {
+    if (dt == DataType::UINT8) {
+        return fn(uint8{});
+    } else if (dt == DataType::INT32) {
+        return fn(int32{});
+    } else if (dt == DataType::FLOAT32) {
+        return fn(float32{});
+    } else if (dt == DataType::FLOAT16) {
+        return fn(float16{});
+    } else if (dt == DataType::BFLOAT16) {
+        return fn(bfloat16{});
+    }
+    throw std::invalid_argument("Unsupported dtype " + dtype_to_str(dt));
+}
+
+// fn runs with the GIL held and returns a tensor or a sequence of tensors
+template<typename T>
+void bind_graph(py::module_& m, const char* class_name) {
+    using Graph = graph::Graph<T>;
+    py::class_<Graph>(m, class_name)
+        .def_static("capture", [](const py::function& fn, const std::vector<Tensor<T>>& inputs) {
+            return Graph::capture([&](const std::vector<Tensor<T>>& args) {
+                py::object result = fn(*py::cast(args));
+                if (py::isinstance<Tensor<T>>(result)) return std::vector<Tensor<T>>{result.cast<Tensor<T>>()};
+                return result.cast<std::vector<Tensor<T>>>();
+            }, inputs);
+        }, "Call fn(*inputs) once, recording its add, mul and matmul ops into a graph", py::arg("fn"), py::arg("inputs"))
+        .def("run", &Graph::run, "Replay the graph on new inputs of the captured shapes, returning its outputs. Outputs "
+             "held in the graph's arena are overwritten by the next run: copy them, e.g. with numpy.array(), to keep them. "
+             "Concurrent runs of one graph wait for each other",
+             py::arg("inputs"), release_gil())
+        .def_property_readonly("num_ops", &Graph::num_ops)
+        .def_property_readonly("arena_bytes", &Graph::arena_bytes);
+}
+
+void bind_file_tensor(py::module_& m) {
+    using streaming::FileTensor;
+    const size_t chunk_bytes = streaming::DEFAULT_CHUNK_BYTES;
+
+    py::class_<FileTensor>(m, "FileTensor")
+        .def_static("open", &FileTensor::open, "Open a tensor of a tensor file for streamed ops", py::arg("path"), py::arg("name"))
+        .def_static("create", [](const std::string& path, const std::string& name, const Dims& shape, DataType dt) {
+            return FileTensor::create(path, name, dt, shape);
+        }, "Create a file holding one zero-filled tensor, e.g. the output of a streamed op",
+           py::arg("path"), py::arg("name"), py::arg("shape"), py::arg("dtype"))
+        .def_readonly("dtype", &FileTensor::dtype)
+        .def_readonly("shape", &FileTensor::shape)
+        .def("add", [](const FileTensor& a, const FileTensor& b, const FileTensor& out, size_t chunk_bytes) {
+            visit_dtype(a.dtype, [&](auto tag) { streaming::add<decltype(tag)>(a, b, out, chunk_bytes); });
+        }, "Write self + other to out, streaming blocks of rows", release_gil(),
+           py::arg("other"), py::arg("out"), py::arg("chunk_bytes") = chunk_bytes)
+        .def("mul", [](const FileTensor& a, const FileTensor& b, const FileTensor& out, size_t chunk_bytes) {
+            visit_dtype(a.dtype, [&](auto tag) { streaming::mul<decltype(tag)>(a, b, out, chunk_bytes); });
+        }, "Write self * other to out, streaming blocks of rows", release_gil(),
+           py::arg("other"), py::arg("out"), py::arg("chunk_bytes") = chunk_bytes)
+        .def("matmul", [](const FileTensor& a, const py::object& b, const FileTensor& out, size_t chunk_bytes) {
+            visit_dtype(a.dtype, [&](auto tag) {
+                using T = decltype(tag);
+                const Tensor<T>& rhs = b.cast<const Tensor<T>&>();
+                py::gil_scoped_release release;
+                streaming::matmul<T>(a, rhs, out, chunk_bytes);
+            });
+        }, "Write self @ other to out for an in-memory other, streaming blocks of rows",
+           py::arg("other"), py::arg("out"), py::arg("chunk_bytes") = chunk_bytes)
+        .def("sum", [](const FileTensor& t, size_t chunk_bytes) {
+            return visit_dtype(t.dtype, [&](auto tag) {
+                return call_without_gil([&] { return streaming::sum<decltype(tag)>(t, chunk_bytes); });
+            });
+        }, "Sum of all the elements, streaming blocks of rows", py::arg("chunk_bytes") = chunk_bytes)
+        .def("mean", [](const FileTensor& t, size_t chunk_bytes) {
+            return visit_dtype(t.dtype, [&](auto tag) {
+                return call_without_gil([&] { return streaming::mean<decltype(tag)>(t, chunk_bytes); });
+            });
+        }, "Mean of all the elements, streaming blocks of rows", py::arg("chunk_bytes") = chunk_bytes)
+        .def("max", [](const FileTensor& t, size_t chunk_bytes) {
+            return visit_dtype(t.dtype, [&](auto tag) {
+                return call_without_gil([&] { return streaming::max<decltype(tag)>(t, chunk_bytes); });
+            });
+        }, "Largest element, streaming blocks of rows", py::arg("chunk_bytes") = chunk_bytes)
+        .def("min", [](const FileTensor& t, size_t chunk_bytes) {
+            return visit_dtype(t.dtype, [&](auto tag) {
+                return call_without_gil([&] { return streaming::min<decltype(tag)>(t, chunk_bytes); });
+            });
+        }, "Smallest element, streaming blocks of rows", py::arg("chunk_bytes") = chunk_bytes);
+}
+
+// The compute-heavy bindings (arithmetic, matmul, copies, factories) release the GIL, so
+// several Python threads can run them at the same time. See the thread-safety notes in tensor.hpp.
 PYBIND11_MODULE(cpptensor, m) {
     m.doc() = "pybind11 plugin for Tensor class";
 
@@ -85,15 +546,95 @@ PYBIND11_MODULE(cpptensor, m) {
     bind_tensor<uint8>(m, "TensorUInt8");
     bind_tensor<int32>(m, "TensorInt32");
     bind_tensor<float32>(m, "TensorFloat32");
+    bind_tensor<float16>(m, "TensorFloat16");
+    bind_tensor<bfloat16>(m, "TensorBFloat16");
 
     // Also bind the DataType enum
     py::enum_<DataType>(m, "DataType")
         .value("UINT8", DataType::UINT8)
         .value("INT32", DataType::INT32)
-        .value("FLOAT32", DataType::FLOAT32);
+        .value("FLOAT32", DataType::FLOAT32)
+        .value("FLOAT16", DataType::FLOAT16)
+        .value("BFLOAT16", DataType::BFLOAT16);
+
+    // Quantized uint8 matmul: real values are (q - zero_point) * scale
+    py::class_<QuantParams>(m, "QuantParams")
+        .def(py::init([](float scale, int32 zero_point) { return QuantParams{scale, zero_point}; }),
+             py::arg("scale") = 1.0f, py::arg("zero_point") = 0)
+        .def_readwrite("scale", &QuantParams::scale)
+        .def_readwrite("zero_point", &QuantParams::zero_point)
+        .def("__repr__", [](const QuantParams& q) {
+            return "QuantParams(scale=" + std::to_string(q.scale) + ", zero_point=" + std::to_string(q.zero_point) + ")";
+        });
+    m.def("quantized_matmul",
+          static_cast<Tensor<int32> (*)(const Tensor<uint8>&, const QuantParams&, const Tensor<uint8>&, const QuantParams&)>(&F::quantized_matmul),
+          "Matmul of quantized uint8 tensors with exact int32 accumulation",
+          py::arg("a"), py::arg("a_params"), py::arg("b"), py::arg("b_params"), release_gil());
+    m.def("quantized_matmul",
+          static_cast<Tensor<uint8> (*)(const Tensor<uint8>&, const QuantParams&, const Tensor<uint8>&, const QuantParams&, const QuantParams&)>(&F::quantized_matmul),
+          "Matmul of quantized uint8 tensors requantized to out_params",
+          py::arg("a"), py::arg("a_params"), py::arg("b"), py::arg("b_params"), py::arg("out_params"), release_gil());
 
     // Expose factory functions for Python
     m.def("ones", &create_tensor_ones, "Create a Tensor of ones", py::arg("shape"), py::arg("dtype"));
     m.def("zeros", &create_tensor_zeros, "Create a Tensor of zeros", py::arg("shape"), py::arg("dtype"));
     m.def("full", &create_tensor_full, "Create a Tensor filled with a value", py::arg("shape"), py::arg("value"), py::arg("dtype"));
+    m.def("from_numpy", &create_tensor_from_numpy, "Create a Tensor sharing the memory of a NumPy array", py::arg("array"));
+
+    // Serialization
+    m.def("save", &save_tensors, "Save a dict of named tensors to a file", py::arg("path"), py::arg("tensors"));
+    m.def("load", &load_tensors, "Load the tensors of a file by name, memory-mapped without copying", py::arg("path"));
+
+    // Out-of-core ops over tensors in files
+    bind_file_tensor(m);
+
+    // Captured op sequences replayed with planned buffers
+    bind_graph<uint8>(m, "GraphUInt8");
+    bind_graph<int32>(m, "GraphInt32");
+    bind_graph<float32>(m, "GraphFloat32");
+    bind_graph<float16>(m, "GraphFloat16");
+    bind_graph<bfloat16>(m, "GraphBFloat16");
+
+    // Thread pool used by the parallel kernels
+    m.def("set_num_threads", &parallel::set_num_threads, "Set the number of threads used by parallel ops", py::arg("num_threads"), release_gil());
+    m.def("get_num_threads", &parallel::get_num_threads, "Get the number of threads used by parallel ops");
+
+    // Instruction set selected at runtime for the vectorized kernels
+    m.def("simd_level", []() { return cpu::simd_level_to_str(cpu::simd_level()); }, "Get the SIMD instruction set used by the kernels");
+
+    // Caching allocator behind every tensor buffer
+    m.def("memory_stats", []() {
+        memory::AllocatorStats stats = memory::stats();
+        py::dict result;
+        result["hits"] = stats.hits;
+        result["misses"] = stats.misses;
+        result["bytes_in_use"] = stats.bytes_in_use;
+        result["bytes_cached"] = stats.bytes_cached;
+        return result;
+    }, "Get the allocator counters: cache hits/misses, bytes in use and bytes cached");
+    m.def("empty_cache", &memory::empty_cache, "Release the memory cached by the allocator", release_gil());
+
+    // Per-op profiler: add/mul/matmul/to and allocations, near zero cost while disabled
+    m.def("set_profiler_enabled", &profiler::set_enabled, "Start or stop recording op events", py::arg("enabled"));
+    m.def("is_profiler_enabled", &profiler::is_enabled, "Whether op events are being recorded");
+    m.def("clear_profiler", &profiler::clear, "Discard the recorded op events");
+    m.def("profiler_events", []() {
+        py::list result;
+        for (const profiler::Event& e : profiler::events()) {
+            py::dict event;
+            event["name"] = e.name;
+            event["shapes"] = e.shapes;
+            event["dtype"] = e.dtype;
+            event["start_ns"] = e.start_ns;
+            event["duration_ns"] = e.duration_ns;
+            event["thread_id"] = e.thread_id;
+            event["bytes"] = e.bytes;
+            event["flops"] = e.flops;
+            result.append(event);
+        }
+        return result;
+    }, "Get the recorded op events: name, shapes, dtype, start/duration, thread, bytes and FLOPs");
+    m.def("profiler_summary", &profiler::summary, "Table of the recorded events aggregated by op and dtype");
+    m.def("export_chrome_trace", &profiler::export_chrome_trace, "Write the recorded events as a Chrome trace JSON file",
+          py::arg("path"));
 }
@@ -1,4 +1,5 @@
 
+import gc
 import time
 import numpy as np
 import cpptensor as Tensor
@@ -84,6 +85,97 @@ def compare_large_matrices(num_runs=10):
     print(f"CppTensor is {'faster' if cpp_time < numpy_time else 'slower'} than NumPy by a factor of {numpy_time / cpp_time:.2f}")
 
 
+# Checks that from_numpy and numpy()/__array__ share memory where they can, and copy otherwise
+def check_numpy_interop():
+    # Zero-copy in both directions: writes on either side are seen by the other
+    a = np.arange(12, dtype=np.float32).reshape(3, 4)
+    t = Tensor.from_numpy(a)
+    assert t.dtype == DataType.FLOAT32 and t.shape == [3, 4] and t.strides == [4, 1]
+    a[0, 0] = 100
+    assert t.numpy()[0, 0] == 100
+    exported = t.numpy()
+    exported[1, 2] = -1
+    assert a[1, 2] == -1
+    assert np.shares_memory(exported, a) and np.shares_memory(np.asarray(t), a)
+    u = Tensor.ones([2, 3], DataType.INT32)
+    np.asarray(u)[1, 1] = 7
+    assert u.numpy()[1, 1] == 7
+
+    # Byte strides become element strides, for transposed and stepped arrays alike
+    transposed = Tensor.from_numpy(a.T)
+    assert transposed.shape == [4, 3] and transposed.strides == [1, 4]
+    assert np.array_equal(transposed.numpy(), a.T) and np.shares_memory(transposed.numpy(), a)
+    stepped = Tensor.from_numpy(a[::2, 1::2])
+    assert stepped.shape == [2, 2] and stepped.strides == [8, 2]
+    assert np.array_equal(stepped.numpy(), a[::2, 1::2]) and np.shares_memory(stepped.numpy(), a)
+    assert np.array_equal(t.T.numpy(), a.T) and t.T.numpy().strides == a.T.strides
+
+    # Read-only, negative-stride and other-dtype arrays are copied
+    read_only = np.arange(6, dtype=np.int32)
+    read_only.setflags(write=False)
+    copied = Tensor.from_numpy(read_only)
+    assert np.array_equal(copied.numpy(), read_only) and not np.shares_memory(copied.numpy(), read_only)
+    reversed_columns = a[:, ::-1]
+    copied = Tensor.from_numpy(reversed_columns)
+    assert np.array_equal(copied.numpy(), reversed_columns) and not np.shares_memory(copied.numpy(), a)
+    doubles = np.linspace(-1, 1, 5)
+    copied = Tensor.TensorFloat32.from_numpy(doubles)
+    assert np.allclose(copied.numpy(), doubles) and not np.shares_memory(copied.numpy(), doubles)
+
+    # Each side keeps the other's memory alive
+    owner = np.arange(1000, dtype=np.int32)
+    shared = Tensor.from_numpy(owner)
+    del owner
+    gc.collect()
+    assert shared.numpy()[999] == 999 and int(shared.sum().numpy()) == 499500
+    orphan = Tensor.full([4], DataType.INT32, 3.0).numpy()
+    gc.collect()
+    assert orphan.sum() == 12
+
+    # Broadcast dims are exported read-only, as np.broadcast_to does
+    broadcast = Tensor.ones([1, 3], DataType.FLOAT32).expand([4, 3])
+    assert not broadcast.numpy().flags.writeable and not np.asarray(broadcast).flags.writeable
+    assert Tensor.ones([4, 3], DataType.FLOAT32).numpy().flags.writeable
+
+    # Sizes and strides past INT_MAX are rejected instead of wrapping around
+    for shape, strides in [((2 ** 31,), (0,)), ((2,), (2 ** 33,))]:
+        huge = np.lib.stride_tricks.as_strided(np.zeros(1, dtype=np.float32), shape=shape, strides=strides)
+        try:
+            Tensor.from_numpy(huge)
+        except ValueError:
+            pass
+        else:
+            raise AssertionError(f"from_numpy accepted shape {shape} with strides {strides}")
+
+    print("NumPy interop checks passed")
+
+
+# Checks that tensors are indexed by any integer-like object, as Python sequences are
+def check_integer_indices():
+    a = np.arange(24, dtype=np.int32).reshape(2, 3, 4)
+    t = Tensor.from_numpy(a)
+    assert np.array_equal(t[np.int64(1)].numpy(), a[1])
+    assert np.array_equal(t[np.int32(0), np.uint8(2)].numpy(), a[0, 2])
+    assert np.array_equal(t[..., np.int16(-1)].numpy(), a[..., -1])
+    assert np.array_equal(t[np.intp(1), np.int64(0):np.int64(3):np.int64(2)].numpy(), a[1, 0:3:2])
+    for bad in [np.float32(1.0), 1.5, "1"]:
+        try:
+            t[bad]
+        except TypeError:
+            pass
+        else:
+            raise AssertionError(f"indexing with {bad!r} did not raise TypeError")
+    for out_of_range in [np.int64(2), 2 ** 40]:
+        try:
+            t[out_of_range]
+        except IndexError:
+            pass
+        else:
+            raise AssertionError(f"index {out_of_range} did not raise IndexError")
+
+    print("Integer index checks passed")
+
+
 # Helper function to map CppTensor data types to NumPy data types
 def _get_numpy_dtype(dtype):
     if dtype == DataType.UINT8:
@@ -96,6 +188,8 @@ def _get_numpy_dtype(dtype):
         raise ValueError("Unsupported data type")
 
 
+check_numpy_interop()
+check_integer_indices()
 basic_example()
 compare_small_matrices(num_runs=10000)
 compare_large_matrices(num_runs=10)
@@ -0,0 +1,1874 @@
+#include "cpptensor/tensor.hpp"
+#include "cpptensor/utils.hpp"
+#include "cpptensor/functional.hpp"
+#include "cpptensor/expression.hpp"
+#include "cpptensor/serialization.hpp"
+#include "cpptensor/streaming.hpp"
+#include "cpptensor/graph.hpp"
+#include "cpptensor/parallel.hpp"
+#include "cpptensor/cpu_features.hpp"
+#include "cpptensor/small_matmul.hpp"
+#include "cpptensor/allocator.hpp"
+#include "cpptensor/profiler.hpp"
+
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Behavior tests of the native library, one section per feature. Each test checks results against
+// values computed element by element; the exit status is nonzero when any check failed.
+//
+//   cpptensor_tests [--filter TEXT]
+//
+// The kernels run at the host's best SIMD level; set CPPTENSOR_SIMD to test a lower one (ctest
+// runs every level).
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                                      \
+    do {                                                                                      \
+        if (!(condition)) {                                                                   \
+            std::cerr << "  " << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            failures++;                                                                       \
+        }                                                                                     \
+    } while (0)
+
+#define CHECK_THROWS(statement, exception)                                                   \
+    do {                                                                                      \
+        bool thrown = false;                                                                  \
+        try { statement; } catch (const exception&) { thrown = true; }                        \
+        if (!thrown) {                                                                        \
+            std::cerr << "  " << __FILE__ << ":" << __LINE__ << ": " #statement " did not throw " #exception "\n"; \
+            failures++;                                                                       \
+        }                                                                                     \
+    } while (0)
+
+// Tensor of shape with element i (in row-major order) set to start + i * step
+template<typename T>
+Tensor<T> arange(const Dims& shape, double start = 0.0, double step = 1.0) {
+    Tensor<T> t = Tensor<T>::empty(shape);
+    for (size_t i = 0; i < t.numel; i++) t.data[i] = static_cast<T>(start + static_cast<double>(i) * step);
+    return t;
+}
+
+// Tensor of shape with the given values in row-major order
+template<typename T>
+Tensor<T> values(const Dims& shape, const std::vector<double>& values) {
+    Tensor<T> t = Tensor<T>::empty(shape);
+    for (size_t i = 0; i < t.numel; i++) t.data[i] = static_cast<T>(values[i]);
+    return t;
+}
+
+// Same shape and same values in row-major order, whatever the layouts
+template<typename T>
+bool equal(const Tensor<T>& a, const Tensor<T>& b) {
+    if (!utils::shapes_equal(a.shape, b.shape)) return false;
+    Tensor<T> x = a.contiguous();
+    Tensor<T> y = b.contiguous();
+    for (size_t i = 0; i < x.numel; i++) {
+        if (x.data[i] != y.data[i]) return false;
+    }
+    return true;
+}
+
+// Tensor of shape with small integer values (0 to 6 for uint8, -3 to 3 otherwise), so that
+// products and sums are exact in every dtype's accumulator
+template<typename T>
+Tensor<T> pattern(const Dims& shape, int seed = 0) {
+    Tensor<T> t = Tensor<T>::empty(shape);
+    const int offset = std::is_same_v<T, uint8> ? 0 : 3;
+    for (size_t i = 0; i < t.numel; i++) t.data[i] = static_cast<T>(static_cast<int>((i * 5 + seed) % 7) - offset);
+    return t;
+}
+
+// Runs fn(T()) for every tensor dtype
+template<typename Fn>
+void for_each_dtype(Fn fn) {
+    fn(uint8());
+    fn(int32());
+    fn(float32());
+    fn(float16());
+    fn(bfloat16());
+}
+
+// Runs fn with the kernel thread pool at one thread and at several, then restores it
+template<typename Fn>
+void with_thread_counts(Fn fn) {
+    int saved = parallel::get_num_threads();
+    for (int threads : {1, 4}) {
+        parallel::set_num_threads(threads);
+        fn();
+    }
+    parallel::set_num_threads(saved);
+}
+
+// Element i (in row-major order) of t, read through its strides one index at a time
+template<typename T>
+T element(const Tensor<T>& t, size_t i) {
+    std::ptrdiff_t offset = 0;
+    for (int d = t.ndim - 1; d >= 0; d--) {
+        offset += static_cast<std::ptrdiff_t>(i % t.shape[d]) * t.strides[d];
+        i /= t.shape[d];
+    }
+    return t.data[offset];
+}
+
+// op applied element by element to the operands broadcast to their common shape
+template<typename T, typename Op>
+Tensor<T> naive_binary(const Tensor<T>& a_, const Tensor<T>& b_, Op op) {
+    Dims shape = utils::broadcast_shapes(a_.shape, b_.shape);
+    Tensor<T> a = a_.expand(shape).contiguous(), b = b_.expand(shape).contiguous();
+    Tensor<T> out = Tensor<T>::empty(shape);
+    for (size_t i = 0; i < out.numel; i++) out.data[i] = static_cast<T>(op(a.data[i], b.data[i]));
+    return out;
+}
+
+// Values of t folded over the dims of mask, in row-major order of the kept dims
+template<typename T, typename Fold>
+std::vector<double> naive_reduce(const Tensor<T>& t_, const DimMask& mask, double init, Fold fold) {
+    Tensor<T> t = t_.contiguous();
+    size_t outputs = 1;
+    for (int d = 0; d < t.ndim; d++) {
+        if (!mask[d]) outputs *= t.shape[d];
+    }
+    std::vector<double> acc(outputs, init);
+    for (size_t i = 0; i < t.numel; i++) {
+        size_t rest = i, o = 0, scale = 1;
+        for (int d = t.ndim - 1; d >= 0; d--) {
+            size_t coord = rest % t.shape[d];
+            rest /= t.shape[d];
+            if (!mask[d]) {
+                o += coord * scale;
+                scale *= t.shape[d];
+            }
+        }
+        acc[o] = fold(acc[o], static_cast<double>(static_cast<float>(t.data[i])));
+    }
+    return acc;
+}
+
+// Same values as expected, in row-major order
+template<typename T>
+bool equal_values(const Tensor<T>& t_, const std::vector<double>& expected) {
+    Tensor<T> t = t_.contiguous();
+    if (t.numel != expected.size()) return false;
+    for (size_t i = 0; i < t.numel; i++) {
+        if (static_cast<double>(static_cast<float>(t.data[i])) != expected[i]) return false;
+    }
+    return true;
+}
+
+// Reference matmul of operands in matmul form (same batch dims, (..., M, K) and (..., K, N)) by
+// a triple loop. Sums are exact (int64 or double) and rounded to T once; uint8 wraps.
+template<typename T>
+Tensor<T> naive_matmul(const Tensor<T>& a_, const Tensor<T>& b_) {
+    Tensor<T> a = a_.contiguous(), b = b_.contiguous();
+    int M = a.shape[a.ndim - 2], K = a.shape[a.ndim - 1], N = b.shape[b.ndim - 1];
+    Dims shape(a.shape.begin(), a.shape.end() - 1);
+    shape.push_back(N);
+    Tensor<T> out = Tensor<T>::empty(shape);
+    size_t batch = out.numel == 0 ? 0 : out.numel / (static_cast<size_t>(M) * N);
+    for (size_t n = 0; n < batch; n++) {
+        const T* x = a.data.get() + n * M * K;
+        const T* y = b.data.get() + n * K * N;
+        T* z = out.data.get() + n * M * N;
+        for (int i = 0; i < M; i++) {
+            for (int j = 0; j < N; j++) {
+                if constexpr (std::is_integral_v<T>) {
+                    int64_t acc = 0;
+                    for (int p = 0; p < K; p++) acc += static_cast<int64_t>(x[i * K + p]) * y[p * N + j];
+                    z[i * N + j] = static_cast<T>(acc);
+                } else {
+                    double acc = 0.0;
+                    for (int p = 0; p < K; p++) acc += static_cast<double>(static_cast<float>(x[i * K + p])) * static_cast<float>(y[p * N + j]);
+                    z[i * N + j] = static_cast<T>(static_cast<float>(acc));
+                }
+            }
+        }
+    }
+    return out;
+}
+
+// Path in the temporary directory, removed (with its .tmp) when the test ends
+struct TempFile {
+    std::string path;
+
+    explicit TempFile(const std::string& name)
+        : path((std::filesystem::temp_directory_path() / ("cpptensor_tests_" + name)).string()) {}
+    ~TempFile() {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        std::filesystem::remove(path + ".tmp", error);
+    }
+};
+
+// ---------------------------------------------------------------- Elementwise ops
+
+void test_elementwise_kernels() {
+    auto add = [](auto x, auto y) { return x + y; };
+    auto mul = [](auto x, auto y) { return x * y; };
+    with_thread_counts([&] {
+        for_each_dtype([&](auto tag) {
+            using T = decltype(tag);
+            // Lengths around the vector widths, and past the parallel grain
+            for (int n : {1, 7, 16, 33, 100003}) {
+                Tensor<T> a = pattern<T>({n}, 1), b = pattern<T>({n}, 2);
+                CHECK(equal(a + b, naive_binary(a, b, add)));
+                CHECK(equal(a * b, naive_binary(a, b, mul)));
+            }
+
+            // A broadcast operand goes to the scalar kernel, a transposed one to the strided loop
+            Tensor<T> m = pattern<T>({67, 45}, 3);
+            Tensor<T> row = pattern<T>({45}, 4), col = pattern<T>({67, 1}, 5);
+            Tensor<T> mt = pattern<T>({45, 67}, 6).transpose();
+            CHECK(equal(m + row, naive_binary(m, row, add)));
+            CHECK(equal(col * m, naive_binary(col, m, mul)));
+            CHECK(equal(m + mt, naive_binary(m, mt, add)));
+            CHECK(equal(mt * col, naive_binary(mt, col, mul)));
+        });
+    });
+
+    // Fractional float32 values: the vector and scalar paths round the same way
+    Tensor<float32> x = arange<float32>({1001}, -50.3, 0.1), y = arange<float32>({1001}, 3.7, -0.013);
+    CHECK(equal(x + y, naive_binary(x, y, add)));
+    CHECK(equal(x * y, naive_binary(x, y, mul)));
+
+    // uint8 arithmetic wraps around
+    Tensor<uint8> u = values<uint8>({3}, {250, 128, 7}), v = values<uint8>({3}, {10, 2, 3});
+    CHECK(equal(u + v, values<uint8>({3}, {4, 130, 10})));
+    CHECK(equal(u * v, values<uint8>({3}, {196, 0, 21})));
+}
+
+void test_scalar_ops() {
+    with_thread_counts([] {
+        for_each_dtype([](auto tag) {
+            using T = decltype(tag);
+            for (double value : {2.0, -1.5, -3.0, 0.0}) {
+                // The scalar is cast to T once, then applied like a broadcast tensor
+                Tensor<T> scalar = Tensor<T>::full({1}, value);
+                for (int n : {1, 7, 33, 100003}) {
+                    Tensor<T> a = pattern<T>({n}, 1);
+                    CHECK(equal(a + value, a + scalar));
+                    CHECK(equal(a * value, a * scalar));
+                }
+                Tensor<T> mt = pattern<T>({45, 67}, 2).transpose();
+                CHECK(equal(mt + value, mt + scalar));
+                CHECK(equal(mt * value, mt * scalar));
+
+                // In place, also through a strided view
+                Tensor<T> b = pattern<T>({30, 40}, 3);
+                Tensor<T> expected = (b * value + value).transpose();
+                Tensor<T> bt = b.transpose();
+                bt *= value;
+                bt += value;
+                CHECK(equal(bt, expected));
+            }
+        });
+    });
+
+    // Negative float scalars keep their sign, in the vector and scalar paths alike
+    Tensor<float32> x = values<float32>({9}, {1, 2, 3, 4, 5, 6, 7, 8, 9});
+    CHECK(equal(x + -2.5, values<float32>({9}, {-1.5, -0.5, 0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5})));
+    CHECK(equal(x * -0.5, values<float32>({9}, {-0.5, -1, -1.5, -2, -2.5, -3, -3.5, -4, -4.5})));
+    CHECK(equal(Tensor<float16>::ones({5}) * -4.0, Tensor<float16>::full({5}, -4.0)));
+    CHECK(equal(Tensor<int32>::ones({5}) + -7.0, Tensor<int32>::full({5}, -6.0)));
+    // Out-of-range scalars saturate to the dtype's range
+    CHECK(equal(values<uint8>({2}, {5, 200}) + -3.0, values<uint8>({2}, {5, 200})));
+    CHECK(equal(values<uint8>({2}, {0, 1}) + 300.0, values<uint8>({2}, {255, 0})));
+}
+
+// ---------------------------------------------------------------- Allocator
+
+// Installs allocator as the one behind Tensor::empty until the end of the scope
+struct ScopedAllocator {
+    std::shared_ptr<memory::Allocator> saved = memory::get_allocator();
+
+    explicit ScopedAllocator(const std::shared_ptr<memory::Allocator>& allocator) { memory::set_allocator(allocator); }
+    ~ScopedAllocator() { memory::set_allocator(saved); }
+};
+
+bool aligned(const void* ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) % memory::ALIGNMENT == 0;
+}
+
+void test_allocator_alignment() {
+    std::shared_ptr<memory::Allocator> allocators[] = {
+        std::make_shared<memory::CachingAllocator>(), std::make_shared<memory::SystemAllocator>()};
+    for (const std::shared_ptr<memory::Allocator>& allocator : allocators) {
+        ScopedAllocator scope(allocator);
+        for (size_t nbytes : {size_t(0), size_t(1), size_t(63), size_t(65), size_t(4097), size_t(3) << 20}) {
+            void* ptr = allocator->allocate(nbytes);
+            CHECK(ptr != nullptr && aligned(ptr));
+            allocator->deallocate(ptr, nbytes);
+        }
+        // Tensor buffers, including empty ones
+        CHECK(aligned(Tensor<uint8>::empty({0}).data.get()));
+        CHECK(aligned(Tensor<uint8>::empty({3}).data.get()));
+        CHECK(aligned(Tensor<float32>::empty({7, 9}).data.get()));
+        CHECK(aligned(Tensor<bfloat16>::empty({1000}).data.get()));
+    }
+}
+
+void test_allocator_reuse_and_stats() {
+    auto allocator = std::make_shared<memory::CachingAllocator>();
+    ScopedAllocator scope(allocator);
+    memory::AllocatorStats stats = memory::stats();
+    CHECK(stats.hits == 0 && stats.misses == 0 && stats.bytes_in_use == 0 && stats.bytes_cached == 0);
+
+    // 400 and 440 bytes share the 448-byte size class; the thread cache serves the second request
+    const float32* first;
+    {
+        Tensor<float32> a = Tensor<float32>::empty({100});
+        first = a.data.get();
+        stats = memory::stats();
+        CHECK(stats.misses == 1 && stats.hits == 0 && stats.bytes_in_use == 448 && stats.bytes_cached == 0);
+    }
+    stats = memory::stats();
+    CHECK(stats.bytes_in_use == 0 && stats.bytes_cached == 448);
+    {
+        Tensor<float32> b = Tensor<float32>::empty({110});
+        CHECK(b.data.get() == first);
+        stats = memory::stats();
+        CHECK(stats.misses == 1 && stats.hits == 1 && stats.bytes_in_use == 448 && stats.bytes_cached == 0);
+
+        // A block of another class is a miss, and the cached one is not handed out twice
+        Tensor<float32> c = Tensor<float32>::empty({1000});
+        Tensor<float32> d = Tensor<float32>::empty({110});
+        CHECK(d.data.get() != first);
+        stats = memory::stats();
+        CHECK(stats.misses == 3 && stats.hits == 1 && stats.bytes_in_use == 448 + 4032 + 448);
+    }
+
+    // Blocks past the thread cache size go through the shared free lists
+    const uint8* large;
+    {
+        Tensor<uint8> a = Tensor<uint8>::empty({3 << 20});
+        large = a.data.get();
+    }
+    CHECK(Tensor<uint8>::empty({3 << 20}).data.get() == large);
+    stats = memory::stats();
+    CHECK(stats.hits == 2 && stats.misses == 4 && stats.bytes_in_use == 0);
+    CHECK(stats.bytes_cached == 448 + 4032 + 448 + (3 << 20));
+
+    memory::empty_cache();
+    CHECK(memory::stats().bytes_cached == 0);
+}
+
+void test_allocator_empty_cache_reaches_workers() {
+    auto allocator = std::make_shared<memory::CachingAllocator>();
+    ScopedAllocator scope(allocator);
+    with_thread_counts([] {
+        // Each chunk frees a small block into the cache of the thread that ran it
+        parallel::parallel_for(0, 64, 1, [](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                Tensor<float32> t = Tensor<float32>::empty({16 + static_cast<int>(i % 4) * 16});
+                t.data[0] = 1.0f;
+            }
+        });
+    });
+    CHECK(memory::stats().bytes_cached > 0);
+    CHECK(memory::stats().bytes_in_use == 0);
+
+    // Idle pool workers keep their caches; empty_cache reaches them too
+    memory::empty_cache();
+    CHECK(memory::stats().bytes_cached == 0);
+    parallel::parallel_for(0, 64, 1, [](size_t, size_t) { Tensor<float32>::empty({16}); });
+    memory::empty_cache();
+    CHECK(memory::stats().bytes_cached == 0);
+}
+
+void test_allocator_cache_limit() {
+    auto allocator = std::make_shared<memory::CachingAllocator>();
+    ScopedAllocator scope(allocator);
+
+    // Three 448-byte blocks under a 1024-byte limit: the third goes back to the system
+    allocator->set_cache_limit(1024);
+    {
+        Tensor<float32> a = Tensor<float32>::empty({100});
+        Tensor<float32> b = Tensor<float32>::empty({100});
+        Tensor<float32> c = Tensor<float32>::empty({100});
+    }
+    CHECK(memory::stats().bytes_cached == 896);
+
+    // Lowering the limit below the cached bytes drops them
+    allocator->set_cache_limit(512);
+    CHECK(memory::stats().bytes_cached == 0);
+    allocator->set_cache_limit(0);
+    { Tensor<float32> a = Tensor<float32>::empty({100}); }
+    CHECK(memory::stats().bytes_cached == 0);
+    Tensor<float32> a = Tensor<float32>::empty({100});
+    CHECK(memory::stats().hits == 0 && memory::stats().misses == 5);
+}
+
+void test_allocator_thread_cache_disabled() {
+    auto allocator = std::make_shared<memory::CachingAllocator>();
+    ScopedAllocator scope(allocator);
+
+    // A block in the thread cache stays there while the cache is disabled
+    const float32* cached;
+    {
+        Tensor<float32> a = Tensor<float32>::empty({100});
+        cached = a.data.get();
+    }
+    allocator->set_thread_cache_enabled(false);
+    {
+        Tensor<float32> b = Tensor<float32>::empty({100});
+        CHECK(b.data.get() != cached);
+        CHECK(memory::stats().hits == 0 && memory::stats().misses == 2);
+    }
+
+    // Blocks freed meanwhile go to the shared lists, where any thread can reuse them
+    const float32* shared;
+    std::thread([&] {
+        Tensor<float32> c = Tensor<float32>::empty({100});
+        shared = c.data.get();
+    }).join();
+    memory::AllocatorStats stats = memory::stats();
+    CHECK(stats.hits == 1 && stats.misses == 2 && stats.bytes_cached == 2 * 448);
+    {
+        Tensor<float32> d = Tensor<float32>::empty({100});
+        CHECK(d.data.get() == shared);
+        CHECK(memory::stats().hits == 2);
+    }
+
+    allocator->set_thread_cache_enabled(true);
+    CHECK(Tensor<float32>::empty({100}).data.get() == cached);
+    memory::empty_cache();
+    CHECK(memory::stats().bytes_cached == 0);
+}
+
+void test_set_allocator_with_live_buffers() {
+    auto caching = std::make_shared<memory::CachingAllocator>();
+    auto system = std::make_shared<memory::SystemAllocator>();
+    std::weak_ptr<memory::CachingAllocator> weak = caching;
+
+    Tensor<int32> old_buffer;
+    {
+        ScopedAllocator scope(caching);
+        old_buffer = arange<int32>({256});
+        memory::set_allocator(system);
+        caching.reset();
+
+        // The buffer keeps its allocator alive and goes back to it, not to the current one
+        CHECK(!weak.expired());
+        Tensor<int32> new_buffer = arange<int32>({256}, 1.0);
+        CHECK(memory::get_allocator() == system);
+        CHECK(system->stats().misses == 1 && system->stats().bytes_in_use == 1024);
+        CHECK(weak.lock()->stats().bytes_in_use == 1024);
+        CHECK(old_buffer.data[255] == 255 && new_buffer.data[255] == 256);
+    }
+    CHECK(system->stats().bytes_in_use == 0);
+    old_buffer = Tensor<int32>();
+    if (std::shared_ptr<memory::CachingAllocator> owner = weak.lock()) {
+        CHECK(owner->stats().bytes_in_use == 0 && owner->stats().bytes_cached == 1024);
+        owner->empty_cache();
+    }
+}
+
+// ---------------------------------------------------------------- Reductions
+
+void test_reductions_over_dims() {
+    auto plus = [](double a, double b) { return a + b; };
+    auto times = [](double a, double b) { return a * b; };
+    auto larger = [](double a, double b) { return std::max(a, b); };
+    auto smaller = [](double a, double b) { return std::min(a, b); };
+    with_thread_counts([&] {
+        for_each_dtype([&](auto tag) {
+            using T = decltype(tag);
+            Tensor<T> t = pattern<T>({4, 5, 6}, 1);
+            for (const Dims& dims : {Dims{0}, Dims{1}, Dims{-1}, Dims{0, 2}, Dims{}}) {
+                DimMask mask = utils::reduction_mask(dims, t.ndim);
+                std::vector<double> sums = naive_reduce(t, mask, 0.0, plus);
+                CHECK(equal_values(t.sum(dims), sums));
+                CHECK(equal_values(t.prod(dims), naive_reduce(t, mask, 1.0, times)));
+                CHECK(equal_values(t.max(dims), naive_reduce(t, mask, -1e9, larger)));
+                CHECK(equal_values(t.min(dims), naive_reduce(t, mask, 1e9, smaller)));
+
+                size_t count = t.numel / sums.size();
+                std::vector<double> means;
+                for (double sum : sums) means.push_back(static_cast<float32>(sum / static_cast<double>(count)));
+                CHECK(equal_values(t.mean(dims), means));
+
+                // keepdim leaves the reduced dims with size 1
+                Dims kept = t.sum(dims, true).shape;
+                CHECK(static_cast<int>(kept.size()) == t.ndim);
+                for (int d = 0; d < t.ndim; d++) CHECK(kept[d] == (mask[d] ? 1 : t.shape[d]));
+            }
+
+            // Reduced dims that are not the innermost, on a permuted input
+            Tensor<T> p = pattern<T>({6, 4, 5}, 2).permute({1, 2, 0});
+            CHECK(equal_values(p.sum({1}), naive_reduce(p, utils::reduction_mask({1}, 3), 0.0, plus)));
+            CHECK(equal_values(p.max({0, 2}, true), naive_reduce(p, utils::reduction_mask({0, 2}, 3), -1e9, larger)));
+        });
+    });
+
+    // Past the parallel grain and the vector widths
+    Tensor<float32> big = pattern<float32>({100003}, 3);
+    CHECK(equal_values(big.sum(), naive_reduce(big, utils::reduction_mask({}, 1), 0.0, plus)));
+    CHECK(equal_values(big.min(), {-3.0}));
+
+    CHECK_THROWS(pattern<float32>({2, 3}).sum({2}), std::invalid_argument);
+    CHECK_THROWS(pattern<float32>({2, 3}).sum({1, -1}), std::invalid_argument);
+}
+
+void test_argmax_and_nan() {
+    // Ties give the first position
+    CHECK(equal_values(values<int32>({6}, {1, 5, 2, 5, 0, 5}).argmax(), {1}));
+    Tensor<float32> rows = values<float32>({2, 4}, {3, 7, 7, 1, 2, 2, 2, 2});
+    CHECK(equal_values(rows.argmax({1}), {1, 0}));
+    CHECK(equal_values(rows.argmax({0}), {0, 0, 0, 1}));
+    CHECK(utils::shapes_equal(rows.argmax({1}, true).shape, Dims{2, 1}));
+    // Without a dim, the index is into the flattened tensor
+    CHECK(equal_values(rows.argmax(), {1}));
+    CHECK_THROWS(rows.argmax({0, 1}), std::invalid_argument);
+
+    // NaN wins max, min and argmax (its first position) and propagates through sum and mean,
+    // also in the vectorized paths
+    const double nan = std::nan("");
+    for (int n : {5, 1000}) {
+        Tensor<float32> t = arange<float32>({n}, -3.0, 0.5);
+        t.data[n / 2] = static_cast<float32>(nan);
+        t.data[n - 1] = static_cast<float32>(nan);
+        CHECK(std::isnan(t.max().data[0]));
+        CHECK(std::isnan(t.min().data[0]));
+        CHECK(equal_values(t.argmax(), {static_cast<double>(n / 2)}));
+        CHECK(std::isnan(t.sum().data[0]));
+        CHECK(std::isnan(t.mean().data[0]));
+    }
+    Tensor<bfloat16> h = values<bfloat16>({3}, {1, nan, 2});
+    CHECK(std::isnan(static_cast<float>(h.max().data[0])));
+    CHECK(equal_values(h.argmax(), {1}));
+}
+
+void test_reductions_of_empty() {
+    Tensor<float32> empty = Tensor<float32>::empty({3, 0});
+    // Sum and product have an identity, the mean of nothing is NaN
+    CHECK(equal_values(empty.sum(), {0}));
+    CHECK(equal_values(empty.prod(), {1}));
+    CHECK(equal_values(empty.sum({1}), {0, 0, 0}));
+    CHECK(std::isnan(empty.mean().data[0]));
+    CHECK(empty.max({0}).numel == 0);  // No outputs, so nothing to take the max of
+
+    // Max, min and argmax of an empty dim are not defined
+    CHECK_THROWS(empty.max(), std::invalid_argument);
+    CHECK_THROWS(empty.min({1}), std::invalid_argument);
+    CHECK_THROWS(empty.argmax({1}), std::invalid_argument);
+    CHECK_THROWS(Tensor<uint8>::empty({0}).argmax(), std::invalid_argument);
+}
+
+// ---------------------------------------------------------------- Views
+
+// contiguous() of a view gives its elements in row-major order
+template<typename T>
+bool copies_in_order(const Tensor<T>& view) {
+    Tensor<T> copy = view.contiguous();
+    if (!copy.is_contiguous || !utils::shapes_equal(copy.shape, view.shape)) return false;
+    for (size_t i = 0; i < copy.numel; i++) {
+        if (copy.data[i] != element(view, i)) return false;
+    }
+    return true;
+}
+
+void test_transpose_copies() {
+    with_thread_counts([] {
+        // Element sizes 1, 2 and 4 take different transpose kernels
+        for_each_dtype([](auto tag) {
+            using T = decltype(tag);
+            // Around the blocked kernel's tile and row block (TRANSPOSE_ROWS)
+            for (const auto& [rows, cols] : {std::pair<int, int>{1, 9}, {7, 5}, {64, 64}, {65, 130}, {300, 17}}) {
+                Tensor<T> base = pattern<T>({rows, cols}, rows + cols);
+                Tensor<T> t = base.transpose();
+                CHECK(utils::shapes_equal(t.shape, Dims{cols, rows}));
+                CHECK(t.data.get() == base.data.get() && t.is_view && t.is_dense);
+                CHECK(t.is_contiguous == (rows == 1 || cols == 1));
+                CHECK(copies_in_order(t));
+            }
+            // Batched: NCHW to NHWC, and a transposed matrix inside a batch
+            Tensor<T> nchw = pattern<T>({2, 3, 20, 30}, 1);
+            CHECK(copies_in_order(nchw.permute({0, 2, 3, 1})));
+            CHECK(copies_in_order(nchw.transpose(-1, -2)));
+            // A transposed view that is also stepped (not dense) goes through the strided loop
+            CHECK(copies_in_order(pattern<T>({40, 50}, 2).slice(1, 0, 50, 3).transpose()));
+        });
+    });
+}
+
+void test_permute() {
+    Tensor<int32> t = arange<int32>({2, 3, 4});
+    Tensor<int32> p = t.permute({2, 0, 1});
+    CHECK(utils::shapes_equal(p.shape, Dims{4, 2, 3}));
+    CHECK(utils::shapes_equal(p.strides, Dims{1, 12, 4}));
+    CHECK(utils::shapes_equal(t.permute({-1, 0, 1}).strides, p.strides));
+    CHECK(utils::shapes_equal(t.transpose().shape, Dims{4, 3, 2}));
+    CHECK(utils::shapes_equal(t.transpose(0, 2).strides, Dims{1, 4, 12}));
+    // Permuting back gives the original layout, which is contiguous again
+    CHECK(p.permute({1, 2, 0}).is_contiguous);
+    CHECK(equal(p.permute({1, 2, 0}), t));
+
+    // Views share storage: writes through them reach the base
+    p.select(0, 3).select(0, 1).data[0] = -1;
+    CHECK(t.data[12 + 3] == -1);
+
+    CHECK_THROWS(t.permute({0, 1}), std::invalid_argument);
+    CHECK_THROWS(t.permute({0, 1, 1}), std::invalid_argument);
+    CHECK_THROWS(t.permute({0, 1, 3}), std::invalid_argument);
+    CHECK_THROWS(t.transpose(0, 3), std::invalid_argument);
+}
+
+void test_slicing_views() {
+    Tensor<int32> t = arange<int32>({4, 5, 6});
+
+    // select and [] drop the dim, negative indices count from the end
+    Tensor<int32> s = t.select(1, -1);
+    CHECK(utils::shapes_equal(s.shape, Dims{4, 6}));
+    CHECK(s.data.get() == t.data.get() + 4 * 6 && s.is_view);
+    CHECK(equal(t[2], t.select(0, 2)));
+    CHECK(t[-1][-1].data[5] == 4 * 5 * 6 - 1);
+    CHECK_THROWS(t.select(1, 5), std::out_of_range);
+    CHECK_THROWS(t.select(1, -6), std::out_of_range);
+    CHECK_THROWS(t.select(3, 0), std::out_of_range);
+    CHECK_THROWS(t.select(-4, 0), std::out_of_range);
+
+    // narrow takes exactly length elements
+    Tensor<int32> n = t.narrow(2, 1, 4);
+    CHECK(utils::shapes_equal(n.shape, Dims{4, 5, 4}) && !n.is_contiguous);
+    CHECK(element(n, 0) == 1 && element(n, 4) == 7);
+    CHECK(t.narrow(0, -2, 2).data.get() == t.data.get() + 2 * 30);
+    CHECK(t.narrow(1, 5, 0).numel == 0);
+    CHECK_THROWS(t.narrow(2, 3, 4), std::out_of_range);
+    CHECK_THROWS(t.narrow(2, -7, 1), std::out_of_range);
+    CHECK_THROWS(t.narrow(2, 0, -1), std::out_of_range);
+
+    // slice has Python semantics: negative bounds, clamping and steps
+    CHECK(utils::shapes_equal(t.slice(2, 1, -1).shape, Dims{4, 5, 4}));
+    CHECK(utils::shapes_equal(t.slice(2, -100, 100).shape, t.shape));
+    CHECK(t.slice(2, 4, 2).numel == 0);
+    CHECK(t.slice(2, 7, 9).numel == 0);
+    Tensor<int32> stepped = t.slice(1, 1, 5, 2);
+    CHECK(utils::shapes_equal(stepped.shape, Dims{4, 2, 6}));
+    CHECK(utils::shapes_equal(stepped.strides, Dims{30, 12, 1}));
+    CHECK(element(stepped, 6) == 18);
+    CHECK(t.slice(2, 0, 6, 4).shape[2] == 2);
+    CHECK_THROWS(t.slice(2, 0, 6, 0), std::invalid_argument);
+    CHECK_THROWS(t.slice(5, 0, 1), std::out_of_range);
+
+    // Views of views accumulate their offsets, and ops read them through their strides
+    Tensor<int32> inner = t.slice(0, 1, 4, 2).narrow(1, 1, 3).select(2, 4);
+    CHECK(utils::shapes_equal(inner.shape, Dims{2, 3}));
+    CHECK(equal(inner, values<int32>({2, 3}, {40, 46, 52, 100, 106, 112})));
+    CHECK(equal(inner + 1.0, values<int32>({2, 3}, {41, 47, 53, 101, 107, 113})));
+
+    // Writes through a view reach the base, and the view keeps the storage alive
+    Tensor<int32> row;
+    {
+        Tensor<int32> base = arange<int32>({3, 3});
+        row = base[1];
+        row *= 10.0;
+        CHECK(equal(base, values<int32>({3, 3}, {0, 1, 2, 30, 40, 50, 6, 7, 8})));
+    }
+    CHECK(equal(row, values<int32>({3}, {30, 40, 50})));
+}
+
+void test_small_vector_growth() {
+    // Past the inline capacity the values move to the heap and keep their order
+    Dims d;
+    for (int i = 0; i < 12; i++) d.push_back(i);
+    CHECK(d.size() == 12 && d.capacity() >= 12);
+    bool ordered = true;
+    for (int i = 0; i < 12; i++) ordered = ordered && d[i] == i;
+    CHECK(ordered);
+
+    d.insert(d.begin() + 3, d.begin() + 8, d.end());  // A range of the vector itself
+    CHECK(d.size() == 16 && d[3] == 8 && d[6] == 11 && d[7] == 3 && d.back() == 11);
+    d.erase(d.begin(), d.begin() + 10);
+    CHECK((d == Dims{6, 7, 8, 9, 10, 11}));
+
+    // Copies and moves between inline and heap storage
+    Dims big(20, 7), small{1, 2, 3};
+    Dims copy = big;
+    CHECK(copy == big && copy.size() == 20);
+    copy = small;
+    CHECK(copy == small);
+    Dims moved = std::move(big);
+    CHECK(moved.size() == 20 && moved[19] == 7 && big.empty());
+    small = std::move(moved);
+    CHECK(small.size() == 20);
+    CHECK((Dims(std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9}).back() == 9));
+}
+
+void test_many_dims() {
+    // 10 dims, some of size 1, so shapes and strides live on the heap
+    const Dims shape = {2, 1, 3, 1, 2, 2, 1, 2, 3, 2};
+    Tensor<float32> t = arange<float32>(shape, -100.0, 0.5);
+    CHECK(t.ndim == 10 && t.is_contiguous && t.strides.back() == 1 && t.strides[0] == 144);
+
+    // Broadcasting against fewer and more dims
+    Tensor<float32> row = arange<float32>({3, 2}, 1.0);
+    auto add = [](auto x, auto y) { return x + y; };
+    CHECK(equal(t + row, naive_binary(t, row, add)));
+    Tensor<float32> wide = arange<float32>({2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}, 3.0);
+    Tensor<float32> sum = t + wide;
+    CHECK(sum.ndim == 11 && equal(sum, naive_binary(t, wide, add)));
+
+    // Reversing every dim and copying back
+    Tensor<float32> reversed = t.transpose();
+    CHECK(copies_in_order(reversed));
+    CHECK(equal(reversed.transpose(), t));
+
+    // Reductions, views and batched matmul over all the batch dims
+    CHECK(equal_values(t.sum({0, 2, -1}), naive_reduce(t, utils::reduction_mask({0, 2, -1}, 10), 0.0,
+                                                         [](double a, double b) { return a + b; })));
+    CHECK(t.squeeze({}).ndim == 7);
+    CHECK(t.unsqueeze({0, 11}).ndim == 12);
+    CHECK(equal(t.view({48, 6}).view(shape), t));
+    CHECK(copies_in_order(t.slice(-2, 0, 3, 2).select(4, 1)));
+    Tensor<float32> w = pattern<float32>({2, 5}, 1);
+    CHECK(equal(Tensor<float32>::matmul(t, w), naive_matmul(t, w.expand({2, 1, 3, 1, 2, 2, 1, 2, 2, 5}))));
+}
+
+// ---------------------------------------------------------------- Matmul
+
+void test_parallel_for() {
+    with_thread_counts([] {
+        const size_t n = 100003;
+        std::vector<std::atomic<int>> visits(n);
+        parallel::parallel_for(0, n, 7, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) visits[i]++;
+        });
+        bool once = true;
+        for (const std::atomic<int>& v : visits) once = once && v == 1;
+        CHECK(once);
+
+        // Nested regions run serially on the calling task
+        std::atomic<int> nested{0};
+        bool pooled = parallel::get_num_threads() > 1;
+        parallel::parallel_for(0, 64, 1, [&](size_t begin, size_t end) {
+            CHECK(parallel::in_parallel_region() == pooled);
+            parallel::parallel_for(begin, end, 1, [&](size_t b, size_t e) { nested += static_cast<int>(e - b); });
+        });
+        CHECK(nested == 64);
+        CHECK(!parallel::in_parallel_region());
+
+        // The exception of a failed chunk reaches the caller
+        CHECK_THROWS(parallel::parallel_for(0, 1000, 1, [](size_t begin, size_t end) {
+            if (begin <= 700 && 700 < end) throw std::runtime_error("task failed");
+        }), std::runtime_error);
+    });
+}
+
+// Ops on shared read-only inputs from several threads, while the pool is being replaced
+void test_concurrent_ops() {
+    Tensor<float32> a = pattern<float32>({97, 130}, 1), b = pattern<float32>({130, 61}, 2);
+    Tensor<float32> x = pattern<float32>({317, 331}, 3), y = pattern<float32>({317, 331}, 4), row = pattern<float32>({331}, 5);
+    Tensor<int32> ai = pattern<int32>({64, 200}, 6), bi = pattern<int32>({200, 48}, 7);
+    Tensor<float32> xt = x.transpose();
+
+    int saved = parallel::get_num_threads();
+    parallel::set_num_threads(1);
+    const Tensor<float32> product = Tensor<float32>::matmul(a, b), sum = x + y, broadcast = x + row;
+    const Tensor<float32> transposed = xt.contiguous();
+    const Tensor<int32> product_int = Tensor<int32>::matmul(ai, bi);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> mismatches{0};
+    std::thread resizer([&] {
+        for (int i = 0; !done; i++) parallel::set_num_threads(1 + i % 4);
+    });
+    std::vector<std::thread> workers;
+    for (int w = 0; w < 6; w++) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < 15; i++) {
+                mismatches += !equal(Tensor<float32>::matmul(a, b), product);
+                mismatches += !equal(x + y, sum);
+                mismatches += !equal(x + row, broadcast);
+                mismatches += !equal(xt.contiguous(), transposed);
+                mismatches += !equal(Tensor<int32>::matmul(ai, bi), product_int);
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    done = true;
+    resizer.join();
+    parallel::set_num_threads(saved);
+
+    CHECK(mismatches == 0);
+    // The inputs were only read
+    CHECK(equal(a, pattern<float32>({97, 130}, 1)) && equal(x, pattern<float32>({317, 331}, 3)));
+}
+
+void test_matmul_gemm() {
+    with_thread_counts([] {
+        for_each_dtype([](auto tag) {
+            using T = decltype(tag);
+            // Past the KC and MC blocks and not a multiple of the register tile
+            for (const auto& [M, K, N] : {std::array<int, 3>{37, 300, 70}, {130, 19, 33}, {9, 9, 9}}) {
+                Tensor<T> a = pattern<T>({M, K}, 1), b = pattern<T>({K, N}, 2);
+                Tensor<T> expected = naive_matmul(a, b);
+                CHECK(equal(Tensor<T>::matmul(a, b), expected));
+
+                // Transposed, sliced and stepped operands reach the GEMM as strides
+                Tensor<T> at = pattern<T>({K, M}, 1).transpose();
+                Tensor<T> bt = pattern<T>({N, K}, 2).transpose();
+                CHECK(equal(Tensor<T>::matmul(at, bt), naive_matmul(at, bt)));
+                Tensor<T> as = pattern<T>({M + 3, 2 * K}, 3).narrow(0, 2, M).slice(1, 0, 2 * K, 2);
+                CHECK(equal(Tensor<T>::matmul(as, b), naive_matmul(as, b)));
+
+                // Into a strided out
+                Tensor<T> out = Tensor<T>::zeros({N, M});
+                F::matmul(a, b, out.transpose());
+                CHECK(equal(out.transpose(), expected));
+            }
+        });
+    });
+}
+
+void test_matmul_batched() {
+    with_thread_counts([] {
+        for_each_dtype([](auto tag) {
+            using T = decltype(tag);
+            const int B = 5, M = 23, K = 40, N = 17;
+
+            Tensor<T> a = pattern<T>({B, M, K}, 1), b = pattern<T>({B, K, N}, 2);
+            CHECK(equal(Tensor<T>::matmul(a, b), naive_matmul(a, b)));
+
+            // Permuted batch operand
+            Tensor<T> ap = pattern<T>({K, B, M}, 4).permute({1, 2, 0});
+            CHECK(equal(Tensor<T>::matmul(ap, b), naive_matmul(ap, b)));
+
+            // Shared weights (zero batch stride) fold into one tall GEMM, on either side
+            Tensor<T> w = pattern<T>({K, N}, 5);
+            CHECK(equal(Tensor<T>::matmul(a, w), naive_matmul(a, w.expand({B, K, N}))));
+            Tensor<T> wa = pattern<T>({M, K}, 6);
+            CHECK(equal(Tensor<T>::matmul(wa, b), naive_matmul(wa.expand({B, M, K}), b)));
+            Tensor<T> a_expanded = pattern<T>({1, M, K}, 7).expand({B, M, K});
+            CHECK(equal(Tensor<T>::matmul(a_expanded, b), naive_matmul(a_expanded, b)));
+
+            // Batch dims broadcast against each other
+            Tensor<T> a4 = pattern<T>({2, 1, M, K}, 8), b3 = pattern<T>({3, K, N}, 9);
+            Tensor<T> r = Tensor<T>::matmul(a4, b3);
+            CHECK(utils::shapes_equal(r.shape, Dims{2, 3, M, N}));
+            CHECK(equal(r, naive_matmul(a4.expand({2, 3, M, K}), b3.expand({2, 3, K, N}))));
+
+            // An empty batch, broadcasting the weights to size 0
+            CHECK(utils::shapes_equal(Tensor<T>::matmul(Tensor<T>::empty({0, M, K}), w).shape, Dims{0, M, N}));
+
+            // A vector on the right is a column matrix, kept in the result
+            Tensor<T> v = pattern<T>({K}, 10);
+            CHECK(equal(Tensor<T>::matmul(a, v), naive_matmul(a, v.unsqueeze({1}).expand({B, K, 1}))));
+        });
+    });
+}
+
+void test_matmul_small_kernels() {
+    with_thread_counts([] {
+        for_each_dtype([](auto tag) {
+            using T = decltype(tag);
+            for (int M = 1; M <= cpu::SMALL_MATMUL_MAX; M++) {
+                for (int N = 1; N <= cpu::SMALL_MATMUL_MAX; N++) {
+                    CHECK(cpu::small_matmul_kernel_for<T>(M, N) != nullptr);
+                    for (int K : {1, 3, 17}) {
+                        Tensor<T> a = pattern<T>({4, M, K}, M), b = pattern<T>({4, K, N}, N);
+                        Tensor<T> expected = naive_matmul(a, b);
+                        // Dense operands take the unrolled kernels, a column-major b the general path
+                        Tensor<T> b_cols = b.transpose(1, 2).contiguous().transpose(1, 2);
+                        CHECK(equal(Tensor<T>::matmul(a, b), expected));
+                        CHECK(equal(Tensor<T>::matmul(a, b_cols), expected));
+                    }
+                }
+            }
+            CHECK(cpu::small_matmul_kernel_for<T>(cpu::SMALL_MATMUL_MAX + 1, 1) == nullptr);
+            CHECK(cpu::small_matmul_kernel_for<T>(1, 0) == nullptr);
+        });
+    });
+}
+
+void test_matmul_empty() {
+    for_each_dtype([](auto tag) {
+        using T = decltype(tag);
+        // K = 0 gives zeros, also in the small kernels and into an out holding other values
+        for (int M : {3, 40}) {
+            Tensor<T> r = Tensor<T>::matmul(Tensor<T>::empty({M, 0}), Tensor<T>::empty({0, M}));
+            CHECK(equal(r, Tensor<T>::zeros({M, M})));
+            Tensor<T> out = Tensor<T>::ones({M, M});
+            F::matmul(Tensor<T>::empty({M, 0}), Tensor<T>::empty({0, M}), out);
+            CHECK(equal(out, Tensor<T>::zeros({M, M})));
+        }
+        CHECK(Tensor<T>::matmul(Tensor<T>::empty({0, 4}), pattern<T>({4, 5})).numel == 0);
+        CHECK(utils::shapes_equal(Tensor<T>::matmul(pattern<T>({3, 4}), Tensor<T>::empty({4, 0})).shape, Dims{3, 0}));
+    });
+    CHECK_THROWS(Tensor<float32>::matmul(pattern<float32>({3, 4}), pattern<float32>({5, 3})), std::exception);
+}
+
+// ---------------------------------------------------------------- Half precision
+
+// Every 16-bit pattern goes through float32 and back unchanged (NaNs stay NaN)
+template<typename H>
+void check_half_bits_round_trip() {
+    Tensor<H> all = Tensor<H>::empty({65536});
+    for (size_t i = 0; i < all.numel; i++) all.data[i] = H::from_bits(static_cast<uint16_t>(i));
+    Tensor<H> back = all.template to<float32>().template to<H>();
+    bool same = true;
+    for (size_t i = 0; i < all.numel; i++) {
+        float value = all.data[i];
+        same = same && (std::isnan(value) ? std::isnan(static_cast<float>(back.data[i])) : back.data[i].bits == all.data[i].bits);
+    }
+    CHECK(same);
+}
+
+void test_half_round_trips() {
+    check_half_bits_round_trip<float16>();
+    check_half_bits_round_trip<bfloat16>();
+
+    // Rounding to nearest even, overflow to infinity, subnormals
+    const float inf = std::numeric_limits<float>::infinity();
+    CHECK(static_cast<float>(float16(1.0f + 0x1p-11f)) == 1.0f);
+    CHECK(static_cast<float>(float16(1.0f + 0x3p-11f)) == 1.0f + 0x1p-9f);
+    CHECK(static_cast<float>(float16(65504.0f)) == 65504.0f);
+    CHECK(static_cast<float>(float16(65519.0f)) == 65504.0f);
+    CHECK(static_cast<float>(float16(65520.0f)) == inf);
+    CHECK(static_cast<float>(float16(-0x1p-24f)) == -0x1p-24f);
+    CHECK(static_cast<float>(float16(0x1p-26f)) == 0.0f);
+    CHECK(std::isnan(static_cast<float>(float16(std::nanf("")))));
+    CHECK(static_cast<float>(bfloat16(1.0f + 0x1p-8f)) == 1.0f);
+    CHECK(static_cast<float>(bfloat16(1.0f + 0x3p-8f)) == 1.0f + 0x1p-6f);
+    CHECK(static_cast<float>(bfloat16(-std::numeric_limits<float>::max())) == -inf);
+    CHECK(static_cast<float>(bfloat16(inf)) == inf);
+    CHECK(std::isnan(static_cast<float>(bfloat16(std::nanf("")))));
+
+    // The vectorized tensor conversions round like the scalar ones
+    Tensor<float32> x = arange<float32>({4099}, -70000.0, 33.3);
+    Tensor<float16> h = x.to<float16>();
+    Tensor<bfloat16> b = x.to<bfloat16>();
+    bool same = true;
+    for (size_t i = 0; i < x.numel; i++) {
+        same = same && h.data[i].bits == float16(x.data[i]).bits && b.data[i].bits == bfloat16(x.data[i]).bits;
+    }
+    CHECK(same);
+}
+
+void test_half_matmul() {
+    with_thread_counts([] {
+        // Products are accumulated in float32 and rounded once, so the result is the float32
+        // matmul of the widened operands, rounded
+        for (const auto& [M, K, N] : {std::array<int, 3>{3, 500, 5}, {40, 300, 70}}) {
+            Tensor<float32> a = arange<float32>({M, K}, -1.0, 0.0071), b = arange<float32>({K, N}, 0.9, -0.0013);
+            Tensor<float16> ah = a.to<float16>(), bh = b.to<float16>();
+            Tensor<bfloat16> ab = a.to<bfloat16>(), bb = b.to<bfloat16>();
+            CHECK(equal(Tensor<float16>::matmul(ah, bh),
+                        Tensor<float32>::matmul(ah.to<float32>(), bh.to<float32>()).to<float16>()));
+            CHECK(equal(Tensor<bfloat16>::matmul(ab, bb),
+                        Tensor<float32>::matmul(ab.to<float32>(), bb.to<float32>()).to<bfloat16>()));
+        }
+    });
+
+    // A long sum of small terms: rounding every step to float16 would stall at 256
+    Tensor<float16> ones = Tensor<float16>::ones({1, 4096});
+    Tensor<float16> halves = Tensor<float16>::full({4096, 1}, 0.125);
+    CHECK(static_cast<float>(Tensor<float16>::matmul(ones, halves).data[0]) == 512.0f);
+
+    // Elementwise ops round each result once too
+    Tensor<bfloat16> p = values<bfloat16>({2}, {1.0, 3.0}), q = values<bfloat16>({2}, {0x1p-9, 0.5});
+    CHECK(equal(p + q, values<bfloat16>({2}, {1.0, 3.5})));
+}
+
+// ---------------------------------------------------------------- Dtype conversion
+
+// C++ cast of x to I, truncated toward zero, saturated to the range of I, NaN giving 0
+template<typename I>
+I expected_integer(float x) {
+    if (std::isnan(x)) return 0;
+    double t = std::trunc(static_cast<double>(x));
+    t = std::min<double>(std::max<double>(t, std::numeric_limits<I>::lowest()), std::numeric_limits<I>::max());
+    return static_cast<I>(t);
+}
+
+// from, repeated past the vector widths, converted to I by to<I>() match expected_integer
+template<typename F, typename I>
+bool converts_to_integer(const std::vector<float>& from) {
+    const size_t n = 1003;
+    Tensor<F> t = Tensor<F>::empty({static_cast<int>(n)});
+    for (size_t i = 0; i < n; i++) t.data[i] = static_cast<F>(from[i % from.size()]);
+    Tensor<I> converted = t.template to<I>();
+    for (size_t i = 0; i < n; i++) {
+        if (converted.data[i] != expected_integer<I>(static_cast<float>(t.data[i]))) return false;
+    }
+    return true;
+}
+
+void test_conversion_saturation() {
+    const float inf = std::numeric_limits<float>::infinity();
+    const std::vector<float> specials = {0.5f, -0.5f, 1.9f, -1.9f, 254.99f, 255.5f, 256.0f, -3.0f, 1e10f, -1e10f,
+                                         inf, -inf, std::nanf(""), 2147483520.0f, -2147483648.0f, 3e9f, 77.7f};
+    with_thread_counts([&] {
+        CHECK((converts_to_integer<float32, int32>(specials)));
+        CHECK((converts_to_integer<float32, uint8>(specials)));
+        CHECK((converts_to_integer<float16, int32>(specials)));
+        CHECK((converts_to_integer<float16, uint8>(specials)));
+        CHECK((converts_to_integer<bfloat16, int32>(specials)));
+        CHECK((converts_to_integer<bfloat16, uint8>(specials)));
+    });
+    CHECK(equal(values<float32>({4}, {2.7, -2.7, 300, -300}).to<uint8>(), values<uint8>({4}, {2, 0, 255, 0})));
+    CHECK(equal(values<float32>({3}, {2.7, -2.7, std::nan("")}).to<int32>(), values<int32>({3}, {2, -2, 0})));
+}
+
+void test_conversion_between_integers() {
+    // int32 to uint8 wraps like a C++ cast, in the vector and scalar paths alike
+    Tensor<int32> wide = Tensor<int32>::empty({1003});
+    const std::vector<int32> samples = {-1, 256, 300, 255, -256, 0, 70000, -129};
+    for (size_t i = 0; i < wide.numel; i++) wide.data[i] = samples[i % samples.size()];
+    Tensor<uint8> narrow = wide.to<uint8>();
+    bool wraps = true;
+    for (size_t i = 0; i < wide.numel; i++) wraps = wraps && narrow.data[i] == static_cast<uint8>(wide.data[i]);
+    CHECK(wraps);
+    CHECK(equal(narrow.to<int32>(), wide.to<uint8>().to<int32>()));
+    CHECK(equal(values<uint8>({3}, {0, 128, 255}).to<int32>(), values<int32>({3}, {0, 128, 255})));
+
+    // Large int32 values are exact between integer types but round through float32
+    Tensor<int32> large = values<int32>({2}, {16777217, -16777217});
+    CHECK(equal(large.to<int32>(), large));
+    CHECK(equal(large.to<float32>(), values<float32>({2}, {16777216, -16777216})));
+
+    // With a scale and shift, integer results saturate instead
+    CHECK(equal(values<int32>({3}, {-5, 100, 300}).to<uint8>(2.0f, 0.0f), values<uint8>({3}, {0, 200, 255})));
+    CHECK(equal(values<uint8>({3}, {0, 51, 255}).to<float32>(0.5f, -1.0f), values<float32>({3}, {-1.0, 24.5, 126.5})));
+
+    // Strided sources give the same values as contiguous ones
+    Tensor<float32> t = arange<float32>({33, 45}, -400.0, 0.77).transpose();
+    CHECK(equal(t.to<int32>(), t.contiguous().to<int32>()));
+    CHECK(equal(t.to<float16>(), t.contiguous().to<float16>()));
+}
+
+// ---------------------------------------------------------------- Quantized matmul
+
+// uint8 tensor covering the whole 0 to 255 range
+Tensor<uint8> bytes(const Dims& shape, int seed) {
+    Tensor<uint8> t = Tensor<uint8>::empty(shape);
+    for (size_t i = 0; i < t.numel; i++) t.data[i] = static_cast<uint8>((i * 37 + seed * 11) % 256);
+    return t;
+}
+
+// sum((a - a_zero) * (b - b_zero)) by a triple loop, for 2-D operands
+Tensor<int32> naive_qmatmul(const Tensor<uint8>& a_, int32 a_zero, const Tensor<uint8>& b_, int32 b_zero) {
+    Tensor<uint8> a = a_.contiguous(), b = b_.contiguous();
+    int M = a.shape[0], K = a.shape[1], N = b.shape[1];
+    Tensor<int32> out = Tensor<int32>::empty({M, N});
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) {
+            int64_t acc = 0;
+            for (int p = 0; p < K; p++) acc += (a.data[i * K + p] - a_zero) * static_cast<int64_t>(b.data[p * N + j] - b_zero);
+            out.data[i * N + j] = static_cast<int32>(acc);
+        }
+    }
+    return out;
+}
+
+void test_quantized_matmul_exact() {
+    with_thread_counts([] {
+        const QuantParams qa{0.02f, 128}, qb{0.5f, 3};
+        // Odd K (consumed in pairs) past the KC block, and sizes off the register tile
+        for (const auto& [M, K, N] : {std::array<int, 3>{13, 1037, 35}, {4, 1, 16}, {97, 64, 3}}) {
+            Tensor<uint8> a = bytes({M, K}, 1), b = bytes({K, N}, 2);
+            Tensor<int32> expected = naive_qmatmul(a, qa.zero_point, b, qb.zero_point);
+            CHECK(equal(F::quantized_matmul(a, qa, b, qb), expected));
+
+            Tensor<uint8> at = bytes({K, M}, 1).transpose();
+            CHECK(equal(F::quantized_matmul(at, qa, b, qb), naive_qmatmul(at, qa.zero_point, b, qb.zero_point)));
+
+            // Batched with shared weights
+            Tensor<uint8> batch = bytes({3, M, K}, 4);
+            Tensor<int32> r = F::quantized_matmul(batch, qa, b, qb);
+            for (int i = 0; i < 3; i++) CHECK(equal(r[i], naive_qmatmul(batch[i], qa.zero_point, b, qb.zero_point)));
+        }
+    });
+
+    // The largest K sums the most extreme products without overflow
+    const int K = cpu::QGEMM_MAX_K;
+    Tensor<uint8> high = Tensor<uint8>::full({1, K}, 255.0), low = Tensor<uint8>::zeros({K, 1});
+    Tensor<int32> extreme = F::quantized_matmul(high, QuantParams{1.0f, 0}, low, QuantParams{1.0f, 255});
+    CHECK(extreme.data[0] == static_cast<int32>(-65025LL * K));
+    CHECK_THROWS(F::quantized_matmul(Tensor<uint8>::zeros({1, K + 1}), QuantParams{}, Tensor<uint8>::zeros({K + 1, 1}),
+                                     QuantParams{}), std::invalid_argument);
+}
+
+void test_quantized_params_and_requantize() {
+    Tensor<uint8> a = bytes({2, 3}, 1), b = bytes({3, 2}, 2);
+    const double inf = std::numeric_limits<double>::infinity();
+    for (double scale : {0.0, -1.0, inf, std::nan("")}) {
+        QuantParams bad{static_cast<float>(scale), 0};
+        CHECK_THROWS(F::quantized_matmul(a, bad, b, QuantParams{}), std::invalid_argument);
+        CHECK_THROWS(F::quantized_matmul(a, QuantParams{}, b, QuantParams{}, bad), std::invalid_argument);
+    }
+    for (int32 zero : {-1, 256}) {
+        CHECK_THROWS(F::quantized_matmul(a, QuantParams{}, b, QuantParams{1.0f, zero}), std::invalid_argument);
+    }
+
+    // Rounded half to even, then shifted and saturated
+    std::vector<int32> acc = {-1000, -3, 0, 5, 7, 1000};
+    std::vector<uint8> out(acc.size());
+    cpu::requantize(acc.data(), acc.size(), 0.5f, 10, out.data());
+    CHECK((out == std::vector<uint8>{0, 8, 10, 12, 14, 255}));
+
+    // Through quantized_matmul with output parameters
+    const QuantParams qa{0.1f, 100}, qb{0.05f, 20}, q_out{0.25f, 128};
+    Tensor<uint8> x = bytes({5, 40}, 3), w = bytes({40, 6}, 4);
+    Tensor<int32> exact = F::quantized_matmul(x, qa, w, qb);
+    Tensor<uint8> requantized = F::quantized_matmul(x, qa, w, qb, q_out);
+    float multiplier = static_cast<float>(static_cast<double>(qa.scale) * qb.scale / q_out.scale);
+    bool matches = true;
+    for (size_t i = 0; i < exact.numel; i++) {
+        float value = std::nearbyint(static_cast<float>(exact.data[i]) * multiplier) + 128.0f;
+        matches = matches && requantized.data[i] == static_cast<uint8>(std::min(255.0f, std::max(0.0f, value)));
+    }
+    CHECK(matches);
+}
+
+// ---------------------------------------------------------------- Tensor files
+
+void test_save_load_contiguous() {
+    TempFile file("contiguous.ct");
+    Tensor<float32> a = arange<float32>({3, 4}, -2.0, 0.5);
+    Tensor<int32> b = arange<int32>({5}, 7.0);
+    Tensor<uint8> c = arange<uint8>({2, 2, 2});
+    io::save(file.path, {{"a", a}, {"b", b}, {"c", c}});
+
+    std::map<std::string, io::AnyTensor> loaded = io::load(file.path);
+    CHECK(loaded.size() == 3);
+    CHECK(equal(loaded.at("a").as<float32>(), a));
+    CHECK(equal(loaded.at("b").as<int32>(), b));
+    CHECK(equal(loaded.at("c").as<uint8>(), c));
+    CHECK_THROWS(loaded.at("a").as<int32>(), std::invalid_argument);
+}
+
+void test_save_load_strided() {
+    TempFile file("strided.ct");
+    Tensor<float32> base = arange<float32>({4, 6});
+    Tensor<float32> transposed = base.transpose(0, 1);   // Dense, stored with its strides
+    Tensor<float32> columns = base.narrow(1, 1, 3);      // Not dense, stored contiguous
+    Tensor<float32> stepped = base.slice(0, 0, 4, 2);
+    io::save(file.path, {{"transposed", transposed}, {"columns", columns}, {"stepped", stepped}});
+
+    std::map<std::string, io::AnyTensor> loaded = io::load(file.path);
+    Tensor<float32> t = loaded.at("transposed").as<float32>();
+    CHECK(equal(t, transposed));
+    CHECK(utils::shapes_equal(t.strides, transposed.strides));
+    CHECK(equal(loaded.at("columns").as<float32>(), columns));
+    CHECK(equal(loaded.at("stepped").as<float32>(), stepped));
+}
+
+void test_save_load_broadcast() {
+    TempFile file("broadcast.ct");
+    Tensor<int32> row = arange<int32>({1, 5}, 3.0);
+    Tensor<int32> expanded = row.expand({4, 5});
+    io::save(file.path, {{"expanded", expanded}});
+
+    Tensor<int32> loaded = io::load(file.path).at("expanded").as<int32>();
+    CHECK(equal(loaded, expanded));
+    CHECK(!loaded.has_broadcast);
+    // Writes to the loaded copy don't reach the other rows
+    loaded.data[0] = -1;
+    CHECK(loaded.contiguous().data[5] == 3);
+}
+
+void test_save_load_empty_and_scalar() {
+    TempFile file("empty.ct");
+    Tensor<float32> empty = Tensor<float32>::zeros({0, 3});
+    Tensor<float32> scalar = Tensor<float32>::full({}, 2.5);
+    Tensor<int32> scalar_int = Tensor<int32>::full({}, -7);
+    io::save(file.path, {{"empty", empty}, {"scalar", scalar}, {"scalar_int", scalar_int}});
+
+    std::map<std::string, io::AnyTensor> loaded = io::load(file.path);
+    Tensor<float32> e = loaded.at("empty").as<float32>();
+    CHECK(utils::shapes_equal(e.shape, Dims{0, 3}));
+    CHECK(e.numel == 0);
+    Tensor<float32> s = loaded.at("scalar").as<float32>();
+    CHECK(s.ndim == 0 && s.numel == 1 && s.data[0] == 2.5f);
+    CHECK(loaded.at("scalar_int").as<int32>().data[0] == -7);
+
+    std::map<std::string, io::TensorRecord> header = io::read_header(file.path);
+    CHECK(header.at("empty").nbytes == 0);
+    CHECK(header.at("scalar").nbytes == sizeof(float32));
+}
+
+void test_save_over_loaded_file() {
+    TempFile file("overwrite.ct");
+    Tensor<float32> big = arange<float32>({1000});
+    io::save(file.path, {{"x", big}});
+    Tensor<float32> mapped = io::load(file.path).at("x").as<float32>();
+
+    // Replacing the file, even by a smaller one, leaves the tensors mapped from it intact
+    Tensor<float32> small = arange<float32>({2}, 7.0);
+    io::save(file.path, {{"x", small}});
+    CHECK(equal(mapped, big));
+    CHECK(equal(io::load(file.path).at("x").as<float32>(), small));
+    CHECK(!std::filesystem::exists(file.path + ".tmp"));
+
+    // Saving tensors loaded from the file back over it
+    std::map<std::string, io::AnyTensor> loaded = io::load(file.path);
+    loaded["y"] = big;
+    io::save(file.path, loaded);
+    std::map<std::string, io::AnyTensor> reloaded = io::load(file.path);
+    CHECK(equal(reloaded.at("x").as<float32>(), small));
+    CHECK(equal(reloaded.at("y").as<float32>(), big));
+}
+
+void test_load_rejects_corrupt_files() {
+    TempFile file("corrupt.ct");
+    {
+        std::ofstream out(file.path, std::ios::binary);
+        out << "not a tensor file";
+    }
+    CHECK_THROWS(io::load(file.path), std::runtime_error);
+    CHECK_THROWS(io::load(file.path + ".missing"), std::runtime_error);
+
+    // A record whose span overflows: shape [2^30 + 1, 2^30 + 1, 2] with strides INT32_MAX spans
+    // 2^62 float32 elements, 2^64 bytes, which wraps around to 0 in size_t
+    io::save(file.path, {{"x", Tensor<float32>::ones({1, 1, 1})}});
+    std::string bytes;
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t shape_offset = 8 + 4 + 4 + 8 + 4 + 1 + 4 + 4;  // Prefix, name "x", dtype, ndim
+    const int64_t layout[6] = {(int64_t(1) << 30) + 1, (int64_t(1) << 30) + 1, 2, INT32_MAX, INT32_MAX, INT32_MAX};
+    std::memcpy(&bytes[shape_offset], layout, sizeof(layout));
+    {
+        std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+    }
+    CHECK_THROWS(io::read_header(file.path), std::runtime_error);
+    CHECK_THROWS(io::load(file.path), std::runtime_error);
+}
+
+// ---------------------------------------------------------------- Streamed ops
+
+// Small enough for every streamed op below to run over several blocks, the last one partial
+const size_t SMALL_CHUNK_BYTES = 64;
+
+void test_stream_elementwise() {
+    TempFile a_file("stream_a.ct"), b_file("stream_b.ct"), out_file("stream_out.ct");
+    Tensor<int32> a = arange<int32>({13, 5}, -20.0);
+    Tensor<int32> b = arange<int32>({13, 5}, 3.0, 2.0);
+    io::save(a_file.path, {{"a", a}});
+    io::save(b_file.path, {{"b", b}});
+
+    streaming::FileTensor fa = streaming::FileTensor::open(a_file.path, "a");
+    streaming::FileTensor fb = streaming::FileTensor::open(b_file.path, "b");
+    streaming::FileTensor out = streaming::FileTensor::create(out_file.path, "out", DataType::INT32, {13, 5});
+    streaming::add<int32>(fa, fb, out, SMALL_CHUNK_BYTES);
+    CHECK(equal(io::load(out_file.path).at("out").as<int32>(), a + b));
+    streaming::mul<int32>(fa, fb, out, SMALL_CHUNK_BYTES);
+    CHECK(equal(io::load(out_file.path).at("out").as<int32>(), a * b));
+
+    CHECK_THROWS(streaming::add<float32>(fa, fb, out), std::invalid_argument);
+    streaming::FileTensor other = streaming::FileTensor::create(out_file.path + "2", "out", DataType::INT32, {13, 4});
+    CHECK_THROWS(streaming::add<int32>(fa, fb, other), std::invalid_argument);
+    std::filesystem::remove(out_file.path + "2");
+}
+
+void test_stream_for_each_chunk() {
+    TempFile in_file("chunks_in.ct"), out_file("chunks_out.ct");
+    Tensor<int32> a = arange<int32>({10, 3});
+    io::save(in_file.path, {{"a", a}});
+    streaming::FileTensor fa = streaming::FileTensor::open(in_file.path, "a");
+    streaming::FileTensor out = streaming::FileTensor::create(out_file.path, "out", DataType::INT32, {10, 3});
+
+    // Blocks of 3, 3, 3 and 1 rows in order, then a single block, each doubled into out
+    for (size_t rows : {size_t(3), size_t(10)}) {
+        std::vector<size_t> begins;
+        streaming::for_each_chunk({&fa}, &out, rows, [&](size_t begin, size_t count, const std::vector<const void*>& inputs, void* output) {
+            begins.push_back(begin);
+            const int32* src = static_cast<const int32*>(inputs[0]);
+            for (size_t i = 0; i < count * 3; i++) static_cast<int32*>(output)[i] = 2 * src[i];
+        });
+        CHECK(begins == (rows == 3 ? std::vector<size_t>{0, 3, 6, 9} : std::vector<size_t>{0}));
+        CHECK(equal(io::load(out_file.path).at("out").as<int32>(), a * 2.0));
+    }
+
+    // An exception of compute reaches the caller once the pending I/O is done
+    CHECK_THROWS(streaming::for_each_chunk({&fa}, &out, 3, [](size_t begin, size_t, const std::vector<const void*>&, void*) {
+        if (begin == 6) throw std::runtime_error("compute failed");
+    }), std::runtime_error);
+    CHECK_THROWS(streaming::for_each_chunk({&fa}, &out, 0, [](size_t, size_t, const std::vector<const void*>&, void*) {}),
+                 std::invalid_argument);
+}
+
+void test_stream_out_aliasing_input() {
+    TempFile a_file("alias_a.ct"), b_file("alias_b.ct");
+    Tensor<int32> a = arange<int32>({11, 3}, 1.0);
+    Tensor<int32> b = arange<int32>({11, 3}, 100.0, -3.0);
+    io::save(a_file.path, {{"a", a}});
+    io::save(b_file.path, {{"b", b}});
+
+    // out is the first operand itself: each block is read before it is overwritten
+    streaming::FileTensor fa = streaming::FileTensor::open(a_file.path, "a");
+    streaming::FileTensor fb = streaming::FileTensor::open(b_file.path, "b");
+    streaming::add<int32>(fa, fb, fa, SMALL_CHUNK_BYTES);
+    Tensor<int32> expected = a + b;
+    CHECK(equal(io::load(a_file.path).at("a").as<int32>(), expected));
+
+    // out opened separately on the same tensor as the second operand
+    streaming::FileTensor fb_out = streaming::FileTensor::open(b_file.path, "b");
+    streaming::mul<int32>(fa, fb, fb_out, SMALL_CHUNK_BYTES);
+    CHECK(equal(io::load(b_file.path).at("b").as<int32>(), expected * b));
+
+    // Square matmul written over its own left operand
+    TempFile m_file("alias_m.ct");
+    Tensor<float32> m = arange<float32>({9, 4}, -5.0);
+    Tensor<float32> w = arange<float32>({4, 4}, 1.0, 0.5);
+    io::save(m_file.path, {{"m", m}});
+    streaming::FileTensor fm = streaming::FileTensor::open(m_file.path, "m");
+    streaming::matmul<float32>(fm, w, fm, SMALL_CHUNK_BYTES);
+    CHECK(equal(io::load(m_file.path).at("m").as<float32>(), Tensor<float32>::matmul(m, w)));
+}
+
+void test_stream_matmul() {
+    TempFile a_file("matmul_a.ct"), out_file("matmul_out.ct");
+    Tensor<float32> a = arange<float32>({17, 6}, -8.0, 0.5);
+    Tensor<float32> b = arange<float32>({6, 5}, 2.0, -0.25);
+    io::save(a_file.path, {{"a", a}});
+
+    streaming::FileTensor fa = streaming::FileTensor::open(a_file.path, "a");
+    streaming::FileTensor out = streaming::FileTensor::create(out_file.path, "out", DataType::FLOAT32, {17, 5});
+    // A transposed (non-contiguous) in-memory operand
+    Tensor<float32> b_t = arange<float32>({5, 6}, 2.0, -0.25).transpose(0, 1);
+    streaming::matmul<float32>(fa, b_t, out, SMALL_CHUNK_BYTES);
+    CHECK(equal(io::load(out_file.path).at("out").as<float32>(), Tensor<float32>::matmul(a, b_t)));
+    streaming::matmul<float32>(fa, b, out, SMALL_CHUNK_BYTES);
+    CHECK(equal(io::load(out_file.path).at("out").as<float32>(), Tensor<float32>::matmul(a, b)));
+
+    CHECK_THROWS(streaming::matmul<float32>(fa, b.transpose(0, 1), out), std::invalid_argument);
+}
+
+void test_stream_reductions() {
+    TempFile file("reduce.ct");
+    Tensor<int32> values = arange<int32>({15, 7}, -50.0);
+    Tensor<uint8> bytes = arange<uint8>({21, 9}, 0.0, 1.0);
+    io::save(file.path, {{"values", values}, {"bytes", bytes}});
+
+    streaming::FileTensor fv = streaming::FileTensor::open(file.path, "values");
+    CHECK(streaming::sum<int32>(fv, SMALL_CHUNK_BYTES).data[0] == F::sum(values).data[0]);
+    CHECK(streaming::max<int32>(fv, SMALL_CHUNK_BYTES).data[0] == 54);
+    CHECK(streaming::min<int32>(fv, SMALL_CHUNK_BYTES).data[0] == -50);
+    CHECK(streaming::mean<int32>(fv, SMALL_CHUNK_BYTES).data[0] == F::mean(values).data[0]);
+    CHECK(streaming::sum<int32>(fv).data[0] == F::sum(values).data[0]);
+
+    // uint8 sums accumulate in int32, past what a block of uint8 holds
+    streaming::FileTensor fb = streaming::FileTensor::open(file.path, "bytes");
+    Tensor<int32> total = streaming::sum<uint8>(fb, SMALL_CHUNK_BYTES);
+    CHECK(total.data[0] == F::sum(bytes).data[0]);
+    CHECK(streaming::max<uint8>(fb, SMALL_CHUNK_BYTES).data[0] == 188);
+}
+
+// ---------------------------------------------------------------- Lazy expressions
+
+void test_expr_fused_evaluation() {
+    Tensor<float32> a = arange<float32>({4, 5}, -3.0, 0.5);
+    Tensor<float32> b = arange<float32>({5}, 1.0, 2.0);
+    Tensor<float32> c = arange<float32>({4, 1}, 7.0, -1.5);
+    Tensor<float32> eager = a * 1.5 + b * c + -2.0;
+    Tensor<float32> fused = expr::lazy(a) * 1.5 + expr::lazy(b) * c + -2.0;
+    CHECK(equal(fused, eager));
+
+    // The forms bound as fma, on strided operands
+    Tensor<float32> at = arange<float32>({5, 4}, 1.0, 0.25).transpose();
+    CHECK(equal((expr::lazy(at) * a + c).eval(), at * a + c));
+    CHECK(equal((expr::lazy(at) * a + 3.0).eval(), at * a + 3.0));
+    CHECK(equal((expr::lazy(at) * -0.5 + a).eval(), at * -0.5 + a));
+    CHECK(equal((expr::lazy(at) * -0.5 + 3.0).eval(), at * -0.5 + 3.0));
+
+    // Integer wraparound matches the eager ops
+    Tensor<uint8> u = arange<uint8>({3, 3}, 250.0);
+    CHECK(equal((expr::lazy(u) * 2.0 + u).eval(), u * 2.0 + u));
+
+    // Into a strided out, and rejected for wrong or broadcast outs
+    Tensor<float32> out = Tensor<float32>::zeros({5, 4});
+    expr::assign(out.transpose(), expr::lazy(a) * 2.0 + b);
+    CHECK(equal(out.transpose(), a * 2.0 + b));
+    CHECK_THROWS(expr::assign(Tensor<float32>::empty({4, 4}), expr::lazy(a) * 2.0), std::runtime_error);
+    CHECK_THROWS(expr::assign(b.expand({4, 5}), expr::lazy(a) * 2.0), std::invalid_argument);
+}
+
+void test_expr_assign_aliased() {
+    // In place when out is read in the same places
+    Tensor<float32> x = arange<float32>({3, 3});
+    Tensor<float32> y = arange<float32>({3}, 10.0);
+    expr::assign(x, expr::lazy(x) * 2.0 + y);
+    CHECK(equal(x, arange<float32>({3, 3}) * 2.0 + y));
+
+    // Through a temporary for a transposed or shifted view of out
+    Tensor<float32> t = arange<float32>({3, 3});
+    Tensor<float32> expected = arange<float32>({3, 3}) + arange<float32>({3, 3}).transpose() * 2.0;
+    expr::assign(t, expr::lazy(t) + expr::lazy(t.transpose()) * 2.0);
+    CHECK(equal(t, expected));
+
+    Tensor<int32> s = arange<int32>({6});
+    expr::assign(s.narrow(0, 1, 5), expr::lazy(s.narrow(0, 0, 5)) + s.narrow(0, 1, 5));
+    CHECK(equal(s, values<int32>({6}, {0, 1, 3, 5, 7, 9})));
+}
+
+// ---------------------------------------------------------------- out= variants
+
+void test_out_aliasing_transpose() {
+    Tensor<float32> a = arange<float32>({3, 3});
+    Tensor<float32> expected = Tensor<float32>::empty({3, 3});
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) expected.data[i * 3 + j] = static_cast<float32>((i * 3 + j) + (j * 3 + i));
+    }
+    F::add(a, a.transpose(), a);
+    CHECK(equal(a, expected));
+
+    Tensor<float32> b = arange<float32>({3, 3});
+    b += b.transpose();
+    CHECK(equal(b, expected));
+
+    // The scalar forms, writing the transpose of the operand
+    Tensor<float32> c = arange<float32>({3, 3});
+    F::mul(c, 2.0, c.transpose());
+    CHECK(equal(c, arange<float32>({3, 3}, 0.0, 2.0).transpose()));
+
+    // The copy out of the temporary is replayed by graphs
+    auto symmetrize = [](const std::vector<Tensor<float32>>& in) {
+        Tensor<float32> y = in[0] * 1.0;
+        F::add(y, y.transpose(), y);
+        return std::vector<Tensor<float32>>{y};
+    };
+    graph::Graph<float32> g = graph::Graph<float32>::capture(symmetrize, {arange<float32>({3, 3}, 5.0)});
+    CHECK(equal(g.run({arange<float32>({3, 3})})[0], expected));
+}
+
+void test_out_aliasing_shifted_view() {
+    // Each element is the sum of the previous two of the original, not a running sum
+    Tensor<float32> c = arange<float32>({6});
+    F::add(c.narrow(0, 1, 5), c.narrow(0, 0, 5), c.narrow(0, 1, 5));
+    CHECK(equal(c, values<float32>({6}, {0, 1, 3, 5, 7, 9})));
+
+    Tensor<int32> d = arange<int32>({6});
+    F::mul(d.narrow(0, 0, 5), d.narrow(0, 1, 5), d.narrow(0, 1, 5));
+    CHECK(equal(d, values<int32>({6}, {0, 0, 2, 6, 12, 20})));
+
+    // Broadcasting a row of out over out
+    Tensor<float32> e = arange<float32>({2, 3});
+    e += e[0];
+    CHECK(equal(e, values<float32>({2, 3}, {0, 2, 4, 3, 5, 7})));
+
+    // Writing in the same places as an operand needs no temporary
+    Tensor<float32> f = arange<float32>({4, 4});
+    Tensor<float32> g = f.transpose();
+    F::add(g, g, g);
+    CHECK(equal(f, arange<float32>({4, 4}, 0.0, 2.0)));
+}
+
+// ---------------------------------------------------------------- Graph capture and replay
+
+using Tensors = std::vector<Tensor<float32>>;
+
+void test_graph_replay() {
+    Tensor<float32> w = arange<float32>({8, 4}, -1.0, 0.25);
+    Tensor<float32> bias = arange<float32>({4}, 1.0);
+    auto model = [&](const Tensors& in) {
+        Tensor<float32> h = Tensor<float32>::matmul(in[0], w) + bias;
+        return Tensors{h * in[1], h * 0.5};
+    };
+
+    Tensor<float32> x = arange<float32>({3, 8}, 0.0, 0.5);
+    Tensor<float32> scale = arange<float32>({3, 1}, 2.0);
+    graph::Graph<float32> g = graph::Graph<float32>::capture(model, {x, scale});
+    CHECK(g.num_ops() == 4);
+
+    // New inputs of the captured shapes give the eager results
+    Tensor<float32> x2 = arange<float32>({3, 8}, -3.0, 0.25);
+    Tensor<float32> scale2 = arange<float32>({3, 1}, -1.0, 2.0);
+    Tensors expected = model({x2, scale2});
+    Tensors outputs = g.run({x2, scale2});
+    CHECK(outputs.size() == 2);
+    CHECK(equal(outputs[0], expected[0]));
+    CHECK(equal(outputs[1], expected[1]));
+
+    // Constants are referenced, so a run reads their current values
+    bias.data[0] = 100.0f;
+    CHECK(equal(g.run({x2, scale2})[1], model({x2, scale2})[1]));
+
+    CHECK_THROWS(g.run({x2}), std::invalid_argument);
+    CHECK_THROWS(g.run({arange<float32>({4, 8}), scale2}), std::invalid_argument);
+    CHECK_THROWS(g.run({x2.transpose(0, 1).contiguous().transpose(0, 1), scale2}), std::invalid_argument);
+}
+
+void test_graph_arena_reuse() {
+    const Dims shape = {32, 32};
+    const size_t buffer_bytes = 32 * 32 * sizeof(float32);
+    auto chain = [](const Tensors& in) {
+        Tensor<float32> y = in[0] + 1.0;
+        y = y * 2.0;
+        y = y + in[0];
+        y = y * 3.0;
+        y = y + 4.0;
+        return Tensors{y};
+    };
+    graph::Graph<float32> g = graph::Graph<float32>::capture(chain, {Tensor<float32>::ones(shape)});
+    CHECK(g.num_ops() == 5);
+    // Five results, but at most two of them are alive at the same time
+    CHECK(g.arena_bytes() >= buffer_bytes);
+    CHECK(g.arena_bytes() <= 2 * buffer_bytes);
+
+    Tensor<float32> x = arange<float32>(shape, -10.0, 0.125);
+    Tensors first = g.run({x});
+    CHECK(equal(first[0], chain({x})[0]));
+
+    // Outputs live in the arena: the next run overwrites them
+    Tensor<float32> kept = first[0] * 1.0;  // A copy
+    Tensor<float32> x2 = arange<float32>(shape, 5.0);
+    Tensors second = g.run({x2});
+    CHECK(equal(second[0], chain({x2})[0]));
+    CHECK(first[0].data.get() == second[0].data.get());
+    CHECK(equal(first[0], second[0]));
+    CHECK(!equal(kept, second[0]));
+}
+
+void test_graph_rejects_unrecorded_allocations() {
+    Tensor<float32> x = arange<float32>({4, 4});
+    // contiguous() of a transposed view allocates a buffer that no recorded op fills
+    auto uses_copy = [](const Tensors& in) { return Tensors{in[0].transpose(0, 1).contiguous() + 1.0}; };
+    CHECK_THROWS(graph::Graph<float32>::capture(uses_copy, {x}), std::invalid_argument);
+    auto returns_factory = [](const Tensors& in) { return Tensors{in[0] + 1.0, Tensor<float32>::ones({4})}; };
+    CHECK_THROWS(graph::Graph<float32>::capture(returns_factory, {x}), std::invalid_argument);
+
+    // A zeros() buffer of which an op writes only a slice would lose its other zeros on replay
+    auto writes_slice = [](const Tensors& in) {
+        Tensor<float32> padded = Tensor<float32>::zeros({6, 4});
+        F::add(in[0], 1.0, padded.narrow(0, 1, 4));
+        return Tensors{padded};
+    };
+    CHECK_THROWS(graph::Graph<float32>::capture(writes_slice, {x}), std::invalid_argument);
+
+    // Created before the capture, the same tensor is a constant
+    Tensor<float32> ones = Tensor<float32>::ones({4, 4});
+    graph::Graph<float32> g = graph::Graph<float32>::capture([&](const Tensors& in) { return Tensors{in[0] + ones}; }, {x});
+    CHECK(equal(g.run({x})[0], x + ones));
+
+    // Captures don't nest
+    {
+        graph::Capture<float32> capture;
+        CHECK_THROWS(graph::Capture<float32>(), std::runtime_error);
+    }
+    CHECK(graph::Capture<float32>::active() == nullptr);
+}
+
+void test_graph_concurrent_runs() {
+    Tensor<float32> w = arange<float32>({16, 16}, -1.0, 0.0625);
+    auto model = [&](const Tensors& in) { return Tensors{Tensor<float32>::matmul(in[0], w) + 1.0}; };
+    graph::Graph<float32> g = graph::Graph<float32>::capture(model, {Tensor<float32>::ones({16, 16})});
+    graph::Graph<float32> copy = g;  // Shares the arena
+
+    // Runs on the graph and its copy wait for each other. Their outputs share the arena and are
+    // overwritten by the other threads, so the results are checked once the threads are done.
+    auto worker = [](graph::Graph<float32>& graph, double start) {
+        Tensor<float32> x = arange<float32>({16, 16}, start, 0.5);
+        for (int i = 0; i < 50; i++) graph.run({x});
+    };
+    std::vector<std::thread> threads;
+    threads.emplace_back(worker, std::ref(g), 0.0);
+    threads.emplace_back(worker, std::ref(copy), 7.0);
+    threads.emplace_back(worker, std::ref(g), -3.0);
+    for (std::thread& thread : threads) thread.join();
+
+    for (double start : {0.0, 7.0, -3.0}) {
+        Tensor<float32> x = arange<float32>({16, 16}, start, 0.5);
+        CHECK(equal(g.run({x})[0], model({x})[0]));
+        CHECK(equal(copy.run({x})[0], model({x})[0]));
+    }
+}
+
+// ---------------------------------------------------------------- Profiler
+
+// Recorded events named name
+std::vector<profiler::Event> events_named(const std::string& name) {
+    std::vector<profiler::Event> named;
+    for (const profiler::Event& e : profiler::events()) {
+        if (e.name == name) named.push_back(e);
+    }
+    return named;
+}
+
+// Minimal JSON grammar check: objects, arrays, strings with escapes, numbers and literals
+bool parse_json_value(const std::string& text, size_t& i);
+
+void skip_json_space(const std::string& text, size_t& i) {
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) i++;
+}
+
+bool parse_json_string(const std::string& text, size_t& i) {
+    if (i >= text.size() || text[i] != '"') return false;
+    for (i++; i < text.size(); i++) {
+        if (text[i] == '\\') {
+            i++;
+        } else if (text[i] == '"') {
+            i++;
+            return true;
+        } else if (static_cast<unsigned char>(text[i]) < 0x20) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool parse_json_sequence(const std::string& text, size_t& i, char close, bool members) {
+    i++;
+    skip_json_space(text, i);
+    if (i < text.size() && text[i] == close) return ++i, true;
+    while (true) {
+        skip_json_space(text, i);
+        if (members) {
+            if (!parse_json_string(text, i)) return false;
+            skip_json_space(text, i);
+            if (i >= text.size() || text[i++] != ':') return false;
+        }
+        if (!parse_json_value(text, i)) return false;
+        skip_json_space(text, i);
+        if (i >= text.size()) return false;
+        if (text[i] == close) return ++i, true;
+        if (text[i++] != ',') return false;
+    }
+}
+
+bool parse_json_value(const std::string& text, size_t& i) {
+    skip_json_space(text, i);
+    if (i >= text.size()) return false;
+    if (text[i] == '{') return parse_json_sequence(text, i, '}', true);
+    if (text[i] == '[') return parse_json_sequence(text, i, ']', false);
+    if (text[i] == '"') return parse_json_string(text, i);
+    for (const char* literal : {"true", "false", "null"}) {
+        if (text.compare(i, std::strlen(literal), literal) == 0) return i += std::strlen(literal), true;
+    }
+    size_t start = i;
+    while (i < text.size() && (std::isdigit(static_cast<unsigned char>(text[i])) || std::strchr("+-.eE", text[i]))) i++;
+    return i > start;
+}
+
+bool json_well_formed(const std::string& text) {
+    size_t i = 0;
+    if (!parse_json_value(text, i)) return false;
+    skip_json_space(text, i);
+    return i == text.size();
+}
+
+void test_profiler_events() {
+    Tensor<float32> a = arange<float32>({8, 16}), b = arange<float32>({8, 16}, 1.0), row = arange<float32>({16});
+    Tensor<float32> w = arange<float32>({16, 4}), out = Tensor<float32>::empty({8, 16}), product = Tensor<float32>::empty({8, 4});
+    profiler::clear();
+
+    // Nothing is recorded while disabled
+    profiler::set_enabled(false);
+    F::add(a, b, out);
+    F::matmul(a, w);
+    a.to<int32>();
+    CHECK(profiler::events().empty());
+
+    profiler::set_enabled(true);
+    F::add(a, b, out);
+    F::mul(a, row, out);
+    F::matmul(a, w, product);
+    std::vector<profiler::Event> events = profiler::events();
+    CHECK(events.size() == 3);
+    if (events.size() == 3) {
+        const profiler::Event& add = events[0];
+        CHECK(add.name == "add" && add.shapes == "[8, 16] [8, 16]" && add.dtype == "float32");
+        CHECK(add.bytes == 3 * 128 * sizeof(float32) && add.flops == 128);
+        const profiler::Event& mul = events[1];
+        CHECK(mul.name == "mul" && mul.shapes == "[8, 16] [16]" && mul.dtype == "float32");
+        CHECK(mul.bytes == (128 + 16 + 128) * sizeof(float32) && mul.flops == 128);
+        const profiler::Event& matmul = events[2];
+        CHECK(matmul.name == "matmul" && matmul.shapes == "[8, 16] [16, 4]" && matmul.dtype == "float32");
+        CHECK(matmul.bytes == (128 + 64 + 32) * sizeof(float32) && matmul.flops == 2 * 16 * 32);
+        for (const profiler::Event& e : events) CHECK(e.start_ns > 0);
+    }
+
+    // A conversion records its own event and the allocation of its result
+    profiler::clear();
+    CHECK(profiler::events().empty());
+    a.to<int32>();
+    a.to<uint8>(0.5f, 1.0f);
+    std::vector<profiler::Event> conversions = events_named("to");
+    CHECK(conversions.size() == 2);
+    if (conversions.size() == 2) {
+        CHECK(conversions[0].shapes == "[8, 16]" && conversions[0].dtype == "float32->int32");
+        CHECK(conversions[0].bytes == 128 * (sizeof(float32) + sizeof(int32)) && conversions[0].flops == 0);
+        CHECK(conversions[1].dtype == "float32->uint8" && conversions[1].flops == 2 * 128);
+    }
+    CHECK(events_named("allocate").size() == 2);
+
+    profiler::clear();
+    Tensor<uint8>::empty({3, 5});
+    events = profiler::events();
+    CHECK(events.size() == 1);
+    if (events.size() == 1) {
+        CHECK(events[0].name == "allocate" && events[0].shapes.empty() && events[0].dtype.empty());
+        CHECK(events[0].bytes == 15 && events[0].flops == 0);
+    }
+
+    profiler::set_enabled(false);
+    profiler::clear();
+}
+
+void test_profiler_summary_and_trace() {
+    Tensor<float32> a = arange<float32>({8, 16}), w = arange<float32>({16, 4});
+    Tensor<float32> out = Tensor<float32>::empty({8, 16}), product = Tensor<float32>::empty({8, 4});
+    Tensor<int32> x = arange<int32>({5}), y = Tensor<int32>::empty({5});
+    profiler::clear();
+    profiler::set_enabled(true);
+    F::add(a, a, out);
+    F::add(out, a, out);
+    F::add(x, x, y);
+    F::matmul(a, w, product);
+    profiler::set_enabled(false);
+
+    // One row per op and dtype after the header, with its call count
+    std::map<std::string, std::string> calls;
+    std::istringstream lines(profiler::summary());
+    std::string line;
+    std::getline(lines, line);
+    CHECK(line.rfind("op", 0) == 0);
+    int rows = 0;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string op, dtype, count;
+        fields >> op >> dtype >> count;
+        calls[op + "/" + dtype] = count;
+        rows++;
+    }
+    CHECK(rows == 3);
+    CHECK(calls == (std::map<std::string, std::string>{{"add/float32", "2"}, {"add/int32", "1"}, {"matmul/float32", "1"}}));
+
+    // Chrome trace: a traceEvents list of complete ("X") events, one per recorded event
+    TempFile file("trace.json");
+    profiler::export_chrome_trace(file.path);
+    std::string text;
+    {
+        std::ifstream in(file.path);
+        text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    CHECK(json_well_formed(text));
+    CHECK(text.find("{\"traceEvents\": [") == 0);
+    size_t complete = 0;
+    for (size_t at = text.find("\"ph\": \"X\""); at != std::string::npos; at = text.find("\"ph\": \"X\"", at + 1)) complete++;
+    CHECK(complete == 4);
+    CHECK(text.find("\"name\": \"matmul\"") != std::string::npos);
+    CHECK(text.find("\"flops\": 1024") != std::string::npos);
+
+    // Cleared, the profiler exports an empty but valid trace
+    profiler::clear();
+    CHECK(profiler::events().empty());
+    profiler::export_chrome_trace(file.path);
+    {
+        std::ifstream in(file.path);
+        text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    CHECK(json_well_formed(text) && text.find("\"ph\"") == std::string::npos);
+}
+
+struct Test {
+    const char* name;
+    std::function<void()> run;
+};
+
+const std::vector<Test> tests = {
+    {"elementwise_kernels", test_elementwise_kernels},
+    {"scalar_ops", test_scalar_ops},
+    {"allocator_alignment", test_allocator_alignment},
+    {"allocator_reuse_and_stats", test_allocator_reuse_and_stats},
+    {"allocator_empty_cache_reaches_workers", test_allocator_empty_cache_reaches_workers},
+    {"allocator_cache_limit", test_allocator_cache_limit},
+    {"allocator_thread_cache_disabled", test_allocator_thread_cache_disabled},
+    {"set_allocator_with_live_buffers", test_set_allocator_with_live_buffers},
+    {"reductions_over_dims", test_reductions_over_dims},
+    {"argmax_and_nan", test_argmax_and_nan},
+    {"reductions_of_empty", test_reductions_of_empty},
+    {"transpose_copies", test_transpose_copies},
+    {"permute", test_permute},
+    {"slicing_views", test_slicing_views},
+    {"small_vector_growth", test_small_vector_growth},
+    {"many_dims", test_many_dims},
+    {"parallel_for", test_parallel_for},
+    {"concurrent_ops", test_concurrent_ops},
+    {"matmul_gemm", test_matmul_gemm},
+    {"matmul_batched", test_matmul_batched},
+    {"matmul_small_kernels", test_matmul_small_kernels},
+    {"matmul_empty", test_matmul_empty},
+    {"half_round_trips", test_half_round_trips},
+    {"half_matmul", test_half_matmul},
+    {"conversion_saturation", test_conversion_saturation},
+    {"conversion_between_integers", test_conversion_between_integers},
+    {"quantized_matmul_exact", test_quantized_matmul_exact},
+    {"quantized_params_and_requantize", test_quantized_params_and_requantize},
+    {"save_load_contiguous", test_save_load_contiguous},
+    {"save_load_strided", test_save_load_strided},
+    {"save_load_broadcast", test_save_load_broadcast},
+    {"save_load_empty_and_scalar", test_save_load_empty_and_scalar},
+    {"save_over_loaded_file", test_save_over_loaded_file},
+    {"load_rejects_corrupt_files", test_load_rejects_corrupt_files},
+    {"stream_elementwise", test_stream_elementwise},
+    {"stream_for_each_chunk", test_stream_for_each_chunk},
+    {"stream_out_aliasing_input", test_stream_out_aliasing_input},
+    {"stream_matmul", test_stream_matmul},
+    {"stream_reductions", test_stream_reductions},
+    {"expr_fused_evaluation", test_expr_fused_evaluation},
+    {"expr_assign_aliased", test_expr_assign_aliased},
+    {"out_aliasing_transpose", test_out_aliasing_transpose},
+    {"out_aliasing_shifted_view", test_out_aliasing_shifted_view},
+    {"graph_replay", test_graph_replay},
+    {"graph_arena_reuse", test_graph_arena_reuse},
+    {"graph_rejects_unrecorded_allocations", test_graph_rejects_unrecorded_allocations},
+    {"graph_concurrent_runs", test_graph_concurrent_runs},
+    {"profiler_events", test_profiler_events},
+    {"profiler_summary_and_trace", test_profiler_summary_and_trace},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter TEXT]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "SIMD level " << cpu::simd_level_to_str(cpu::simd_level()) << "\n";
+    int run = 0;
+    for (const Test& test : tests) {
+        if (std::string(test.name).find(filter) == std::string::npos) continue;
+        int before = failures;
+        try {
+            test.run();
+        } catch (const std::exception& e) {
+            std::cerr << "  unexpected exception: " << e.what() << "\n";
+            failures++;
+        }
+        std::cout << (failures == before ? "ok     " : "FAILED ") << test.name << "\n";
+        run++;
+    }
+    std::cout << run << " tests, " << failures << " failed checks\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}